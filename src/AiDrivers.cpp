@@ -0,0 +1,194 @@
+#include "AiDrivers.h"
+#include "TrackLayout.h"
+#include "VehicleRegistry.h"
+
+#include <Jolt/Math/Float4.h>
+#include <Jolt/Physics/Body/BodyInterface.h>
+#include <Jolt/Physics/PhysicsSystem.h>
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+
+using namespace JPH;
+
+namespace {
+
+// Bumper-to-bumper allowance subtracted from the centre distance to a leader.
+constexpr float VehicleLength = 5.f;
+// Bounds the leader search when many vehicles bunch up in one spot.
+constexpr size_t MaxScan = 48;
+
+Vec4 load(const std::vector<float>& values, size_t i) {
+    return Vec4::sLoadFloat4(reinterpret_cast<const Float4*>(values.data() + i));
+}
+
+void store(Vec4Arg value, std::vector<float>& values, size_t i) {
+    value.StoreFloat4(reinterpret_cast<Float4*>(values.data() + i));
+}
+
+} // namespace
+
+AiDrivers::AiDrivers(PhysicsWorld& world)
+    : world_(world) {}
+
+void AiDrivers::resize(size_t count) {
+    const size_t padded = (count + 3) & ~size_t(3);
+    for (auto* values : {&x_, &z_, &forwardX_, &forwardZ_, &speed_, &maxSpeed_, &angle_, &radius_, &laneRadius_, &speedCap_,
+                         &throttle_, &steer_, &brake_}) {
+        values->resize(padded);
+    }
+    for (size_t i = count; i < padded; ++i) {
+        x_[i] = Track::CenterLine;
+        z_[i] = 0.f;
+        forwardX_[i] = 0.f;
+        forwardZ_[i] = 1.f;
+        speed_[i] = 0.f;
+        maxSpeed_[i] = 0.f;
+        laneRadius_[i] = Track::CenterLine;
+        speedCap_[i] = 0.f;
+    }
+}
+
+void AiDrivers::update(const VehicleRegistry& vehicles, std::span<VehicleInput> inputs, float centerX, float centerZ) {
+    const auto start = std::chrono::steady_clock::now();
+    const size_t count = std::min(vehicles.size(), inputs.size());
+    resize(count);
+    stats_.drivers = count;
+
+    // Between steps nothing else writes bodies, so the lock-free interface is safe.
+    const BodyInterface& bodies = world_.system().GetBodyInterfaceNoLock();
+    for (size_t i = 0; i < count; ++i) {
+        PhysicsVehicle& vehicle = vehicles[i];
+        RVec3 position;
+        Quat rotation;
+        bodies.GetPositionAndRotation(vehicle.bodyId(), position, rotation);
+        const Vec3 forward = rotation * Vec3::sAxisZ();
+        x_[i] = static_cast<float>(position.GetX()) - centerX;
+        z_[i] = static_cast<float>(position.GetZ()) - centerZ;
+        forwardX_[i] = forward.GetX();
+        forwardZ_[i] = forward.GetZ();
+        speed_[i] = bodies.GetLinearVelocity(vehicle.bodyId()).Dot(forward);
+        maxSpeed_[i] = vehicle.settings().maxSpeed;
+    }
+    const size_t padded = x_.size();
+    for (size_t i = 0; i < padded; i += 4) {
+        const Vec4 x = load(x_, i);
+        const Vec4 z = load(z_, i);
+        store(Vec4::sATan2(z, x), angle_, i);
+        store((x * x + z * z).Sqrt(), radius_, i);
+    }
+    const auto gathered = std::chrono::steady_clock::now();
+
+    findLeaders(count);
+
+    const Vec4 one = Vec4::sReplicate(1.f);
+    const Vec4 zero = Vec4::sZero();
+    const Vec4 half = Vec4::sReplicate(0.5f);
+    const Vec4 two = Vec4::sReplicate(2.f);
+    const Vec4 minLookAhead = Vec4::sReplicate(8.f);
+    const Vec4 lookAheadTime = Vec4::sReplicate(1.2f);
+    const Vec4 targetSpeed = Vec4::sReplicate(config_.targetSpeed);
+    for (size_t i = 0; i < padded; i += 4) {
+        const Vec4 x = load(x_, i);
+        const Vec4 z = load(z_, i);
+        const Vec4 forwardX = load(forwardX_, i);
+        const Vec4 forwardZ = load(forwardZ_, i);
+        const Vec4 speed = load(speed_, i);
+        const Vec4 lane = load(laneRadius_, i);
+
+        // Pure pursuit towards a point on the lane circle, like Track::followRacingLine.
+        // Target and position are both centre-relative, so the offset cancels here.
+        const Vec4 lookAhead = Vec4::sMax(minLookAhead, speed.Abs() * lookAheadTime);
+        Vec4 sin, cos;
+        (load(angle_, i) + lookAhead / lane).SinCos(sin, cos);
+        const Vec4 toTargetX = lane * cos - x;
+        const Vec4 toTargetZ = lane * sin - z;
+        // Facing +Z with +Y up, the right-hand side is -X: right = (-forwardZ, forwardX).
+        const Vec4 localForward = toTargetX * forwardX + toTargetZ * forwardZ;
+        const Vec4 localRight = toTargetZ * forwardX - toTargetX * forwardZ;
+        const Vec4 heading = Vec4::sATan2(localRight, localForward);
+
+        const Vec4 steer = Vec4::sMin(one, Vec4::sMax(-one, heading * two));
+        const Vec4 cornerSpeed = Vec4::sMin(targetSpeed, load(maxSpeed_, i)) * (one - half * Vec4::sMin(one, heading.Abs()));
+        const Vec4 target = Vec4::sMin(cornerSpeed, load(speedCap_, i));
+
+        store(steer, steer_, i);
+        store(Vec4::sSelect(zero, one, Vec4::sLess(speed, target)), throttle_, i);
+        store(Vec4::sSelect(zero, one, Vec4::sGreater(speed, target + two)), brake_, i);
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        VehicleInput& input = inputs[i];
+        input.throttle = throttle_[i];
+        input.steer = steer_[i];
+        input.brake = brake_[i] > 0.5f;
+        input.handbrake = false;
+    }
+
+    const auto end = std::chrono::steady_clock::now();
+    stats_.gatherMs = std::chrono::duration<float, std::milli>(gathered - start).count();
+    stats_.solveMs = std::chrono::duration<float, std::milli>(end - gathered).count();
+}
+
+void AiDrivers::findLeaders(size_t count) {
+    stats_.following = 0;
+    if (count == 0) return;
+
+    // Counting sort by angle around the track; laps run with increasing angle,
+    // so the vehicles ahead follow in sorted order.
+    const size_t buckets = std::clamp<size_t>(std::bit_ceil(count / 2 + 1), 16, 8192);
+    const float toBucket = static_cast<float>(buckets) / (2.f * JPH_PI);
+    bucketStart_.assign(buckets + 1, 0);
+    order_.resize(count);
+    auto bucketOf = [&](size_t i) {
+        return std::min(buckets - 1, static_cast<size_t>(std::max(0.f, (angle_[i] + JPH_PI) * toBucket)));
+    };
+    for (size_t i = 0; i < count; ++i) {
+        ++bucketStart_[bucketOf(i) + 1];
+    }
+    for (size_t b = 0; b < buckets; ++b) {
+        bucketStart_[b + 1] += bucketStart_[b];
+    }
+    for (size_t i = 0; i < count; ++i) {
+        order_[bucketStart_[bucketOf(i)]++] = static_cast<uint32_t>(i);
+    }
+
+    const float innerLane = Track::Inner + config_.edgeMargin;
+    const float outerLane = Track::Outer - config_.edgeMargin;
+    for (size_t p = 0; p < count; ++p) {
+        const uint32_t i = order_[p];
+        const float radius = radius_[i];
+        float lane = std::clamp(radius, innerLane, outerLane);
+        float cap = config_.targetSpeed;
+
+        const size_t scan = std::min(count - 1, MaxScan);
+        for (size_t k = 1; k <= scan; ++k) {
+            const size_t q = p + k;
+            const uint32_t j = order_[q % count];
+            float delta = angle_[j] - angle_[i];
+            if (q >= count) {
+                delta += 2.f * JPH_PI;
+            } else if (delta < 0.f) {
+                // Same bucket, slightly behind.
+                continue;
+            }
+            const float distance = delta * std::max(radius, 1.f);
+            if (distance > config_.scanDistance) break;
+            if (std::abs(radius_[j] - radius) > config_.laneHalfWidth) continue;
+
+            const float gap = distance - VehicleLength;
+            cap = std::max(0.f, speed_[j] + (gap - config_.minGap) / config_.headway);
+            if (speed_[j] < speed_[i] - 1.f || gap < config_.minGap) {
+                // Pass on whichever side has more room.
+                lane += lane < Track::CenterLine ? config_.passOffset : -config_.passOffset;
+                lane = std::clamp(lane, innerLane, outerLane);
+            }
+            ++stats_.following;
+            break;
+        }
+        laneRadius_[i] = lane;
+        speedCap_[i] = cap;
+    }
+}
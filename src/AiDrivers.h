@@ -0,0 +1,71 @@
+#pragma once
+
+#include "PhysicsVehicle.h"
+#include "PhysicsWorld.h"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+class VehicleRegistry;
+
+// Bots that drive every vehicle around the ring track. Each lap keeps its current
+// lane, slows behind a slower vehicle ahead in the same lane and swings out to
+// pass it. State is gathered into structure-of-arrays buffers once per step and
+// processed four vehicles at a time with Jolt's Vec4; only the vehicle-ahead
+// search is scalar, over vehicles bucketed by angle around the track.
+class AiDrivers {
+public:
+    struct Config {
+        float targetSpeed = 22.f;
+        // Lanes are kept this far inside the track edges.
+        float edgeMargin = 3.f;
+        // Vehicles closer than this laterally share a lane.
+        float laneHalfWidth = 2.5f;
+        // How far ahead along the lane a leader is searched for.
+        float scanDistance = 45.f;
+        // Bumper gap kept at standstill and time gap kept at speed.
+        float minGap = 6.f;
+        float headway = 1.2f;
+        // Lateral shift used to pass a slower leader.
+        float passOffset = 4.5f;
+    };
+
+    struct Stats {
+        size_t drivers = 0;
+        // Drivers that had a leader within scanDistance this step.
+        size_t following = 0;
+        float gatherMs = 0.f;
+        float solveMs = 0.f;
+    };
+
+    explicit AiDrivers(PhysicsWorld& world);
+
+    // Writes inputs[i] for the vehicle at dense registry index i. `centerX/Z` is
+    // the track centre in physics space, which moves when the origin is rebased.
+    // Must not overlap a physics step.
+    void update(const VehicleRegistry& vehicles, std::span<VehicleInput> inputs, float centerX = 0.f, float centerZ = 0.f);
+
+    Config& config() { return config_; }
+    const Stats& stats() const { return stats_; }
+
+private:
+    void resize(size_t count);
+    void findLeaders(size_t count);
+
+    PhysicsWorld& world_;
+    Config config_;
+    Stats stats_;
+
+    // Relative to the track centre. Padded to a multiple of four; tail lanes hold
+    // parked dummies.
+    std::vector<float> x_, z_;
+    std::vector<float> forwardX_, forwardZ_;
+    std::vector<float> speed_, maxSpeed_;
+    std::vector<float> angle_, radius_;
+    std::vector<float> laneRadius_, speedCap_;
+    std::vector<float> throttle_, steer_, brake_;
+
+    std::vector<uint32_t> bucketStart_;
+    std::vector<uint32_t> order_;
+};
@@ -0,0 +1,287 @@
+#include "BatchEnv.h"
+#include "TrackLayout.h"
+
+#include <Jolt/Core/Color.h>
+#include <Jolt/Core/JobSystem.h>
+#include <Jolt/Physics/Body/BodyFilter.h>
+#include <Jolt/Physics/Body/BodyInterface.h>
+#include <Jolt/Physics/Collision/CastResult.h>
+#include <Jolt/Physics/Collision/NarrowPhaseQuery.h>
+#include <Jolt/Physics/Collision/RayCast.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+using namespace JPH;
+
+namespace {
+
+// Gap along the centre line between vehicles of one environment at the start.
+constexpr float StartSpacing = 10.f;
+// Steps a dropped vehicle takes to come to rest before its state is captured.
+constexpr int SettleSteps = 60;
+constexpr float RayHeight = 0.5f;
+// Below this the vehicle's up axis is too far from vertical to drive on.
+constexpr float MinUprightness = 0.3f;
+
+PhysicsWorld::Config environmentWorldConfig(int vehicles) {
+    PhysicsWorld::Config config;
+    config.maxBodies = static_cast<uint32_t>(vehicles) + 8;
+    config.maxBodyPairs = 64 + static_cast<uint32_t>(vehicles) * 16;
+    config.maxContactConstraints = 64 + static_cast<uint32_t>(vehicles) * 16;
+    // Hundreds of these exist at once; the heap fallback covers rare peaks.
+    config.tempAllocatorBytes = 512 * 1024;
+    config.singleThreaded = true;
+    // Rewards come from poses, so contact events would only cost memory.
+    config.contactEventsPerThread = 0;
+    return config;
+}
+
+float wrapAngle(float angle) {
+    if (angle > JPH_PI) return angle - 2.f * JPH_PI;
+    if (angle < -JPH_PI) return angle + 2.f * JPH_PI;
+    return angle;
+}
+
+} // namespace
+
+BatchEnv::BatchEnv(const Config& config)
+    : config_(config), runtime_(JoltRuntime::acquire()) {
+    config_.environments = std::max(config_.environments, 1);
+    config_.vehiclesPerEnvironment = std::max(config_.vehiclesPerEnvironment, 1);
+    config_.frameSkip = std::max(config_.frameSkip, 1);
+    config_.maxEpisodeSteps = std::max(config_.maxEpisodeSteps, 1);
+    config_.rays = std::max(config_.rays, 0);
+
+    // Worlds and vehicles are only built here; step() and reset() reuse them.
+    environments_.resize(static_cast<size_t>(config_.environments));
+    for (size_t e = 0; e < environments_.size(); ++e) {
+        Environment& environment = environments_[e];
+        environment.world = std::make_unique<PhysicsWorld>(environmentWorldConfig(config_.vehiclesPerEnvironment));
+        Track::createGroundBody(*environment.world);
+        for (int v = 0; v < config_.vehiclesPerEnvironment; ++v) {
+            const RVec3 position(Track::CenterLine, PhysicsVehicle::spawnHeight(config_.type), StartSpacing * static_cast<float>(v));
+            environment.vehicles.push_back(
+                std::make_unique<PhysicsVehicle>(*environment.world, VehicleModel{}, config_.type, position));
+        }
+        environment.world->system().OptimizeBroadPhase();
+        environment.angles.resize(environment.vehicles.size());
+        environment.rng.seed(config_.seed + static_cast<uint32_t>(e) * 7919u);
+    }
+
+    // A freshly built vehicle hangs above the ground with its suspension unloaded,
+    // and restoreState() does not touch suspension or controller state. Let one
+    // settle and capture everything from there.
+    Environment& settle = environments_.front();
+    PhysicsVehicle& first = *settle.vehicles.front();
+    for (const auto& vehicle : settle.vehicles) {
+        vehicle->applyInput(VehicleInput{});
+    }
+    for (int step = 0; step < SettleSteps; ++step) {
+        settle.world->step(config_.dt);
+    }
+    first.captureState(restState_);
+    restState_.linearVelocity = Vec3::sZero();
+    restState_.angularVelocity = Vec3::sZero();
+    first.saveConstraintState(restConstraint_);
+    wheels_ = static_cast<int>(first.wheelCount());
+    observationSize_ = 13 + wheels_ + config_.rays;
+    restContacts_.resize(static_cast<size_t>(wheels_));
+    for (int w = 0; w < wheels_; ++w) {
+        restContacts_[static_cast<size_t>(w)] = first.wheelHasContact(static_cast<size_t>(w)) ? 1.f : 0.f;
+    }
+    for (Environment& environment : environments_) {
+        environment.state = restState_;
+        environment.constraint = restConstraint_;
+    }
+}
+
+BatchEnv::~BatchEnv() = default;
+
+BatchEnv::Stats BatchEnv::stats() const {
+    Stats stats = stats_;
+    for (const Environment& environment : environments_) {
+        stats.episodes += environment.episodes;
+        stats.terminations += environment.terminations;
+    }
+    return stats;
+}
+
+bool BatchEnv::reset(std::span<float> observations) {
+    if (observations.size() < static_cast<size_t>(agents()) * observationSize_) return false;
+    const auto start = std::chrono::steady_clock::now();
+    observations_ = observations;
+    run(Phase::Reset);
+    stats_.lastResetMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+bool BatchEnv::step(std::span<const float> actions, std::span<float> observations, std::span<float> rewards,
+                    std::span<uint8_t> dones) {
+    const auto count = static_cast<size_t>(agents());
+    if (actions.size() < count * ActionSize || observations.size() < count * observationSize_ || rewards.size() < count ||
+        dones.size() < count) {
+        return false;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    actions_ = actions;
+    observations_ = observations;
+    rewards_ = rewards;
+    dones_ = dones;
+    run(Phase::Step);
+    stats_.environmentSteps += environments_.size();
+    stats_.lastStepMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+// One job per worker, each taking every jobs-th environment. Jobs capture one
+// reference and their index, so std::function stores them without allocating.
+void BatchEnv::run(Phase phase) {
+    const size_t count = environments_.size();
+    const size_t jobs = std::min(count, static_cast<size_t>(runtime_->workerThreads()) + 1);
+    auto work = [this, phase, jobs](size_t job) {
+        for (size_t e = job; e < environments_.size(); e += jobs) {
+            if (phase == Phase::Reset) {
+                resetEnvironment(environments_[e]);
+                observe(environments_[e], e * static_cast<size_t>(config_.vehiclesPerEnvironment));
+            } else {
+                stepEnvironment(e);
+            }
+        }
+    };
+    if (jobs <= 1) {
+        work(0);
+        return;
+    }
+
+    JobSystem& jobSystem = runtime_->jobSystem();
+    JobSystem::Barrier* barrier = jobSystem.CreateBarrier();
+    for (size_t job = 0; job < jobs; ++job) {
+        barrier->AddJob(jobSystem.CreateJob("BatchEnvStep", Color::sGreen, [&work, job] { work(job); }));
+    }
+    jobSystem.WaitForJobs(barrier);
+    jobSystem.DestroyBarrier(barrier);
+}
+
+void BatchEnv::resetEnvironment(Environment& environment) {
+    std::uniform_real_distribution<float> angle(-JPH_PI, JPH_PI);
+    std::uniform_real_distribution<float> lane(Track::Inner + 4.f, Track::Outer - 4.f);
+    const float base = angle(environment.rng);
+    // Settled on the flat ground, so the rest height and suspension hold anywhere.
+    const float height = static_cast<float>(restState_.position.GetY());
+    for (size_t v = 0; v < environment.vehicles.size(); ++v) {
+        const float a = wrapAngle(base + StartSpacing * static_cast<float>(v) / Track::CenterLine);
+        const float radius = lane(environment.rng);
+        environment.state.position = RVec3(radius * std::cos(a), height, radius * std::sin(a));
+        // Laps run with increasing angle, so the ring tangent at angle a is a yaw of -a.
+        environment.state.rotation = Quat::sRotation(Vec3::sAxisY(), -a);
+        environment.vehicles[v]->restoreState(environment.state);
+        environment.constraint.rewind();
+        environment.vehicles[v]->restoreConstraintState(environment.constraint);
+        environment.angles[v] = a;
+    }
+    environment.steps = 0;
+    environment.fresh = true;
+    ++environment.episodes;
+}
+
+void BatchEnv::stepEnvironment(size_t index) {
+    Environment& environment = environments_[index];
+    const size_t firstAgent = index * static_cast<size_t>(config_.vehiclesPerEnvironment);
+
+    for (size_t v = 0; v < environment.vehicles.size(); ++v) {
+        const float* action = actions_.data() + (firstAgent + v) * ActionSize;
+        VehicleInput input;
+        input.throttle = std::clamp(action[0], -1.f, 1.f);
+        input.steer = std::clamp(action[1], -1.f, 1.f);
+        input.brake = action[2] > 0.5f;
+        environment.vehicles[v]->applyInput(input);
+    }
+    for (int frame = 0; frame < config_.frameSkip; ++frame) {
+        environment.world->step(config_.dt);
+    }
+    environment.fresh = false;
+
+    const BodyInterface& bodies = environment.world->system().GetBodyInterfaceNoLock();
+    bool terminated = false;
+    for (size_t v = 0; v < environment.vehicles.size(); ++v) {
+        RVec3 position;
+        Quat rotation;
+        bodies.GetPositionAndRotation(environment.vehicles[v]->bodyId(), position, rotation);
+        const float x = static_cast<float>(position.GetX());
+        const float z = static_cast<float>(position.GetZ());
+        const float a = std::atan2(z, x);
+        float& reward = rewards_[firstAgent + v];
+        reward = wrapAngle(a - environment.angles[v]) * Track::CenterLine;
+        environment.angles[v] = a;
+
+        const float radius = std::sqrt(x * x + z * z);
+        const bool offTrack = radius < Track::Inner - config_.offTrackMargin || radius > Track::Outer + config_.offTrackMargin;
+        const bool tipped = (rotation * Vec3::sAxisY()).GetY() < MinUprightness;
+        if (offTrack || tipped) {
+            reward -= config_.offTrackPenalty;
+            terminated = true;
+        }
+    }
+
+    ++environment.steps;
+    const uint8_t done = terminated ? Terminated : environment.steps >= config_.maxEpisodeSteps ? Truncated : Running;
+    std::fill_n(dones_.data() + firstAgent, environment.vehicles.size(), done);
+    if (done != Running) {
+        environment.terminations += terminated ? 1 : 0;
+        resetEnvironment(environment);
+    }
+    observe(environment, firstAgent);
+}
+
+void BatchEnv::observe(const Environment& environment, size_t firstAgent) {
+    const BodyInterface& bodies = environment.world->system().GetBodyInterfaceNoLock();
+    const NarrowPhaseQuery& query = environment.world->system().GetNarrowPhaseQueryNoLock();
+    for (size_t v = 0; v < environment.vehicles.size(); ++v) {
+        const PhysicsVehicle& vehicle = *environment.vehicles[v];
+        const BodyID body = vehicle.bodyId();
+        RVec3 position;
+        Quat rotation;
+        bodies.GetPositionAndRotation(body, position, rotation);
+        Vec3 linear, angular;
+        bodies.GetLinearAndAngularVelocity(body, linear, angular);
+        const Quat toLocal = rotation.Conjugated();
+        const Vec3 localLinear = toLocal * linear;
+        const Vec3 localAngular = toLocal * angular;
+
+        float* out = observations_.data() + (firstAgent + v) * static_cast<size_t>(observationSize_);
+        *out++ = static_cast<float>(position.GetX());
+        *out++ = static_cast<float>(position.GetY());
+        *out++ = static_cast<float>(position.GetZ());
+        *out++ = rotation.GetX();
+        *out++ = rotation.GetY();
+        *out++ = rotation.GetZ();
+        *out++ = rotation.GetW();
+        *out++ = localLinear.GetX();
+        *out++ = localLinear.GetY();
+        *out++ = localLinear.GetZ();
+        *out++ = localAngular.GetX();
+        *out++ = localAngular.GetY();
+        *out++ = localAngular.GetZ();
+        // Contacts are only found by a step, so a reset vehicle reports the rest ones.
+        for (int w = 0; w < wheels_; ++w) {
+            *out++ = environment.fresh ? restContacts_[static_cast<size_t>(w)]
+                                       : vehicle.wheelHasContact(static_cast<size_t>(w)) ? 1.f : 0.f;
+        }
+        if (config_.rays == 0) continue;
+
+        // Level rays around the heading, so they see other vehicles rather than the ground.
+        const Vec3 forward = rotation * Vec3::sAxisZ();
+        const float heading = std::atan2(forward.GetX(), forward.GetZ());
+        const RVec3 origin = position + Vec3(0.f, RayHeight, 0.f);
+        const IgnoreSingleBodyFilter ignoreSelf(body);
+        for (int r = 0; r < config_.rays; ++r) {
+            const float t = config_.rays > 1 ? static_cast<float>(r) / static_cast<float>(config_.rays - 1) - 0.5f : 0.f;
+            const float angle = heading + t * config_.rayFov;
+            const RRayCast ray(origin, Vec3(std::sin(angle), 0.f, std::cos(angle)) * config_.rayRange);
+            RayCastResult hit;
+            *out++ = query.CastRay(ray, hit, {}, {}, ignoreSelf) ? hit.mFraction : 1.f;
+        }
+    }
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "JoltRuntime.h"
+#include "PhysicsVehicle.h"
+#include "PhysicsWorld.h"
+#include "RollbackSession.h"
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <span>
+#include <vector>
+
+// Vectorized driving environments for reinforcement learning. Each environment
+// is an independent single-threaded PhysicsWorld holding the ground and its own
+// vehicles on the ring track; step() advances every environment as jobs on the
+// shared Jolt job system. Agents are numbered environment-major:
+// agent = environment * vehiclesPerEnvironment + vehicle.
+//
+// Actions are read from and observations, rewards and done flags written to
+// caller-owned contiguous arrays; nothing is allocated per step. Resets restore
+// a rest state captured once a vehicle has settled on the ground, instead of
+// rebuilding bodies.
+class BatchEnv {
+public:
+    // Per agent: throttle [-1, 1], steer [-1, 1], brake (brakes above 0.5).
+    static constexpr int ActionSize = 3;
+
+    // Done flags.
+    static constexpr uint8_t Running = 0;
+    // A vehicle left the track or tipped over.
+    static constexpr uint8_t Terminated = 1;
+    // The episode hit maxEpisodeSteps.
+    static constexpr uint8_t Truncated = 2;
+
+    struct Config {
+        int environments = 64;
+        int vehiclesPerEnvironment = 1;
+        VehicleType type = VehicleType::Kart;
+        float dt = 1.f / 30.f;
+        // Physics steps per step() under the same action.
+        int frameSkip = 2;
+        int maxEpisodeSteps = 1000;
+        // Horizontal rays fanned around the heading; 0 leaves them out.
+        int rays = 0;
+        float rayFov = JPH::JPH_PI;
+        float rayRange = 40.f;
+        // How far past a track edge a vehicle may go before the episode ends.
+        float offTrackMargin = 2.f;
+        float offTrackPenalty = 10.f;
+        uint32_t seed = 1;
+    };
+
+    struct Stats {
+        // step() calls times environments.
+        uint64_t environmentSteps = 0;
+        uint64_t episodes = 0;
+        uint64_t terminations = 0;
+        float lastStepMs = 0.f;
+        float lastResetMs = 0.f;
+    };
+
+    explicit BatchEnv(const Config& config);
+    ~BatchEnv();
+
+    BatchEnv(const BatchEnv&) = delete;
+    BatchEnv& operator=(const BatchEnv&) = delete;
+
+    int environments() const { return static_cast<int>(environments_.size()); }
+    int agents() const { return environments() * config_.vehiclesPerEnvironment; }
+    // Floats per agent: position (3), rotation quaternion (4), linear and angular
+    // velocity in the body frame (3 + 3), one 0/1 contact per wheel, then one hit
+    // fraction per ray (1 when nothing is within range).
+    int observationSize() const { return observationSize_; }
+    int wheelCount() const { return wheels_; }
+
+    // Starts a new episode everywhere and writes the first observations.
+    // Returns false if `observations` is too small.
+    bool reset(std::span<float> observations);
+    // Applies actions[agents() * ActionSize] for one step. Rewards are metres of
+    // progress along the track centre line, minus the penalty on termination.
+    // Environments that finish are reset within the call: their agents report the
+    // done flag along with the first observation of the next episode.
+    // Returns false if an array is too small.
+    bool step(std::span<const float> actions, std::span<float> observations, std::span<float> rewards,
+              std::span<uint8_t> dones);
+
+    const Config& config() const { return config_; }
+    Stats stats() const;
+
+private:
+    struct Environment {
+        std::unique_ptr<PhysicsWorld> world;
+        std::vector<std::unique_ptr<PhysicsVehicle>> vehicles;
+        // Angle around the track centre after the last step, per vehicle.
+        std::vector<float> angles;
+        // Reused for restoreState() so resets do not allocate.
+        VehicleState state;
+        // Copy of restConstraint_; each environment rewinds its own while resetting.
+        SnapshotBuffer constraint;
+        // Reset since the last step: wheel contacts still describe the old episode.
+        bool fresh = false;
+        std::mt19937 rng;
+        int steps = 0;
+        uint64_t episodes = 0;
+        uint64_t terminations = 0;
+    };
+
+    enum class Phase {
+        Reset,
+        Step
+    };
+
+    void run(Phase phase);
+    void resetEnvironment(Environment& environment);
+    void stepEnvironment(size_t index);
+    void observe(const Environment& environment, size_t firstAgent);
+
+    Config config_;
+    std::shared_ptr<JoltRuntime> runtime_;
+    std::vector<Environment> environments_;
+    VehicleState restState_;
+    SnapshotBuffer restConstraint_;
+    // Wheel contacts of the settled vehicle, reported until a reset one has stepped.
+    std::vector<float> restContacts_;
+    int wheels_ = 0;
+    int observationSize_ = 0;
+    // Caller arrays of the call in progress, read by the jobs.
+    std::span<const float> actions_;
+    std::span<float> observations_;
+    std::span<float> rewards_;
+    std::span<uint8_t> dones_;
+    Stats stats_;
+};
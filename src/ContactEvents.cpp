@@ -0,0 +1,183 @@
+#include "ContactEvents.h"
+
+#include <Jolt/Physics/Body/Body.h>
+#include <Jolt/Physics/Collision/ContactListener.h>
+
+#include <algorithm>
+#include <tuple>
+
+using namespace JPH;
+
+namespace {
+
+std::atomic<uint64_t> nextInstanceId{1};
+
+// Unique among live threads and never 0.
+uintptr_t threadToken() {
+    thread_local const char marker = 0;
+    return reinterpret_cast<uintptr_t>(&marker);
+}
+
+// The buffer a thread found last, so callbacks normally skip the search.
+struct CachedBuffer {
+    uint64_t instance = 0;
+    uint32_t index = 0;
+};
+thread_local CachedBuffer cachedBuffer;
+
+float inverseMass(const Body& body) {
+    return body.IsDynamic() ? body.GetMotionProperties()->GetInverseMass() : 0.f;
+}
+
+float estimateImpulse(const Body& body1, const Body& body2, const ContactManifold& manifold) {
+    const float invMass = inverseMass(body1) + inverseMass(body2);
+    if (invMass <= 0.f) return 0.f;
+
+    const RVec3 point = manifold.GetWorldSpaceContactPointOn1(0);
+    const Vec3 relative = body2.GetPointVelocity(point) - body1.GetPointVelocity(point);
+    const float closing = -relative.Dot(manifold.mWorldSpaceNormal);
+    return closing > 0.f ? closing / invMass : 0.f;
+}
+
+} // namespace
+
+ContactEvents::ContactEvents(uint32_t capacityPerThread, uint32_t workerThreads)
+    : capacity_(capacityPerThread),
+      workerThreads_(workerThreads),
+      id_(nextInstanceId.fetch_add(1, std::memory_order_relaxed)),
+      buffers_(std::make_unique<ThreadBuffer[]>(workerThreads + 1)) {
+    for (uint32_t i = 0; i <= workerThreads_; ++i) {
+        buffers_[i].events = std::make_unique<ContactEvent[]>(capacity_);
+    }
+}
+
+ContactEvents::~ContactEvents() = default;
+
+ContactEvents::ThreadBuffer* ContactEvents::threadBuffer() {
+    const uintptr_t token = threadToken();
+    if (token == caller_) return &buffers_[workerThreads_];
+    if (cachedBuffer.instance == id_) return &buffers_[cachedBuffer.index];
+
+    // First report from this worker: find its buffer or claim a free one. The
+    // pool never has more workers than buffers.
+    for (uint32_t i = 0; i < workerThreads_; ++i) {
+        uintptr_t owner = buffers_[i].owner.load(std::memory_order_acquire);
+        if (owner == 0 && buffers_[i].owner.compare_exchange_strong(owner, token, std::memory_order_acq_rel)) {
+            owner = token;
+        }
+        if (owner == token) {
+            cachedBuffer = {id_, i};
+            return &buffers_[i];
+        }
+    }
+    return nullptr;
+}
+
+void ContactEvents::prepare() {
+    caller_ = threadToken();
+}
+
+ContactEvent* ContactEvents::reserve() {
+    ThreadBuffer* buffer = threadBuffer();
+    if (buffer && buffer->count < capacity_) {
+        return &buffer->events[buffer->count++];
+    }
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+}
+
+void ContactEvents::record(ContactEventType type, const Body& body1, const Body& body2, const ContactManifold& manifold) {
+    const float impulse = estimateImpulse(body1, body2, manifold);
+    if (impulse < filter_.minImpulse) return;
+
+    ContactEvent* event = reserve();
+    if (!event) return;
+
+    const bool swap = body2.GetID() < body1.GetID();
+    const Body& first = swap ? body2 : body1;
+    const Body& second = swap ? body1 : body2;
+    event->body1 = first.GetID();
+    event->body2 = second.GetID();
+    event->layer1 = first.GetObjectLayer();
+    event->layer2 = second.GetObjectLayer();
+    event->type = type;
+    event->point = manifold.GetWorldSpaceContactPointOn1(0);
+    event->normal = swap ? -manifold.mWorldSpaceNormal : manifold.mWorldSpaceNormal;
+    event->penetration = manifold.mPenetrationDepth;
+    event->impulse = impulse;
+}
+
+ValidateResult ContactEvents::OnContactValidate(const Body&, const Body&, RVec3Arg, const CollideShapeResult&) {
+    return ValidateResult::AcceptAllContactsForThisBodyPair;
+}
+
+void ContactEvents::OnContactAdded(const Body& body1, const Body& body2, const ContactManifold& manifold, ContactSettings&) {
+    if (ThreadBuffer* buffer = threadBuffer()) {
+        ++buffer->manifolds;
+    } else {
+        strayManifolds_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (enabled() && filter_.added) {
+        record(ContactEventType::Added, body1, body2, manifold);
+    }
+}
+
+void ContactEvents::OnContactPersisted(const Body& body1, const Body& body2, const ContactManifold& manifold, ContactSettings&) {
+    if (ThreadBuffer* buffer = threadBuffer()) {
+        ++buffer->manifolds;
+    } else {
+        strayManifolds_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (enabled() && filter_.persisted) {
+        record(ContactEventType::Persisted, body1, body2, manifold);
+    }
+}
+
+void ContactEvents::OnContactRemoved(const SubShapeIDPair& pair) {
+    // Bodies may not be accessed here; layers are looked up in endStep().
+    if (!enabled() || !filter_.removed) return;
+
+    ContactEvent* event = reserve();
+    if (!event) return;
+
+    const bool swap = pair.GetBody2ID() < pair.GetBody1ID();
+    *event = ContactEvent{};
+    event->body1 = swap ? pair.GetBody2ID() : pair.GetBody1ID();
+    event->body2 = swap ? pair.GetBody1ID() : pair.GetBody2ID();
+    event->type = ContactEventType::Removed;
+}
+
+void ContactEvents::endStep(const BodyInterface& bodies) {
+    batch_.clear();
+
+    auto collect = [&](const ContactEvent* events, uint32_t count) {
+        for (uint32_t i = 0; i < count; ++i) {
+            ContactEvent event = events[i];
+            if (event.type == ContactEventType::Removed) {
+                // A body removed in the same step reports cObjectLayerInvalid.
+                event.layer1 = bodies.GetObjectLayer(event.body1);
+                event.layer2 = bodies.GetObjectLayer(event.body2);
+            }
+            const bool pass = (event.layer1 < 32 && (filter_.layerMask >> event.layer1) & 1u) ||
+                              (event.layer2 < 32 && (filter_.layerMask >> event.layer2) & 1u);
+            if (pass) {
+                batch_.push_back(event);
+            }
+        }
+    };
+
+    manifolds_ = strayManifolds_.exchange(0, std::memory_order_relaxed);
+    for (uint32_t t = 0; t <= workerThreads_; ++t) {
+        ThreadBuffer& buffer = buffers_[t];
+        collect(buffer.events.get(), buffer.count);
+        buffer.count = 0;
+        manifolds_ += buffer.manifolds;
+        buffer.manifolds = 0;
+    }
+
+    // Callback order depends on thread scheduling; sorting makes the batch deterministic.
+    std::sort(batch_.begin(), batch_.end(), [](const ContactEvent& a, const ContactEvent& b) {
+        return std::make_tuple(a.body1.GetIndexAndSequenceNumber(), a.body2.GetIndexAndSequenceNumber(), a.type) <
+               std::make_tuple(b.body1.GetIndexAndSequenceNumber(), b.body2.GetIndexAndSequenceNumber(), b.type);
+    });
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Physics/Body/BodyInterface.h>
+#include <Jolt/Physics/Collision/ContactListener.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+enum class ContactEventType : uint8_t {
+    Added,
+    Persisted,
+    Removed
+};
+
+struct ContactEvent {
+    // body1 < body2, so the same pair always reports in the same order.
+    JPH::BodyID body1;
+    JPH::BodyID body2;
+    JPH::ObjectLayer layer1 = JPH::cObjectLayerInvalid;
+    JPH::ObjectLayer layer2 = JPH::cObjectLayerInvalid;
+    ContactEventType type = ContactEventType::Added;
+    // Normal points from body1 to body2. Zero for Removed events.
+    JPH::RVec3 point = JPH::RVec3::sZero();
+    JPH::Vec3 normal = JPH::Vec3::sZero();
+    float penetration = 0.f;
+    // Closing speed along the normal times the pair's reduced mass, measured when
+    // the contact is reported, i.e. before the solver resolves it.
+    float impulse = 0.f;
+};
+
+// Contact listener that never blocks the solver: callbacks append to a buffer
+// owned by the calling Jolt worker thread, and after the step endStep() merges,
+// filters and sorts everything into one batch for the application. A step runs
+// on the job system's workers plus the thread calling Update, so there is one
+// buffer per worker, claimed by the first worker that reports, and one for the
+// caller.
+class ContactEvents final : public JPH::ContactListener {
+public:
+    struct Filter {
+        // Bit per ObjectLayer; an event passes when either body's layer is set.
+        uint32_t layerMask = ~0u;
+        // Added/Persisted events below this impulse are dropped in the callback.
+        float minImpulse = 0.f;
+        bool added = true;
+        bool persisted = false;
+        bool removed = true;
+    };
+
+    // `workerThreads` is the worker count of the job system the world steps on,
+    // 0 for a single-threaded one.
+    explicit ContactEvents(uint32_t capacityPerThread = 4096, uint32_t workerThreads = 0);
+    ~ContactEvents() override;
+
+    void setEnabled(bool enabled) { enabled_.store(enabled, std::memory_order_relaxed); }
+    bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+    // Only change between steps.
+    void setFilter(const Filter& filter) { filter_ = filter; }
+    const Filter& filter() const { return filter_; }
+
+    // Gives the calling thread the caller buffer for the next step. Call on the
+    // thread that runs the step, before it. Must not overlap a step.
+    void prepare();
+    // Collects the events of the step that just finished. Must not overlap a step.
+    void endStep(const JPH::BodyInterface& bodies);
+    // Events from the most recent step, sorted by body pair then type.
+    const std::vector<ContactEvent>& batch() const { return batch_; }
+
+    // Events lost because a thread buffer was full, or because a thread that is
+    // neither a worker nor the prepared caller reported.
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+    // Added + persisted manifolds in the last step, counted even when disabled or
+    // filtered out. Each one is a contact constraint in the solver.
+    uint32_t manifolds() const { return manifolds_; }
+
+    JPH::ValidateResult OnContactValidate(const JPH::Body& body1, const JPH::Body& body2, JPH::RVec3Arg baseOffset,
+                                          const JPH::CollideShapeResult& result) override;
+    void OnContactAdded(const JPH::Body& body1, const JPH::Body& body2, const JPH::ContactManifold& manifold,
+                        JPH::ContactSettings& settings) override;
+    void OnContactPersisted(const JPH::Body& body1, const JPH::Body& body2, const JPH::ContactManifold& manifold,
+                            JPH::ContactSettings& settings) override;
+    void OnContactRemoved(const JPH::SubShapeIDPair& pair) override;
+
+private:
+    struct alignas(64) ThreadBuffer {
+        // Identifies the worker that claimed the buffer; 0 while unclaimed.
+        std::atomic<uintptr_t> owner{0};
+        std::unique_ptr<ContactEvent[]> events;
+        uint32_t count = 0;
+        uint32_t manifolds = 0;
+    };
+
+    ThreadBuffer* threadBuffer();
+    ContactEvent* reserve();
+    void record(ContactEventType type, const JPH::Body& body1, const JPH::Body& body2, const JPH::ContactManifold& manifold);
+
+    uint32_t capacity_;
+    uint32_t workerThreads_;
+    // Tells instances apart in each thread's cached buffer lookup.
+    uint64_t id_;
+    std::atomic<bool> enabled_{true};
+    Filter filter_;
+    // One per worker, then the caller's at index workerThreads_.
+    std::unique_ptr<ThreadBuffer[]> buffers_;
+    uintptr_t caller_ = 0;
+    // Manifolds reported by threads without a buffer.
+    std::atomic<uint32_t> strayManifolds_{0};
+    uint32_t manifolds_ = 0;
+    std::atomic<uint64_t> dropped_{0};
+    std::vector<ContactEvent> batch_;
+};
@@ -0,0 +1,112 @@
+#include "BatchEnv.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+struct Options {
+    BatchEnv::Config env;
+    int steps = 2000;
+    // 0 keeps the runtime default.
+    unsigned threads = 0;
+};
+
+void printUsage() {
+    std::printf(
+        "Usage: VehicleEnvBench [options]\n"
+        "  --envs N         environments (default 64)\n"
+        "  --vehicles N     vehicles per environment (default 1)\n"
+        "  --type N         vehicle type 0-4 (default 0, kart)\n"
+        "  --steps N        timed step() calls (default 2000)\n"
+        "  --frame-skip N   physics steps per step() (default 2)\n"
+        "  --rays N         ray sensors per vehicle (default 0)\n"
+        "  --episode N      steps before truncation (default 1000)\n"
+        "  --threads N      Jolt worker threads (default: all cores but one)\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (std::strcmp(arg, "--help") == 0) {
+            printUsage();
+            return 0;
+        }
+        if (!value) {
+            printUsage();
+            return 1;
+        }
+        const int number = std::atoi(value);
+        if (std::strcmp(arg, "--envs") == 0) options.env.environments = number;
+        else if (std::strcmp(arg, "--vehicles") == 0) options.env.vehiclesPerEnvironment = number;
+        else if (std::strcmp(arg, "--type") == 0) options.env.type = static_cast<VehicleType>(std::clamp(number, 0, 4));
+        else if (std::strcmp(arg, "--steps") == 0) options.steps = std::max(1, number);
+        else if (std::strcmp(arg, "--frame-skip") == 0) options.env.frameSkip = number;
+        else if (std::strcmp(arg, "--rays") == 0) options.env.rays = number;
+        else if (std::strcmp(arg, "--episode") == 0) options.env.maxEpisodeSteps = number;
+        else if (std::strcmp(arg, "--threads") == 0) options.threads = static_cast<unsigned>(std::max(0, number));
+        else {
+            printUsage();
+            return 1;
+        }
+        ++i;
+    }
+    JoltRuntime::setWorkerThreads(options.threads);
+
+    auto start = std::chrono::steady_clock::now();
+    BatchEnv env(options.env);
+    const double createMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    const auto agents = static_cast<size_t>(env.agents());
+    std::vector<float> observations(agents * env.observationSize());
+    std::vector<float> rewards(agents);
+    std::vector<uint8_t> dones(agents);
+    // A fixed pool of random actions, so the timed loop measures only the environments.
+    constexpr size_t ActionSets = 64;
+    std::vector<float> actions(ActionSets * agents * BatchEnv::ActionSize);
+    std::mt19937 rng(options.env.seed);
+    std::uniform_real_distribution<float> unit(0.f, 1.f);
+    for (size_t i = 0; i < actions.size(); i += BatchEnv::ActionSize) {
+        actions[i] = unit(rng) * 1.5f - 0.5f;
+        actions[i + 1] = unit(rng) * 2.f - 1.f;
+        actions[i + 2] = unit(rng) < 0.1f ? 1.f : 0.f;
+    }
+
+    env.reset(observations);
+    const float resetMs = env.stats().lastResetMs;
+
+    double rewardSum = 0.0;
+    start = std::chrono::steady_clock::now();
+    for (int step = 0; step < options.steps; ++step) {
+        const size_t set = static_cast<size_t>(step) % ActionSets;
+        const std::span<const float> batch(actions.data() + set * agents * BatchEnv::ActionSize, agents * BatchEnv::ActionSize);
+        env.step(batch, observations, rewards, dones);
+        for (float reward : rewards) {
+            rewardSum += reward;
+        }
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const BatchEnv::Stats stats = env.stats();
+    const double environmentSteps = static_cast<double>(options.steps) * env.environments();
+    std::printf("%d environments x %d vehicles, %d observation floats, %u worker threads\n", env.environments(),
+                options.env.vehiclesPerEnvironment, env.observationSize(), JoltRuntime::acquire()->workerThreads());
+    std::printf("  create          %9.1f ms\n", createMs);
+    std::printf("  reset all       %9.3f ms\n", resetMs);
+    std::printf("  step()          %9.3f ms mean\n", 1000.0 * seconds / options.steps);
+    std::printf("  env-steps/s     %9.0f\n", environmentSteps / seconds);
+    std::printf("  agent-steps/s   %9.0f\n", environmentSteps * options.env.vehiclesPerEnvironment / seconds);
+    std::printf("  physics steps/s %9.0f\n", environmentSteps * std::max(options.env.frameSkip, 1) / seconds);
+    std::printf("  episodes %llu, terminated %llu, mean reward %.3f\n", static_cast<unsigned long long>(stats.episodes),
+                static_cast<unsigned long long>(stats.terminations), rewardSum / (environmentSteps * options.env.vehiclesPerEnvironment));
+    return 0;
+}
@@ -0,0 +1,125 @@
+#include "FleetSpawner.h"
+#include "JoltRuntime.h"
+#include "TrackLayout.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+using namespace JPH;
+
+namespace {
+
+struct Options {
+    int vehicles = 5000;
+    bool track = false;
+    bool compare = true;
+};
+
+void printUsage() {
+    std::printf(
+        "Usage: VehicleFleetBench [options]\n"
+        "  --vehicles N   fleet size (default 5000)\n"
+        "  --track        place on the track ring instead of the whole ground\n"
+        "  --no-compare   skip the one-body-at-a-time baseline\n");
+}
+
+double msSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::unique_ptr<PhysicsWorld> createWorld(int vehicles) {
+    PhysicsWorld::Config config;
+    config.maxBodies = static_cast<uint32_t>(vehicles) + 64;
+    config.maxBodyPairs = std::max<uint32_t>(config.maxBodies * 2, 1024);
+    config.maxContactConstraints = std::max<uint32_t>(config.maxBodies, 1024);
+    config.tempAllocatorBytes = 64 * 1024 * 1024;
+    auto world = std::make_unique<PhysicsWorld>(config);
+    Track::createGroundBody(*world);
+    return world;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (std::strcmp(arg, "--help") == 0) {
+            printUsage();
+            return 0;
+        }
+        if (std::strcmp(arg, "--track") == 0) {
+            options.track = true;
+            continue;
+        }
+        if (std::strcmp(arg, "--no-compare") == 0) {
+            options.compare = false;
+            continue;
+        }
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!value || std::strcmp(arg, "--vehicles") != 0) {
+            printUsage();
+            return 1;
+        }
+        options.vehicles = std::max(1, std::atoi(value));
+        ++i;
+    }
+
+    auto runtime = JoltRuntime::acquire();
+    // Blueprints are shared by both runs; build them outside the timings.
+    for (int type = 0; type < VehicleRegistry::TypeCount; ++type) {
+        PhysicsVehicle::sharedBlueprint(static_cast<VehicleType>(type));
+    }
+
+    FleetSpawner::Region region = FleetSpawner::Region::track();
+    if (!options.track) {
+        region = FleetSpawner::Region{};
+        region.halfExtentX = 290.f;
+        region.halfExtentZ = 290.f;
+    }
+
+    // Headless: vehicles get empty models, so only physics setup is timed.
+    auto world = createWorld(options.vehicles);
+    FleetSpawner spawner(*world);
+    std::vector<VehiclePlacement> placements;
+    spawner.plan(region, options.vehicles, placements);
+    std::vector<VehicleModel> models(placements.size());
+
+    VehicleRegistry registry(*world);
+    std::vector<VehicleHandle> handles;
+    auto start = std::chrono::steady_clock::now();
+    registry.spawnBatch(placements, models, handles);
+    const double batchMs = msSince(start);
+    start = std::chrono::steady_clock::now();
+    world->step(1.f / 60.f);
+    const double batchStepMs = msSince(start);
+
+    const FleetSpawner::Stats& stats = spawner.stats();
+    std::printf("%d requested, %d placed (%d sampled, %d off ground, %d overlapping), %u worker threads\n",
+                stats.requested, stats.placed, stats.sampled, stats.noGround, stats.overlapping, runtime->workerThreads());
+    std::printf("  sample          %9.3f ms\n", stats.sampleMs);
+    std::printf("  ground/overlap  %9.3f ms\n", stats.queryMs);
+    std::printf("  batch insert    %9.3f ms, first step %.3f ms\n", batchMs, batchStepMs);
+
+    if (options.compare) {
+        auto baselineWorld = createWorld(options.vehicles);
+        VehicleRegistry baseline(*baselineWorld);
+        start = std::chrono::steady_clock::now();
+        for (const VehiclePlacement& placement : placements) {
+            const VehicleHandle handle = baseline.spawn(VehicleModel{}, placement.type, placement.position);
+            baselineWorld->bodyInterface().SetRotation(baseline.get(handle)->bodyId(), placement.rotation, EActivation::Activate);
+        }
+        const double singleMs = msSince(start);
+        start = std::chrono::steady_clock::now();
+        baselineWorld->step(1.f / 60.f);
+        const double singleStepMs = msSince(start);
+        std::printf("  per-body insert %9.3f ms, first step %.3f ms (%.1fx)\n", singleMs, singleStepMs,
+                    batchMs > 0.0 ? singleMs / batchMs : 0.0);
+    }
+    return stats.placed > 0 ? 0 : 1;
+}
@@ -0,0 +1,250 @@
+#include "FleetSpawner.h"
+#include "TrackLayout.h"
+
+#include <Jolt/Core/Color.h>
+#include <Jolt/Core/JobSystem.h>
+#include <Jolt/Geometry/AABox.h>
+#include <Jolt/Physics/Collision/BroadPhase/BroadPhaseQuery.h>
+#include <Jolt/Physics/Collision/CastResult.h>
+#include <Jolt/Physics/Collision/CollisionCollectorImpl.h>
+#include <Jolt/Physics/Collision/NarrowPhaseQuery.h>
+#include <Jolt/Physics/Collision/ObjectLayer.h>
+#include <Jolt/Physics/Collision/RayCast.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+using namespace JPH;
+
+namespace {
+
+constexpr uint8_t Placed = 0;
+constexpr uint8_t NoGround = 1;
+constexpr uint8_t Overlapping = 2;
+
+// Chassis bounds around the body position rather than the centre of mass.
+AABox chassisBounds(VehicleType type) {
+    const RefConst<Shape> chassis = PhysicsVehicle::sharedBlueprint(type).chassis;
+    AABox bounds = chassis->GetLocalBounds();
+    bounds.Translate(chassis->GetCenterOfMass());
+    return bounds;
+}
+
+} // namespace
+
+FleetSpawner::Region FleetSpawner::Region::track() {
+    Region region;
+    region.halfExtentX = Track::Outer;
+    region.halfExtentZ = Track::Outer;
+    region.innerRadius = Track::Inner;
+    region.outerRadius = Track::Outer;
+    return region;
+}
+
+FleetSpawner::FleetSpawner(PhysicsWorld& world)
+    : world_(world) {}
+
+float FleetSpawner::footprintRadius(VehicleType type) {
+    const AABox bounds = chassisBounds(type);
+    const float x = std::max(std::abs(bounds.mMin.GetX()), std::abs(bounds.mMax.GetX()));
+    const float z = std::max(std::abs(bounds.mMin.GetZ()), std::abs(bounds.mMax.GetZ()));
+    return std::sqrt(x * x + z * z);
+}
+
+void FleetSpawner::plan(const Region& region, int count, std::vector<VehiclePlacement>& placements) {
+    placements.clear();
+    stats_ = {};
+    stats_.requested = count;
+
+    // Every new vehicle needs a body; pooled ones already hold theirs, so this is conservative.
+    const PhysicsSystem& system = world_.system();
+    count = std::min(count, static_cast<int>(system.GetMaxBodies() - system.GetNumBodies()));
+    if (count <= 0) return;
+
+    const auto start = std::chrono::steady_clock::now();
+    sample(region, count);
+    const auto sampled = std::chrono::steady_clock::now();
+    query(region, placements);
+    const auto queried = std::chrono::steady_clock::now();
+
+    stats_.sampled = static_cast<int>(samples_.size());
+    stats_.placed = static_cast<int>(placements.size());
+    stats_.sampleMs = std::chrono::duration<float, std::milli>(sampled - start).count();
+    stats_.queryMs = std::chrono::duration<float, std::milli>(queried - sampled).count();
+}
+
+// Bridson's algorithm with a radius per sample: a candidate is accepted when its
+// disc does not reach into any earlier one. Cells are as wide as the largest
+// possible gap, so the 3x3 block around a candidate holds every sample it can
+// touch; each cell chains its samples through next_.
+void FleetSpawner::sample(const Region& region, int count) {
+    samples_.clear();
+    next_.clear();
+
+    std::array<float, VehicleRegistry::TypeCount> radius{};
+    std::array<float, VehicleRegistry::TypeCount> weights = config_.typeWeights;
+    if (std::all_of(weights.begin(), weights.end(), [](float w) { return w <= 0.f; })) {
+        weights.fill(1.f);
+    }
+    float maxRadius = 0.f;
+    for (int type = 0; type < VehicleRegistry::TypeCount; ++type) {
+        if (weights[type] <= 0.f) continue;
+        radius[type] = footprintRadius(static_cast<VehicleType>(type)) + 0.5f * config_.clearance;
+        maxRadius = std::max(maxRadius, radius[type]);
+    }
+
+    const float cell = 2.f * maxRadius;
+    const float originX = region.centerX - region.halfExtentX;
+    const float originZ = region.centerZ - region.halfExtentZ;
+    const int columns = std::max(1, static_cast<int>(std::ceil(2.f * region.halfExtentX / cell)));
+    const int rows = std::max(1, static_cast<int>(std::ceil(2.f * region.halfExtentZ / cell)));
+    grid_.assign(static_cast<size_t>(columns) * rows, -1);
+
+    std::mt19937 rng(config_.seed);
+    std::uniform_real_distribution<float> unit(0.f, 1.f);
+    std::discrete_distribution<int> pickType(weights.begin(), weights.end());
+
+    const bool ring = region.outerRadius > 0.f;
+    auto inside = [&](float x, float z) {
+        if (std::abs(x - region.centerX) > region.halfExtentX || std::abs(z - region.centerZ) > region.halfExtentZ) return false;
+        if (!ring) return true;
+        const float dx = x - region.ringCenterX;
+        const float dz = z - region.ringCenterZ;
+        const float r2 = dx * dx + dz * dz;
+        return r2 >= region.innerRadius * region.innerRadius && r2 <= region.outerRadius * region.outerRadius;
+    };
+    auto cellOf = [&](float x, float z, int& cx, int& cz) {
+        cx = std::clamp(static_cast<int>((x - originX) / cell), 0, columns - 1);
+        cz = std::clamp(static_cast<int>((z - originZ) / cell), 0, rows - 1);
+    };
+    auto fits = [&](float x, float z, float r) {
+        int cx, cz;
+        cellOf(x, z, cx, cz);
+        for (int gz = std::max(cz - 1, 0); gz <= std::min(cz + 1, rows - 1); ++gz) {
+            for (int gx = std::max(cx - 1, 0); gx <= std::min(cx + 1, columns - 1); ++gx) {
+                for (int other = grid_[static_cast<size_t>(gz) * columns + gx]; other >= 0; other = next_[other]) {
+                    const Sample& s = samples_[other];
+                    const float dx = s.x - x;
+                    const float dz = s.z - z;
+                    const float gap = s.radius + r;
+                    if (dx * dx + dz * dz < gap * gap) return false;
+                }
+            }
+        }
+        return true;
+    };
+    std::vector<int> active;
+    auto add = [&](float x, float z, float r, VehicleType type) {
+        int cx, cz;
+        cellOf(x, z, cx, cz);
+        int& head = grid_[static_cast<size_t>(cz) * columns + cx];
+        next_.push_back(head);
+        head = static_cast<int>(samples_.size());
+        active.push_back(head);
+        samples_.push_back({x, z, r, type});
+    };
+
+    for (int attempt = 0; attempt < 1000 && samples_.empty(); ++attempt) {
+        const float x = originX + unit(rng) * 2.f * region.halfExtentX;
+        const float z = originZ + unit(rng) * 2.f * region.halfExtentZ;
+        if (inside(x, z)) {
+            const auto type = static_cast<VehicleType>(pickType(rng));
+            add(x, z, radius[static_cast<int>(type)], type);
+        }
+    }
+
+    while (!active.empty() && static_cast<int>(samples_.size()) < count) {
+        const size_t slot = static_cast<size_t>(unit(rng) * static_cast<float>(active.size())) % active.size();
+        const Sample parent = samples_[active[slot]];
+        const auto type = static_cast<VehicleType>(pickType(rng));
+        const float r = radius[static_cast<int>(type)];
+        const float spacing = parent.radius + r;
+
+        bool placed = false;
+        for (int attempt = 0; attempt < config_.attemptsPerSample; ++attempt) {
+            const float angle = unit(rng) * 2.f * JPH_PI;
+            const float distance = spacing * (1.f + unit(rng));
+            const float x = parent.x + distance * std::cos(angle);
+            const float z = parent.z + distance * std::sin(angle);
+            if (inside(x, z) && fits(x, z, r)) {
+                add(x, z, r, type);
+                placed = true;
+                break;
+            }
+        }
+        if (!placed) {
+            active[slot] = active.back();
+            active.pop_back();
+        }
+    }
+}
+
+void FleetSpawner::query(const Region& region, std::vector<VehiclePlacement>& placements) {
+    std::array<AABox, VehicleRegistry::TypeCount> bounds;
+    for (int type = 0; type < VehicleRegistry::TypeCount; ++type) {
+        bounds[type] = chassisBounds(static_cast<VehicleType>(type));
+    }
+
+    const size_t n = samples_.size();
+    candidates_.resize(n);
+    status_.assign(n, Placed);
+
+    const bool ring = region.outerRadius > 0.f;
+    const NarrowPhaseQuery& rays = world_.system().GetNarrowPhaseQuery();
+    const BroadPhaseQuery& boxes = world_.system().GetBroadPhaseQuery();
+    const SpecifiedObjectLayerFilter groundLayer(PhysicsLayers::Static);
+    const SpecifiedObjectLayerFilter vehicleLayer(PhysicsLayers::Dynamic);
+    const Vec3 clearance = Vec3::sReplicate(0.5f * config_.clearance);
+
+    auto resolve = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const Sample& s = samples_[i];
+            VehiclePlacement& placement = candidates_[i];
+            placement.type = s.type;
+
+            const RRayCast ray(RVec3(s.x, config_.rayTop, s.z), Vec3(0.f, -config_.rayLength, 0.f));
+            RayCastResult hit;
+            if (!rays.CastRay(ray, hit, {}, groundLayer)) {
+                status_[i] = NoGround;
+                continue;
+            }
+            const float ground = config_.rayTop - hit.mFraction * config_.rayLength;
+            placement.position = RVec3(s.x, ground + PhysicsVehicle::spawnHeight(s.type), s.z);
+            // Laps run with increasing angle, so the ring tangent at angle a is a yaw of -a.
+            const float yaw = ring ? -std::atan2(s.z - region.ringCenterZ, s.x - region.ringCenterX) : region.heading;
+            placement.rotation = Quat::sRotation(Vec3::sAxisY(), yaw);
+
+            AABox box = bounds[static_cast<int>(s.type)].Transformed(Mat44::sRotation(placement.rotation));
+            box.Translate(Vec3(placement.position));
+            box.ExpandBy(clearance);
+            AnyHitCollisionCollector<CollideShapeBodyCollector> collector;
+            boxes.CollideAABox(box, collector, {}, vehicleLayer);
+            if (collector.HadHit()) {
+                status_[i] = Overlapping;
+            }
+        }
+    };
+
+    JobSystem& jobSystem = world_.jobSystem();
+    const size_t slice = static_cast<size_t>(std::max(config_.queriesPerJob, 16));
+    JobSystem::Barrier* barrier = jobSystem.CreateBarrier();
+    for (size_t begin = 0; begin < n; begin += slice) {
+        const size_t end = std::min(begin + slice, n);
+        barrier->AddJob(jobSystem.CreateJob("FleetSpawnQuery", Color::sYellow, [&resolve, begin, end] { resolve(begin, end); }));
+    }
+    jobSystem.WaitForJobs(barrier);
+    jobSystem.DestroyBarrier(barrier);
+
+    placements.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        if (status_[i] == NoGround) {
+            ++stats_.noGround;
+        } else if (status_[i] == Overlapping) {
+            ++stats_.overlapping;
+        } else {
+            placements.push_back(candidates_[i]);
+        }
+    }
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "PhysicsWorld.h"
+#include "VehicleRegistry.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// Bulk placement of mixed vehicle fleets. Positions come from variable-radius
+// Poisson-disk sampling over a region, so footprints never overlap each other.
+// Ground heights and overlap checks against bodies already in the world are
+// resolved in one job-parallel pass of ray casts and broadphase box queries.
+// The result feeds VehicleRegistry::spawnBatch, which adds every body at once.
+class FleetSpawner {
+public:
+    struct Region {
+        float centerX = 0.f;
+        float centerZ = 0.f;
+        float halfExtentX = 50.f;
+        float halfExtentZ = 50.f;
+        // With outerRadius > 0 only the part of the rectangle inside the ring around
+        // the ring centre is used, and vehicles face along the ring in the lap
+        // direction instead of `heading`.
+        float ringCenterX = 0.f;
+        float ringCenterZ = 0.f;
+        float innerRadius = 0.f;
+        float outerRadius = 0.f;
+        // Yaw in radians; 0 faces +Z.
+        float heading = 0.f;
+
+        // The ring track drawn by the test scene.
+        static Region track();
+    };
+
+    struct Config {
+        // Relative share of each VehicleType.
+        std::array<float, VehicleRegistry::TypeCount> typeWeights = {1.f, 1.f, 1.f, 1.f, 1.f};
+        // Gap kept between footprints, in metres.
+        float clearance = 1.f;
+        // Candidates tried around a sample before it is retired (Bridson's k).
+        int attemptsPerSample = 30;
+        // Ground rays run straight down from rayTop over rayLength.
+        float rayTop = 50.f;
+        float rayLength = 100.f;
+        uint32_t seed = 1;
+        // Placements per query job.
+        int queriesPerJob = 256;
+    };
+
+    struct Stats {
+        int requested = 0;
+        int sampled = 0;
+        int noGround = 0;
+        int overlapping = 0;
+        int placed = 0;
+        float sampleMs = 0.f;
+        float queryMs = 0.f;
+    };
+
+    explicit FleetSpawner(PhysicsWorld& world);
+
+    // Fills `placements` with up to `count` vehicles; fewer when the region is full
+    // or the world is out of body capacity. Must not overlap a physics step.
+    void plan(const Region& region, int count, std::vector<VehiclePlacement>& placements);
+
+    Config& config() { return config_; }
+    const Stats& stats() const { return stats_; }
+
+    // Radius of the type's chassis footprint in the XZ plane, without clearance.
+    static float footprintRadius(VehicleType type);
+
+private:
+    struct Sample {
+        float x;
+        float z;
+        float radius;
+        VehicleType type;
+    };
+
+    void sample(const Region& region, int count);
+    void query(const Region& region, std::vector<VehiclePlacement>& placements);
+
+    PhysicsWorld& world_;
+    Config config_;
+    std::vector<Sample> samples_;
+    // Per sample: 0 placed, 1 no ground, 2 overlapping.
+    std::vector<uint8_t> status_;
+    std::vector<VehiclePlacement> candidates_;
+    // Sampling grid: first sample per cell, then the next one in the same cell.
+    std::vector<int> grid_;
+    std::vector<int> next_;
+    Stats stats_;
+};
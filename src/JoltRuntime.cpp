@@ -0,0 +1,81 @@
+#include "JoltRuntime.h"
+
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <Jolt/Core/JobSystemThreadPool.h>
+#include <Jolt/RegisterTypes.h>
+
+using namespace JPH;
+
+// Sized for many worlds updating at once: every PhysicsSystem::Update keeps a
+// handful of barriers and up to a couple of thousand jobs in flight.
+static constexpr uint32_t cMaxJobs = 8192;
+static constexpr uint32_t cMaxBarriers = 512;
+
+namespace {
+
+std::mutex runtimeMutex;
+std::weak_ptr<JoltRuntime> runtimeInstance;
+uint32_t requestedWorkers = 0;
+
+} // namespace
+
+std::shared_ptr<JoltRuntime> JoltRuntime::acquire() {
+    std::lock_guard lock(runtimeMutex);
+    auto runtime = runtimeInstance.lock();
+    if (!runtime) {
+        runtime = std::shared_ptr<JoltRuntime>(new JoltRuntime(), &JoltRuntime::destroy);
+        runtimeInstance = runtime;
+    }
+    return runtime;
+}
+
+// The last reference can be dropped on any thread, after which acquire() may
+// already have created a successor. Tearing down under the mutex keeps the two
+// from interleaving, and the successor's factory and types are left alone.
+void JoltRuntime::destroy(JoltRuntime* runtime) {
+    std::lock_guard lock(runtimeMutex);
+    runtime->ownsGlobals_ = runtimeInstance.expired();
+    delete runtime;
+}
+
+bool JoltRuntime::alive() {
+    std::lock_guard lock(runtimeMutex);
+    return !runtimeInstance.expired();
+}
+
+void JoltRuntime::setWorkerThreads(uint32_t count) {
+    std::lock_guard lock(runtimeMutex);
+    requestedWorkers = count;
+}
+
+JoltRuntime::JoltRuntime() {
+    RegisterDefaultAllocator();
+
+    factory_ = std::make_unique<Factory>();
+    Factory::sInstance = factory_.get();
+    RegisterTypes();
+
+    const uint32_t threadCount = std::max(1u, std::thread::hardware_concurrency());
+    // Called from acquire() with runtimeMutex held.
+    workerThreads_ = requestedWorkers > 0 ? requestedWorkers : std::max(1u, threadCount - 1);
+    jobSystem_ = std::make_unique<JobSystemThreadPool>(cMaxJobs, cMaxBarriers, workerThreads_);
+}
+
+JoltRuntime::~JoltRuntime() {
+    jobSystem_.reset();
+    if (ownsGlobals_) {
+        UnregisterTypes();
+        Factory::sInstance = nullptr;
+    }
+    factory_.reset();
+}
+
+JPH::JobSystem& JoltRuntime::jobSystem() {
+    return *jobSystem_;
+}
+
+uint32_t JoltRuntime::workerThreads() const {
+    return workerThreads_;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Core/Factory.h>
+#include <Jolt/Core/JobSystem.h>
+#include <cstdint>
+#include <memory>
+
+// Process-wide Jolt state: the default allocator, the type factory and a single
+// job system shared by every PhysicsWorld. Worlds hold a reference; the runtime
+// is torn down when the last reference goes away.
+class JoltRuntime {
+public:
+    static std::shared_ptr<JoltRuntime> acquire();
+    // Worker threads for runtimes created after this call; 0 uses every core but
+    // one. Lets several simulation processes share a machine without oversubscribing.
+    static void setWorkerThreads(uint32_t count);
+    // Whether a runtime currently exists, e.g. to refuse forking with live worker threads.
+    static bool alive();
+
+    JoltRuntime(const JoltRuntime&) = delete;
+    JoltRuntime& operator=(const JoltRuntime&) = delete;
+
+    JPH::JobSystem& jobSystem();
+    uint32_t workerThreads() const;
+
+private:
+    JoltRuntime();
+    ~JoltRuntime();
+
+    // Deleter for the shared instance; see JoltRuntime.cpp.
+    static void destroy(JoltRuntime* runtime);
+
+    std::unique_ptr<JPH::Factory> factory_;
+    std::unique_ptr<JPH::JobSystem> jobSystem_;
+    uint32_t workerThreads_ = 0;
+    // Cleared when a newer runtime already owns the factory and registered types.
+    bool ownsGlobals_ = true;
+};
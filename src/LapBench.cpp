@@ -0,0 +1,145 @@
+#include "JoltRuntime.h"
+#include "LapEvaluator.h"
+#include "StartupCache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Options {
+    std::string out = "lap_sweep.csv";
+    std::string cache;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    LapRunConfig run;
+    std::vector<float> engineScales = {0.75f, 1.f, 1.25f};
+    std::vector<float> speedScales = {0.8f, 1.f, 1.2f};
+    std::vector<float> brakeScales = {0.5f, 1.f, 1.5f};
+    std::vector<float> steerScales = {1.f};
+};
+
+std::vector<float> parseList(const char* text) {
+    std::vector<float> values;
+    const char* p = text;
+    while (*p) {
+        char* end = nullptr;
+        values.push_back(std::strtof(p, &end));
+        if (end == p) break;
+        p = *end == ',' ? end + 1 : end;
+    }
+    return values;
+}
+
+void printUsage() {
+    std::printf(
+        "Usage: VehicleLapBench [options]\n"
+        "  --out FILE         CSV output path (default lap_sweep.csv)\n"
+        "  --cache FILE       startup cache to map, baked if missing or stale\n"
+        "  --threads N        worker threads (default: all cores)\n"
+        "  --laps N           timed laps per trial (default 2)\n"
+        "  --timeout S        simulated seconds before a trial gives up (default 240)\n"
+        "  --engine a,b,..    engineForce scales relative to the type default\n"
+        "  --speed a,b,..     maxSpeed scales\n"
+        "  --brake a,b,..     brakeForce scales\n"
+        "  --steer a,b,..     steerTorque scales\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (std::strcmp(arg, "--help") == 0) {
+            printUsage();
+            return 0;
+        }
+        if (!value) {
+            printUsage();
+            return 1;
+        }
+        if (std::strcmp(arg, "--out") == 0) options.out = value;
+        else if (std::strcmp(arg, "--cache") == 0) options.cache = value;
+        else if (std::strcmp(arg, "--threads") == 0) options.threads = static_cast<unsigned>(std::atoi(value));
+        else if (std::strcmp(arg, "--laps") == 0) options.run.laps = std::atoi(value);
+        else if (std::strcmp(arg, "--timeout") == 0) options.run.timeout = std::strtof(value, nullptr);
+        else if (std::strcmp(arg, "--engine") == 0) options.engineScales = parseList(value);
+        else if (std::strcmp(arg, "--speed") == 0) options.speedScales = parseList(value);
+        else if (std::strcmp(arg, "--brake") == 0) options.brakeScales = parseList(value);
+        else if (std::strcmp(arg, "--steer") == 0) options.steerScales = parseList(value);
+        else {
+            printUsage();
+            return 1;
+        }
+        ++i;
+    }
+
+    // Shapes are restored through the Jolt factory, so the runtime has to exist
+    // before the cache is opened; the sweep reuses it.
+    auto runtime = JoltRuntime::acquire();
+    if (!options.cache.empty()) {
+        StartupCache::setActive(StartupCache::openOrBake(options.cache));
+    }
+
+    std::vector<LapTrial> trials;
+    const VehicleType types[] = {VehicleType::Kart, VehicleType::Sedan, VehicleType::Truck, VehicleType::Tank, VehicleType::Motorcycle};
+    for (VehicleType type : types) {
+        const VehicleSettings base = PhysicsVehicle::defaultSettings(type);
+        for (float engine : options.engineScales)
+            for (float speed : options.speedScales)
+                for (float brake : options.brakeScales)
+                    for (float steer : options.steerScales) {
+                        LapTrial trial;
+                        trial.type = type;
+                        trial.settings = base;
+                        trial.settings.engineForce = base.engineForce * engine;
+                        trial.settings.maxSpeed = base.maxSpeed * speed;
+                        trial.settings.brakeForce = base.brakeForce * brake;
+                        trial.settings.steerTorque = base.steerTorque * steer;
+                        trials.push_back(trial);
+                    }
+    }
+
+    std::ofstream csv(options.out);
+    if (!csv) {
+        std::fprintf(stderr, "Cannot open %s\n", options.out.c_str());
+        return 1;
+    }
+    csv << "type,mass,engine_force,max_speed,steer_torque,brake_force,laps,best_lap_s,mean_lap_s,top_speed_mps,steps,wall_s,steps_per_s,physics_error_steps,temp_peak_bytes,temp_overflows\n";
+
+    std::printf("Running %zu trials on %u threads\n", trials.size(), options.threads);
+    std::mutex outputMutex;
+    size_t done = 0;
+    long long totalSteps = 0;
+    const auto start = std::chrono::steady_clock::now();
+    runLapSweep(trials, options.run, options.threads, [&](const LapResult& r) {
+        const auto& s = r.trial.settings;
+        const double stepsPerSecond = r.wallSeconds > 0.0 ? r.steps / r.wallSeconds : 0.0;
+        std::lock_guard lock(outputMutex);
+        csv << vehicleTypeName(r.trial.type) << ',' << s.mass << ',' << s.engineForce << ',' << s.maxSpeed << ','
+            << s.steerTorque << ',' << s.brakeForce << ',' << r.laps << ',' << r.bestLap << ',' << r.meanLap << ','
+            << r.topSpeed << ',' << r.steps << ',' << r.wallSeconds << ',' << stepsPerSecond << ','
+            << r.physicsErrorSteps << ',' << r.tempPeakBytes << ',' << r.tempOverflows << '\n';
+        if (r.physicsErrorSteps > 0 || r.tempOverflows > 0) {
+            std::fprintf(stderr, "warning: %s trial hit physics capacity limits (%llu error steps, %llu temp overflows)\n",
+                         vehicleTypeName(r.trial.type), static_cast<unsigned long long>(r.physicsErrorSteps),
+                         static_cast<unsigned long long>(r.tempOverflows));
+        }
+        totalSteps += r.steps;
+        std::printf("[%zu/%zu] %s best %.2fs top %.1f m/s (%.0f steps/s)\n", ++done, trials.size(),
+                    vehicleTypeName(r.trial.type), r.bestLap, r.topSpeed, stepsPerSecond);
+    });
+
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("Simulated %lld steps in %.2fs (%.0f steps/s aggregate), results in %s\n",
+                totalSteps, elapsed, elapsed > 0.0 ? totalSteps / elapsed : 0.0, options.out.c_str());
+    return 0;
+}
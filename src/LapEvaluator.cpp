@@ -0,0 +1,101 @@
+#include "LapEvaluator.h"
+#include "TrackLayout.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace JPH;
+
+LapResult runLapTrial(const LapTrial& trial, const LapRunConfig& config) {
+    const auto wallStart = std::chrono::steady_clock::now();
+
+    LapResult result;
+    result.trial = trial;
+
+    // Sweeps already run one trial per core, so each world steps on its own
+    // thread instead of fanning out onto the shared pool.
+    PhysicsWorld::Config worldConfig;
+    worldConfig.singleThreaded = true;
+    PhysicsWorld physics(worldConfig);
+    Track::createGroundBody(physics);
+    // Start just before the line so the first crossing opens the first timed lap.
+    const RVec3 start(Track::CenterLine, PhysicsVehicle::spawnHeight(trial.type), -15.f);
+    // Headless: no visual model, so no threepp objects are built on sweep threads.
+    PhysicsVehicle vehicle(physics, VehicleModel{}, trial.type, start, &trial.settings);
+
+    RVec3 previous = vehicle.position();
+    float time = 0.f;
+    float lapStart = -1.f;
+    float totalLapTime = 0.f;
+    while (time < config.timeout && result.laps < config.laps) {
+        const Vec3 velocity = vehicle.velocity();
+        vehicle.applyInput(Track::followRacingLine(previous, vehicle.rotation(), velocity, vehicle.settings().maxSpeed));
+        physics.step(config.dt);
+        time += config.dt;
+        ++result.steps;
+
+        const RVec3 current = vehicle.position();
+        result.topSpeed = std::max(result.topSpeed, vehicle.speed());
+        if (Track::crossesStartLine(previous, current)) {
+            if (lapStart >= 0.f) {
+                const float lap = time - lapStart;
+                result.bestLap = result.laps == 0 ? lap : std::min(result.bestLap, lap);
+                totalLapTime += lap;
+                ++result.laps;
+            }
+            lapStart = time;
+        }
+        previous = current;
+    }
+
+    if (result.laps > 0) {
+        result.meanLap = totalLapTime / static_cast<float>(result.laps);
+    }
+    const auto& capacity = physics.capacityStats();
+    result.physicsErrorSteps = capacity.errorSteps();
+    result.tempPeakBytes = capacity.tempPeakEver;
+    result.tempOverflows = capacity.tempOverflows;
+    result.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    return result;
+}
+
+void runLapSweep(const std::vector<LapTrial>& trials, const LapRunConfig& config, unsigned threads,
+                 const std::function<void(const LapResult&)>& onResult) {
+    // Keep the runtime alive between trials so the thread pool is not rebuilt for
+    // every short-lived world.
+    auto runtime = JoltRuntime::acquire();
+    // Without a startup cache the shared blueprints come from procedural models;
+    // build them here rather than on the sweep threads.
+    for (const LapTrial& trial : trials) {
+        PhysicsVehicle::sharedBlueprint(trial.type);
+    }
+
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t i = next.fetch_add(1); i < trials.size(); i = next.fetch_add(1)) {
+            onResult(runLapTrial(trials[i], config));
+        }
+    };
+
+    std::vector<std::thread> workers;
+    const unsigned count = std::max(1u, std::min<unsigned>(threads, static_cast<unsigned>(trials.size())));
+    for (unsigned i = 0; i < count; ++i) {
+        workers.emplace_back(worker);
+    }
+    for (auto& thread : workers) {
+        thread.join();
+    }
+}
+
+const char* vehicleTypeName(VehicleType type) {
+    switch (type) {
+        case VehicleType::Kart: return "Kart";
+        case VehicleType::Sedan: return "Sedan";
+        case VehicleType::Truck: return "Truck";
+        case VehicleType::Tank: return "Tank";
+        case VehicleType::Motorcycle: return "Motorcycle";
+        default: return "Unknown";
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "PhysicsVehicle.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+struct LapTrial {
+    VehicleType type = VehicleType::Kart;
+    VehicleSettings settings;
+};
+
+struct LapRunConfig {
+    int laps = 2;
+    float timeout = 240.f;
+    float dt = 1.f / 60.f;
+};
+
+struct LapResult {
+    LapTrial trial;
+    int laps = 0;
+    // Seconds; zero when no full lap was completed.
+    float bestLap = 0.f;
+    float meanLap = 0.f;
+    float topSpeed = 0.f;
+    int steps = 0;
+    double wallSeconds = 0.0;
+    // Capacity counters from the trial's PhysicsWorld.
+    uint64_t physicsErrorSteps = 0;
+    size_t tempPeakBytes = 0;
+    uint64_t tempOverflows = 0;
+};
+
+// Drives a single vehicle around the ring track in its own PhysicsWorld with the
+// scripted racing-line driver and times laps at the start line.
+LapResult runLapTrial(const LapTrial& trial, const LapRunConfig& config);
+
+// Runs every trial on `threads` worker threads; `onResult` is called from the
+// worker threads, one call per finished trial.
+void runLapSweep(const std::vector<LapTrial>& trials, const LapRunConfig& config, unsigned threads,
+                 const std::function<void(const LapResult&)>& onResult);
+
+const char* vehicleTypeName(VehicleType type);
@@ -0,0 +1,67 @@
+#include "LatencyHistogram.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+LatencyHistogram::LatencyHistogram(uint64_t highest)
+    : highest_(std::max<uint64_t>(highest, 2 * SubBucketHalf)) {
+    counts_.assign(indexOf(highest_) + 1, 0);
+}
+
+// Values below 2048 index directly; above that, bucket b starts at 1024 << b.
+size_t LatencyHistogram::indexOf(uint64_t value) {
+    const int bucket = value < 2 * SubBucketHalf ? 0 : std::bit_width(value) - 1 - SubBucketBits;
+    return static_cast<size_t>(bucket) * SubBucketHalf + static_cast<size_t>(value >> bucket);
+}
+
+uint64_t LatencyHistogram::highestEquivalent(size_t index) {
+    const int bucket = index < 2 * SubBucketHalf ? 0 : static_cast<int>(index / SubBucketHalf) - 1;
+    const uint64_t sub = index - static_cast<size_t>(bucket) * SubBucketHalf;
+    return ((sub + 1) << bucket) - 1;
+}
+
+void LatencyHistogram::record(uint64_t value) {
+    if (value > highest_) {
+        value = highest_;
+        ++overflows_;
+    }
+    ++counts_[indexOf(value)];
+    ++count_;
+    sum_ += value;
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+}
+
+void LatencyHistogram::add(const LatencyHistogram& other) {
+    const size_t n = std::min(counts_.size(), other.counts_.size());
+    for (size_t i = 0; i < n; ++i) {
+        counts_[i] += other.counts_[i];
+    }
+    count_ += other.count_;
+    sum_ += other.sum_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+    overflows_ += other.overflows_;
+}
+
+void LatencyHistogram::reset() {
+    std::fill(counts_.begin(), counts_.end(), 0);
+    count_ = 0;
+    sum_ = 0;
+    min_ = UINT64_MAX;
+    max_ = 0;
+    overflows_ = 0;
+}
+
+uint64_t LatencyHistogram::valueAtPercentile(double percentile) const {
+    if (count_ == 0) return 0;
+    if (percentile >= 100.0) return max_;
+    const auto target = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(percentile / 100.0 * static_cast<double>(count_))));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts_.size(); ++i) {
+        seen += counts_[i];
+        if (seen >= target) return std::min(highestEquivalent(i), max_);
+    }
+    return max_;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// High-dynamic-range histogram of integer samples (e.g. microseconds) with three
+// significant digits, in the HdrHistogram layout: bucket b holds 1024 linear
+// sub-buckets of width 2^b, so recording is a shift and an increment and the
+// relative error stays under 0.1% from single units up to `highest`.
+class LatencyHistogram {
+public:
+    explicit LatencyHistogram(uint64_t highest = uint64_t(1) << 36);
+
+    // Values above `highest` are clamped to it and counted as overflows.
+    void record(uint64_t value);
+    // Merges a histogram created with the same `highest`.
+    void add(const LatencyHistogram& other);
+    void reset();
+
+    uint64_t count() const { return count_; }
+    uint64_t min() const { return count_ > 0 ? min_ : 0; }
+    uint64_t max() const { return max_; }
+    double mean() const { return count_ > 0 ? static_cast<double>(sum_) / static_cast<double>(count_) : 0.0; }
+    uint64_t overflows() const { return overflows_; }
+    // Upper bound of the bucket holding the sample at `percentile` (0-100).
+    // 100 returns the exact maximum.
+    uint64_t valueAtPercentile(double percentile) const;
+
+private:
+    static constexpr int SubBucketBits = 10;
+    static constexpr uint64_t SubBucketHalf = uint64_t(1) << SubBucketBits;
+
+    static size_t indexOf(uint64_t value);
+    static uint64_t highestEquivalent(size_t index);
+
+    std::vector<uint64_t> counts_;
+    uint64_t highest_;
+    uint64_t count_ = 0;
+    uint64_t sum_ = 0;
+    uint64_t min_ = UINT64_MAX;
+    uint64_t max_ = 0;
+    uint64_t overflows_ = 0;
+};
@@ -0,0 +1,135 @@
+#include "LidarSensors.h"
+
+#include <Jolt/Core/Color.h>
+#include <Jolt/Core/JobSystem.h>
+#include <Jolt/Physics/Body/BodyFilter.h>
+#include <Jolt/Physics/Collision/CastResult.h>
+#include <Jolt/Physics/Collision/NarrowPhaseQuery.h>
+#include <Jolt/Physics/Collision/RayCast.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+using namespace JPH;
+
+LidarSensors::LidarSensors(PhysicsWorld& world)
+    : world_(world) {}
+
+LidarSensors::SensorId LidarSensors::attach(BodyID body, const LidarConfig& config) {
+    const int channels = std::max(config.channels, 1);
+    const int samples = std::max(config.horizontalSamples, 1);
+    const size_t rays = static_cast<size_t>(channels) * samples;
+
+    // Reuse a detached sensor's slice when it has exactly as many rays, so churn
+    // between equal configs does not grow the buffer. Appending a new slice may
+    // reallocate it: offsets into buffer() stay valid, pointers do not.
+    SensorId id = -1;
+    for (size_t i = 0; i < freeSensors_.size(); ++i) {
+        if (sensors_[freeSensors_[i]].directions.size() == rays) {
+            id = freeSensors_[i];
+            freeSensors_.erase(freeSensors_.begin() + static_cast<std::ptrdiff_t>(i));
+            break;
+        }
+    }
+    if (id < 0) {
+        id = static_cast<SensorId>(sensors_.size());
+        sensors_.emplace_back();
+        sensors_.back().offset = buffer_.size();
+        buffer_.resize(buffer_.size() + rays);
+    }
+
+    Sensor& sensor = sensors_[id];
+    sensor.body = body;
+    sensor.config = config;
+    sensor.scans = 0;
+    sensor.alive = true;
+    // Spread first scans over one period so sensors do not all fire on the same frame.
+    const float period = 1.f / std::max(config.rateHz, 0.01f);
+    sensor.timer = period * static_cast<float>(id % 16) / 16.f;
+
+    sensor.directions.resize(rays);
+    for (int c = 0; c < channels; ++c) {
+        const float t = channels > 1 ? static_cast<float>(c) / static_cast<float>(channels - 1) : 0.5f;
+        const float elevation = DegreesToRadians(config.minElevation + t * (config.maxElevation - config.minElevation));
+        for (int h = 0; h < samples; ++h) {
+            const float azimuth = 2.f * JPH_PI * static_cast<float>(h) / static_cast<float>(samples);
+            // Azimuth 0 looks along the body's forward axis (+Z).
+            const Vec3 direction(std::cos(elevation) * std::sin(azimuth), std::sin(elevation), std::cos(elevation) * std::cos(azimuth));
+            sensor.directions[static_cast<size_t>(c) * samples + h] = direction * config.range;
+        }
+    }
+    std::fill(buffer_.begin() + static_cast<std::ptrdiff_t>(sensor.offset),
+              buffer_.begin() + static_cast<std::ptrdiff_t>(sensor.offset + rays), config.range);
+    return id;
+}
+
+void LidarSensors::detach(SensorId sensor) {
+    if (sensor < 0 || sensor >= static_cast<SensorId>(sensors_.size()) || !sensors_[sensor].alive) return;
+    sensors_[sensor].alive = false;
+    freeSensors_.push_back(sensor);
+}
+
+void LidarSensors::clear() {
+    sensors_.clear();
+    freeSensors_.clear();
+    buffer_.clear();
+}
+
+void LidarSensors::update(float dt) {
+    const auto start = std::chrono::steady_clock::now();
+    stats_.sensorsScanned = 0;
+    stats_.raysCast = 0;
+    stats_.jobs = 0;
+
+    jobs_.clear();
+
+    const BodyInterface& bodies = world_.system().GetBodyInterfaceNoLock();
+    for (Sensor& sensor : sensors_) {
+        if (!sensor.alive) continue;
+        sensor.timer -= dt;
+        if (sensor.timer > 0.f) continue;
+        sensor.timer += 1.f / std::max(sensor.config.rateHz, 0.01f);
+        if (!bodies.IsAdded(sensor.body)) continue;
+
+        RVec3 position;
+        Quat rotation;
+        bodies.GetPositionAndRotation(sensor.body, position, rotation);
+        const RVec3 origin = position + rotation * sensor.config.mount;
+
+        const int rays = static_cast<int>(sensor.directions.size());
+        for (int begin = 0; begin < rays; begin += raysPerJob_) {
+            jobs_.push_back({sensor.directions.data() + begin, buffer_.data() + sensor.offset + begin, origin, rotation,
+                            sensor.body, sensor.config.range, std::min(raysPerJob_, rays - begin)});
+        }
+        ++sensor.scans;
+        ++stats_.sensorsScanned;
+        stats_.raysCast += rays;
+    }
+    if (jobs_.empty()) {
+        stats_.scanMs = 0.f;
+        return;
+    }
+
+    const NarrowPhaseQuery& query = world_.system().GetNarrowPhaseQueryNoLock();
+    auto scan = [&query](const ScanJob& job) {
+        const IgnoreSingleBodyFilter self(job.body);
+        for (int i = 0; i < job.count; ++i) {
+            const RRayCast ray(job.origin, job.rotation * job.directions[i]);
+            RayCastResult hit;
+            job.out[i] = query.CastRay(ray, hit, {}, {}, self) ? hit.mFraction * job.range : job.range;
+        }
+    };
+
+    JobSystem& jobSystem = world_.jobSystem();
+    JobSystem::Barrier* barrier = jobSystem.CreateBarrier();
+    for (const ScanJob& job : jobs_) {
+        barrier->AddJob(jobSystem.CreateJob("LidarScan", Color::sGreen, [&scan, &job] { scan(job); }));
+    }
+    jobSystem.WaitForJobs(barrier);
+    jobSystem.DestroyBarrier(barrier);
+
+    stats_.jobs = static_cast<int>(jobs_.size());
+    stats_.scanMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    stats_.raysPerSecond = stats_.scanMs > 0.f ? stats_.raysCast * 1000.0 / stats_.scanMs : 0.0;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "PhysicsWorld.h"
+
+#include <cstdint>
+#include <vector>
+
+struct LidarConfig {
+    int channels = 32;
+    int horizontalSamples = 1024;
+    float range = 100.f;
+    float minElevation = -15.f; // degrees
+    float maxElevation = 15.f;
+    float rateHz = 10.f;
+    // Sensor origin in body space.
+    JPH::Vec3 mount = JPH::Vec3(0.f, 1.2f, 0.f);
+};
+
+// Ray-fan sensors attached to bodies. Sensors are staggered so only the ones due
+// this frame scan, and all of their rays are cast in one job-parallel batch on
+// the world's job system after the physics step. Ranges of every sensor live in
+// one contiguous float buffer; a ray that hits nothing reports the sensor range.
+class LidarSensors {
+public:
+    using SensorId = int;
+
+    struct Stats {
+        int sensorsScanned = 0;
+        int raysCast = 0;
+        int jobs = 0;
+        float scanMs = 0.f;
+        double raysPerSecond = 0.0;
+    };
+
+    explicit LidarSensors(PhysicsWorld& world);
+
+    SensorId attach(JPH::BodyID body, const LidarConfig& config);
+    void detach(SensorId sensor);
+    void clear();
+
+    // Advances sensor clocks and scans the sensors that are due. Must not overlap
+    // a physics step.
+    void update(float dt);
+
+    // channels x horizontalSamples ranges, one row per channel starting at the
+    // lowest elevation. The pointer is valid until the next attach(), which may
+    // grow the buffer; the sensor's offset into buffer() never changes.
+    const float* ranges(SensorId sensor) const { return buffer_.data() + sensors_[sensor].offset; }
+    size_t rangeOffset(SensorId sensor) const { return sensors_[sensor].offset; }
+    size_t rangeCount(SensorId sensor) const { return sensors_[sensor].directions.size(); }
+    const LidarConfig& config(SensorId sensor) const { return sensors_[sensor].config; }
+    // Number of completed scans, to detect fresh data.
+    uint32_t scans(SensorId sensor) const { return sensors_[sensor].scans; }
+    const std::vector<float>& buffer() const { return buffer_; }
+    size_t sensorCount() const { return sensors_.size() - freeSensors_.size(); }
+
+    // Rays per job; each job casts one contiguous slice of a single sensor.
+    void setRaysPerJob(int rays) { raysPerJob_ = rays < 64 ? 64 : rays; }
+    const Stats& stats() const { return stats_; }
+
+private:
+    struct Sensor {
+        JPH::BodyID body;
+        LidarConfig config;
+        std::vector<JPH::Vec3> directions; // body space, scaled by range
+        size_t offset = 0;
+        float timer = 0.f;
+        uint32_t scans = 0;
+        bool alive = false;
+    };
+
+    struct ScanJob {
+        const JPH::Vec3* directions;
+        float* out;
+        JPH::RVec3 origin;
+        JPH::Quat rotation;
+        JPH::BodyID body;
+        float range;
+        int count;
+    };
+
+    PhysicsWorld& world_;
+    std::vector<Sensor> sensors_;
+    std::vector<SensorId> freeSensors_;
+    std::vector<float> buffer_;
+    std::vector<ScanJob> jobs_;
+    int raysPerJob_ = 2048;
+    Stats stats_;
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// One mesh decoded from the startup cache into plain buffers. Holds no threepp
+// objects, so decoding can run on any thread; turning it into meshes cannot.
+struct MeshBuffers {
+    int32_t tag = -1;
+    bool lambert = false;
+    bool castShadow = false;
+    bool receiveShadow = false;
+    bool doubleSided = false;
+    float position[3] = {};
+    float quaternion[4] = {0.f, 0.f, 0.f, 1.f};
+    float scale[3] = {1.f, 1.f, 1.f};
+    float color[3] = {};
+    std::vector<float> positions;
+    std::vector<float> normals;
+    std::vector<float> uvs;
+    std::vector<unsigned int> indices;
+};
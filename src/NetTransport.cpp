@@ -0,0 +1,44 @@
+#include "NetTransport.h"
+
+#include <algorithm>
+
+LoopbackLink::LoopbackLink()
+    : LoopbackLink(Settings{}) {}
+
+LoopbackLink::LoopbackLink(const Settings& settings)
+    : settings_(settings) {
+    endpointA_ = std::make_unique<Endpoint>(*this, toA_, toB_);
+    endpointB_ = std::make_unique<Endpoint>(*this, toB_, toA_);
+}
+
+void LoopbackLink::setSettings(const Settings& settings) {
+    std::lock_guard lock(mutex_);
+    settings_ = settings;
+}
+
+void LoopbackLink::Endpoint::send(const uint8_t* data, size_t size) {
+    std::lock_guard lock(link_.mutex_);
+    const auto& s = link_.settings_;
+    std::uniform_real_distribution<float> unit(0.f, 1.f);
+    if (unit(link_.random_) < s.lossRate) return;
+
+    const float delayMs = std::max(0.f, s.latencyMs + (unit(link_.random_) * 2.f - 1.f) * s.jitterMs);
+    Packet packet;
+    packet.deliverAt = Clock::now() + std::chrono::microseconds(static_cast<int64_t>(delayMs * 1000.f));
+    packet.data.assign(data, data + size);
+
+    // Keep the queue ordered by delivery time; jitter can reorder packets just
+    // like a real network.
+    auto it = std::upper_bound(outbox_.begin(), outbox_.end(), packet.deliverAt,
+                               [](Clock::time_point t, const Packet& p) { return t < p.deliverAt; });
+    outbox_.insert(it, std::move(packet));
+}
+
+bool LoopbackLink::Endpoint::receive(std::vector<uint8_t>& packet) {
+    std::lock_guard lock(link_.mutex_);
+    if (inbox_.empty() || inbox_.front().deliverAt > Clock::now()) return false;
+
+    packet = std::move(inbox_.front().data);
+    inbox_.pop_front();
+    return true;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <vector>
+
+// Unreliable, unordered datagram transport used by the rollback layer.
+class NetTransport {
+public:
+    virtual ~NetTransport() = default;
+
+    virtual void send(const uint8_t* data, size_t size) = 0;
+    // Pops the next packet that has arrived; returns false when none is ready.
+    virtual bool receive(std::vector<uint8_t>& packet) = 0;
+};
+
+// In-process pair of connected endpoints with simulated latency, jitter and loss,
+// for exercising the rollback layer without a network.
+class LoopbackLink {
+public:
+    struct Settings {
+        float latencyMs = 80.f;
+        float jitterMs = 10.f;
+        float lossRate = 0.f;
+    };
+
+    LoopbackLink();
+    explicit LoopbackLink(const Settings& settings);
+
+    NetTransport& endpointA() { return *endpointA_; }
+    NetTransport& endpointB() { return *endpointB_; }
+
+    void setSettings(const Settings& settings);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Packet {
+        Clock::time_point deliverAt;
+        std::vector<uint8_t> data;
+    };
+
+    class Endpoint final : public NetTransport {
+    public:
+        Endpoint(LoopbackLink& link, std::deque<Packet>& inbox, std::deque<Packet>& outbox)
+            : link_(link), inbox_(inbox), outbox_(outbox) {}
+
+        void send(const uint8_t* data, size_t size) override;
+        bool receive(std::vector<uint8_t>& packet) override;
+
+    private:
+        LoopbackLink& link_;
+        std::deque<Packet>& inbox_;
+        std::deque<Packet>& outbox_;
+    };
+
+    std::mutex mutex_;
+    Settings settings_;
+    std::mt19937 random_{12345};
+    std::deque<Packet> toA_;
+    std::deque<Packet> toB_;
+    std::unique_ptr<Endpoint> endpointA_;
+    std::unique_ptr<Endpoint> endpointB_;
+};
@@ -1,5 +1,10 @@
 #include "PhysicsVehicle.h"
+#include "StartupCache.h"
+#include "VehicleArchetypes.h"
+#include "VehicleTelemetry.h"
 
+#include <Jolt/Core/StreamIn.h>
+#include <Jolt/Core/StreamOut.h>
 #include <Jolt/Physics/Body/BodyCreationSettings.h>
 #include <Jolt/Physics/Body/BodyInterface.h>
 #include <Jolt/Physics/Collision/Shape/BoxShape.h>
@@ -11,81 +16,100 @@
 #include <Jolt/Physics/Vehicle/WheeledVehicleController.h>
 
 #include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstring>
+#include <mutex>
+#include <utility>
 
 using namespace JPH;
 
-PhysicsVehicle::PhysicsVehicle(PhysicsWorld& world, VehicleModel& model, VehicleType type, const RVec3& position)
-    : world_(world), model_(model), type_(type) {
-
-    Vec3 halfExtent(1.0f, 0.5f, 2.0f);
-    float wheelRadius = 0.4f;
-    float wheelWidth = 0.3f;
-    switch (type_) {
-        case VehicleType::Kart:
-            // Match visual body size: 1.2 x 0.4 x 2.2
-            halfExtent = Vec3(0.6f, 0.2f, 1.1f);
-            wheelRadius = 0.35f;
-            wheelWidth = 0.25f;
-            settings_.mass = 450.f;
-            settings_.engineForce = 4500.f;
-            settings_.maxSpeed = 22.f;
-            settings_.steerTorque = 1200.f;
-            break;
-        case VehicleType::Sedan:
-            // Match visual body size: 1.6 x 0.6 x 3.6
-            halfExtent = Vec3(0.8f, 0.3f, 1.8f);
-            wheelRadius = 0.45f;
-            wheelWidth = 0.3f;
-            settings_.mass = 1100.f;
-            settings_.engineForce = 8000.f;
-            settings_.maxSpeed = 26.f;
-            settings_.steerTorque = 1800.f;
-            break;
-        case VehicleType::Truck:
-            // Match visual body size: 2.0 x 0.8 x 5.2
-            halfExtent = Vec3(1.0f, 0.4f, 2.6f);
-            wheelRadius = 0.55f;
-            wheelWidth = 0.35f;
-            settings_.mass = 2600.f;
-            settings_.engineForce = 12000.f;
-            settings_.maxSpeed = 18.f;
-            settings_.steerTorque = 1400.f;
-            break;
-        case VehicleType::Tank:
-            // Match visual body size: 3.4 x 1.0 x 6.4
-            halfExtent = Vec3(1.7f, 0.5f, 3.2f);
-            wheelRadius = 0.3f;
-            wheelWidth = 0.1f;
-            settings_.mass = 4000.f;
-            settings_.engineForce = 15000.f;
-            settings_.maxSpeed = 14.f;
-            settings_.steerTorque = 0.f;
-            break;
-        case VehicleType::Motorcycle:
-            // Match visual body size: 0.5 x 0.6 x 1.6
-            halfExtent = Vec3(0.25f, 0.3f, 0.8f);
-            wheelRadius = 0.31f;
-            wheelWidth = 0.05f;
-            settings_.mass = 240.f;
-            settings_.engineForce = 3500.f;
-            settings_.maxSpeed = 28.f;
-            settings_.steerTorque = 1000.f;
-            break;
-        default:
-            break;
+namespace {
+
+class BlobStreamOut final : public StreamOut {
+public:
+    void WriteBytes(const void* data, size_t numBytes) override {
+        const auto* begin = static_cast<const uint8_t*>(data);
+        bytes.insert(bytes.end(), begin, begin + numBytes);
+    }
+    bool IsFailed() const override { return false; }
+
+    std::vector<uint8_t> bytes;
+};
+
+class BlobStreamIn final : public StreamIn {
+public:
+    explicit BlobStreamIn(std::span<const uint8_t> data) : data_(data) {}
+
+    void ReadBytes(void* out, size_t numBytes) override {
+        if (data_.size() - cursor_ < numBytes) {
+            std::memset(out, 0, numBytes);
+            failed_ = true;
+            return;
+        }
+        std::memcpy(out, data_.data() + cursor_, numBytes);
+        cursor_ += numBytes;
     }
-    // Match Jolt demo: motorcycle uses a slightly different COM offset.
-    float comOffset = -0.9f * halfExtent.GetY();
-    float wheelBaseY = comOffset;
-    if (type_ == VehicleType::Motorcycle) {
-        comOffset = -halfExtent.GetY();
-        wheelBaseY = -0.9f * halfExtent.GetY();
+    bool IsEOF() const override { return cursor_ >= data_.size(); }
+    bool IsFailed() const override { return failed_; }
+
+private:
+    std::span<const uint8_t> data_;
+    size_t cursor_ = 0;
+    bool failed_ = false;
+};
+
+std::mutex blueprintMutex;
+const StartupCache* blueprintSource = nullptr;
+std::array<VehicleBlueprint, vehicleArchetypes.size()> sharedBlueprints;
+
+RefConst<VehicleConstraintSettings> withBrakeForce(const VehicleConstraintSettings& source, float brakeForce) {
+    Ref<VehicleConstraintSettings> settings = new VehicleConstraintSettings(source);
+    for (Ref<WheelSettings>& wheel : settings->mWheels) {
+        auto* patched = new WheelSettingsWV(static_cast<const WheelSettingsWV&>(*wheel));
+        patched->mMaxBrakeTorque = brakeForce;
+        if (patched->mMaxHandBrakeTorque > 0.f) patched->mMaxHandBrakeTorque = brakeForce * 2.0f;
+        wheel = patched;
+    }
+    return settings;
+}
+
+// Whether the wheeled blueprint built from the procedural model also fits
+// `model`; only the wheels' horizontal placement reaches the blueprint. A model
+// without wheels, as used headless, takes the shared blueprint.
+bool wheelsMatch(const VehicleConstraintSettings& settings, const VehicleModel& model) {
+    if (model.wheels.empty()) return true;
+    if (model.wheels.size() != settings.mWheels.size()) return false;
+    constexpr float tolerance = 1e-4f;
+    for (size_t i = 0; i < model.wheels.size(); ++i) {
+        const Vec3 position = settings.mWheels[i]->mPosition;
+        const auto& wheel = model.wheels[i]->position;
+        if (std::abs(position.GetX() - wheel.x) > tolerance || std::abs(position.GetZ() - wheel.z) > tolerance) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+PhysicsVehicle::PhysicsVehicle(PhysicsWorld& world, VehicleModel model, VehicleType type, const RVec3& position,
+                               const VehicleSettings* overrides, bool addToWorld)
+    : world_(world), model_(std::move(model)), type_(type),
+      settings_(overrides ? *overrides : defaultSettings(type)), buildSettings_(settings_) {
+
+    const VehicleArchetypeParams& params = archetypeParams(type_);
+    VehicleBlueprint blueprint = sharedBlueprint(type_);
+    if (params.drivetrain == Drivetrain::Wheeled && !wheelsMatch(*blueprint.constraint, model_)) {
+        // A custom model places its wheels differently, so it gets its own.
+        blueprint = buildBlueprint(type_, model_, settings_);
+    } else if (params.drivetrain == Drivetrain::Wheeled && settings_.brakeForce != defaultSettings(type_).brakeForce) {
+        // Shared blueprints are built with the default brakes.
+        blueprint.constraint = withBrakeForce(*blueprint.constraint, settings_.brakeForce);
     }
-    auto shape = OffsetCenterOfMassShapeSettings(Vec3(0, comOffset, 0), new BoxShape(halfExtent)).Create().Get();
 
     BodyCreationSettings bodySettings(
-        shape,
+        blueprint.chassis.GetPtr(),
         position,
         Quat::sIdentity(),
         EMotionType::Dynamic,
@@ -99,15 +123,385 @@ PhysicsVehicle::PhysicsVehicle(PhysicsWorld& world, VehicleModel& model, Vehicle
     BodyInterface& bodyInterface = world_.bodyInterface();
     body_ = bodyInterface.CreateBody(bodySettings);
     bodyId_ = body_->GetID();
-    bodyInterface.AddBody(bodyId_, EActivation::Activate);
+    if (addToWorld) {
+        bodyInterface.AddBody(bodyId_, EActivation::Activate);
+    }
+
+    wheelRights_.assign(blueprint.constraint->mWheels.size(), Vec3::sAxisY());
+    vehicleConstraint_ = new VehicleConstraint(*body_, *blueprint.constraint);
+    if (params.drivetrain == Drivetrain::Motorcycle) {
+        collisionTester_ = new VehicleCollisionTesterCastCylinder(PhysicsLayers::Dynamic, 0.5f * params.wheelWidth);
+    } else {
+        collisionTester_ = new VehicleCollisionTesterCastCylinder(PhysicsLayers::Dynamic);
+    }
+    vehicleConstraint_->SetVehicleCollisionTester(collisionTester_);
+
+    controllerBase_ = vehicleConstraint_->GetController();
+    if (params.drivetrain == Drivetrain::Wheeled) {
+        controller_ = static_cast<WheeledVehicleController*>(controllerBase_);
+    }
+    if (addToWorld) {
+        world_.system().AddConstraint(vehicleConstraint_);
+        world_.system().AddStepListener(vehicleConstraint_);
+    } else {
+        inWorld_ = false;
+    }
+}
+
+PhysicsVehicle::~PhysicsVehicle() {
+    removeFromWorld();
+    vehicleConstraint_ = nullptr;
+    if (body_) {
+        world_.bodyInterface().DestroyBody(bodyId_);
+        body_ = nullptr;
+    }
+}
+
+void PhysicsVehicle::removeFromWorld() {
+    if (!inWorld_) return;
+
+    world_.system().RemoveStepListener(vehicleConstraint_);
+    world_.system().RemoveConstraint(vehicleConstraint_);
+    world_.bodyInterface().RemoveBody(bodyId_);
+    inWorld_ = false;
+}
+
+void PhysicsVehicle::addToWorld(const RVec3& position, const Quat& rotation) {
+    if (inWorld_) return;
+
+    resetForAdd(position, rotation);
+    world_.bodyInterface().AddBody(bodyId_, EActivation::Activate);
+    world_.system().AddConstraint(vehicleConstraint_);
+    world_.system().AddStepListener(vehicleConstraint_);
+    inWorld_ = true;
+}
+
+void PhysicsVehicle::addToWorldBatch(std::span<PhysicsVehicle* const> vehicles, std::span<const RVec3> positions,
+                                     std::span<const Quat> rotations) {
+    if (vehicles.empty()) return;
+
+    PhysicsWorld& world = vehicles.front()->world_;
+    BodyIDVector bodies;
+    Array<Constraint*> constraints;
+    bodies.reserve(vehicles.size());
+    constraints.reserve(vehicles.size());
+    for (size_t i = 0; i < vehicles.size(); ++i) {
+        PhysicsVehicle& vehicle = *vehicles[i];
+        if (vehicle.inWorld_) continue;
+        vehicle.resetForAdd(positions[i], rotations[i]);
+        bodies.push_back(vehicle.bodyId_);
+        constraints.push_back(vehicle.vehicleConstraint_);
+    }
+    if (bodies.empty()) return;
+
+    // One broadphase tree build for the whole batch instead of one insertion per body.
+    BodyInterface& bodyInterface = world.bodyInterface();
+    const int count = static_cast<int>(bodies.size());
+    BodyInterface::AddState state = bodyInterface.AddBodiesPrepare(bodies.data(), count);
+    bodyInterface.AddBodiesFinalize(bodies.data(), count, state, EActivation::Activate);
+
+    world.system().AddConstraints(constraints.data(), count);
+    for (PhysicsVehicle* vehicle : vehicles) {
+        if (vehicle->inWorld_) continue;
+        world.system().AddStepListener(vehicle->vehicleConstraint_);
+        vehicle->inWorld_ = true;
+    }
+}
+
+void PhysicsVehicle::resetForAdd(const RVec3& position, const Quat& rotation) {
+    BodyInterface& bodyInterface = world_.bodyInterface();
+    bodyInterface.SetPositionAndRotation(bodyId_, position, rotation, EActivation::DontActivate);
+    bodyInterface.SetLinearAndAngularVelocity(bodyId_, Vec3::sZero(), Vec3::sZero());
+
+    for (Wheel* wheel : vehicleConstraint_->GetWheels()) {
+        wheel->SetAngularVelocity(0.f);
+        wheel->SetRotationAngle(0.f);
+        wheel->SetSteerAngle(0.f);
+    }
+    if (archetypeParams(type_).drivetrain == Drivetrain::Tracked) {
+        auto* tracked = static_cast<TrackedVehicleController*>(controllerBase_);
+        tracked->SetDriverInput(0.f, 1.f, 1.f, 0.f);
+        tracked->GetEngine().SetCurrentRPM(tracked->GetEngine().mMinRPM);
+        tracked->GetTransmission().Set(0, 0.f);
+        for (VehicleTrack& track : tracked->GetTracks()) {
+            track.mAngularVelocity = 0.f;
+        }
+    } else {
+        // MotorcycleController derives from WheeledVehicleController.
+        auto* wheeled = static_cast<WheeledVehicleController*>(controllerBase_);
+        wheeled->SetDriverInput(0.f, 0.f, 0.f, 0.f);
+        wheeled->GetEngine().SetCurrentRPM(wheeled->GetEngine().mMinRPM);
+        wheeled->GetTransmission().Set(0, 0.f);
+    }
+}
+
+void PhysicsVehicle::captureState(VehicleState& state) const {
+    const BodyInterface& bodyInterface = world_.bodyInterface();
+    bodyInterface.GetPositionAndRotation(bodyId_, state.position, state.rotation);
+    bodyInterface.GetLinearAndAngularVelocity(bodyId_, state.linearVelocity, state.angularVelocity);
+
+    const auto& wheels = vehicleConstraint_->GetWheels();
+    state.wheelAngularVelocity.resize(wheels.size());
+    state.wheelSteerAngle.resize(wheels.size());
+    for (size_t i = 0; i < wheels.size(); ++i) {
+        state.wheelAngularVelocity[i] = wheels[i]->GetAngularVelocity();
+        state.wheelSteerAngle[i] = wheels[i]->GetSteerAngle();
+    }
+
+    if (archetypeParams(type_).drivetrain == Drivetrain::Tracked) {
+        const auto* tracked = static_cast<const TrackedVehicleController*>(controllerBase_);
+        state.engineRpm = tracked->GetEngine().GetCurrentRPM();
+        state.gear = tracked->GetTransmission().GetCurrentGear();
+        state.clutchFriction = tracked->GetTransmission().GetClutchFriction();
+        for (int track = 0; track < 2; ++track) {
+            state.trackAngularVelocity[track] = tracked->GetTracks()[track].mAngularVelocity;
+        }
+    } else {
+        // MotorcycleController derives from WheeledVehicleController.
+        const auto* wheeled = static_cast<const WheeledVehicleController*>(controllerBase_);
+        state.engineRpm = wheeled->GetEngine().GetCurrentRPM();
+        state.gear = wheeled->GetTransmission().GetCurrentGear();
+        state.clutchFriction = wheeled->GetTransmission().GetClutchFriction();
+    }
+}
+
+void PhysicsVehicle::restoreState(const VehicleState& state) {
+    BodyInterface& bodyInterface = world_.bodyInterface();
+    bodyInterface.SetPositionAndRotation(bodyId_, state.position, state.rotation, EActivation::Activate);
+    bodyInterface.SetLinearAndAngularVelocity(bodyId_, state.linearVelocity, state.angularVelocity);
+
+    const auto& wheels = vehicleConstraint_->GetWheels();
+    const size_t count = std::min(wheels.size(), state.wheelAngularVelocity.size());
+    for (size_t i = 0; i < count; ++i) {
+        wheels[i]->SetAngularVelocity(state.wheelAngularVelocity[i]);
+        wheels[i]->SetSteerAngle(state.wheelSteerAngle[i]);
+    }
+
+    if (archetypeParams(type_).drivetrain == Drivetrain::Tracked) {
+        auto* tracked = static_cast<TrackedVehicleController*>(controllerBase_);
+        tracked->GetEngine().SetCurrentRPM(state.engineRpm);
+        tracked->GetTransmission().Set(state.gear, state.clutchFriction);
+        for (int track = 0; track < 2; ++track) {
+            tracked->GetTracks()[track].mAngularVelocity = state.trackAngularVelocity[track];
+        }
+    } else {
+        auto* wheeled = static_cast<WheeledVehicleController*>(controllerBase_);
+        wheeled->GetEngine().SetCurrentRPM(state.engineRpm);
+        wheeled->GetTransmission().Set(state.gear, state.clutchFriction);
+    }
+}
+
+void PhysicsVehicle::saveConstraintState(StateRecorder& stream) const {
+    vehicleConstraint_->SaveState(stream);
+}
+
+void PhysicsVehicle::restoreConstraintState(StateRecorder& stream) {
+    vehicleConstraint_->RestoreState(stream);
+}
+
+void PhysicsVehicle::applyInput(const VehicleInput& input) {
+    withArchetype(type_, [&](auto archetype) { applyInputAs<decltype(archetype)>(input); });
+}
+
+void PhysicsVehicle::applyInputBatch(VehicleType type, std::span<PhysicsVehicle* const> vehicles, std::span<const VehicleInput> inputs) {
+    withArchetype(type, [&](auto archetype) {
+        for (size_t i = 0; i < vehicles.size(); ++i) {
+            vehicles[i]->applyInputAs<decltype(archetype)>(inputs[i]);
+        }
+    });
+}
+
+template<typename Archetype>
+void PhysicsVehicle::applyInputAs(const VehicleInput& input) {
+    if (!controllerBase_) return;
+
+    BodyInterface& bodyInterface = world_.bodyInterface();
+    bodyInterface.ActivateBody(bodyId_);
+
+    Vec3 velocity = bodyInterface.GetLinearVelocity(bodyId_);
+    Quat rotation = bodyInterface.GetRotation(bodyId_);
+    Vec3 forward = rotation * Vec3::sAxisZ();
+    float forwardSpeed = velocity.Dot(forward);
+
+    float throttle = input.throttle;
+    if (std::abs(forwardSpeed) > settings_.maxSpeed) {
+        throttle = 0.f;
+    }
+
+    float brake = input.brake ? 1.f : 0.f;
+    if (throttle * forwardSpeed < -0.1f) {
+        brake = std::max(brake, 1.f);
+        throttle = 0.f;
+    } else if (std::abs(throttle) < 0.01f && std::abs(forwardSpeed) > 0.1f) {
+        brake = std::max(brake, 0.3f);
+    }
+
+    if constexpr (Archetype::drivetrain == Drivetrain::Tracked) {
+        auto* tracked = static_cast<TrackedVehicleController*>(controllerBase_);
+        tracked->GetEngine().mMaxTorque = settings_.engineForce;
+
+        const float minVelocityPivotTurn = 1.0f;
+        float leftRatio = 1.0f;
+        float rightRatio = 1.0f;
+
+        if (std::abs(input.steer) > 0.01f) {
+            if (brake < 0.01f && std::abs(throttle) < 0.01f && std::abs(forwardSpeed) < minVelocityPivotTurn) {
+                // Pivot turn like Jolt demo
+                throttle = 1.0f;
+                leftRatio = input.steer < 0.f ? -1.0f : 1.0f;
+                rightRatio = input.steer < 0.f ? 1.0f : -1.0f;
+            } else if (input.steer < -0.01f) {
+                leftRatio = 0.6f;
+            } else if (input.steer > 0.01f) {
+                rightRatio = 0.6f;
+            }
+        }
+
+        tracked->SetDriverInput(throttle, leftRatio, rightRatio, brake);
+    } else if constexpr (Archetype::drivetrain == Drivetrain::Motorcycle) {
+        auto* motorcycle = static_cast<MotorcycleController*>(controllerBase_);
+        motorcycle->GetEngine().mMaxTorque = settings_.engineForce;
+        motorcycle->SetDriverInput(throttle, input.steer, brake, input.handbrake);
+        motorcycle->EnableLeanController(true);
+    } else {
+        controller_->GetEngine().mMaxTorque = settings_.engineForce;
+        controller_->SetDriverInput(throttle, input.steer, brake, input.handbrake ? 1.f : 0.f);
+    }
+}
+
+void PhysicsVehicle::syncVisual() {
+    BodyInterface& bodyInterface = world_.bodyInterface();
+    RVec3 position = bodyInterface.GetPosition(bodyId_);
+    Quat rotation = bodyInterface.GetRotation(bodyId_);
+
+    model_.group->position.set(position.GetX(), position.GetY(), position.GetZ());
+    model_.group->quaternion.set(rotation.GetX(), rotation.GetY(), rotation.GetZ(), rotation.GetW());
+
+    if (!vehicleConstraint_) return;
+    for (size_t i = 0; i < model_.wheels.size(); ++i) {
+        Mat44 transform = wheelLocalTransform(i);
+        Vec3 t = transform.GetTranslation();
+        Quat q = transform.GetQuaternion();
+        auto& wheel = model_.wheels[i];
+        wheel->position.set(t.GetX(), t.GetY(), t.GetZ());
+        wheel->quaternion.set(q.GetX(), q.GetY(), q.GetZ(), q.GetW());
+    }
+}
+
+Mat44 PhysicsVehicle::wheelLocalTransform(size_t wheel) const {
+    return vehicleConstraint_->GetWheelLocalTransform(static_cast<uint>(wheel), wheelRights_[wheel], Vec3::sAxisX());
+}
+
+bool PhysicsVehicle::wheelHasContact(size_t wheel) const {
+    return vehicleConstraint_->GetWheels()[wheel]->HasContact();
+}
+
+void PhysicsVehicle::sampleTelemetry(VehicleTelemetrySample& sample) const {
+    sample.type = static_cast<uint8_t>(type_);
+    sample.speed = speed();
+
+    const bool isTracked = archetypeParams(type_).drivetrain == Drivetrain::Tracked;
+    if (isTracked) {
+        const auto* tracked = static_cast<const TrackedVehicleController*>(controllerBase_);
+        sample.engineRpm = tracked->GetEngine().GetCurrentRPM();
+        sample.gear = static_cast<int8_t>(tracked->GetTransmission().GetCurrentGear());
+    } else {
+        // MotorcycleController derives from WheeledVehicleController.
+        const auto* wheeled = static_cast<const WheeledVehicleController*>(controllerBase_);
+        sample.engineRpm = wheeled->GetEngine().GetCurrentRPM();
+        sample.gear = static_cast<int8_t>(wheeled->GetTransmission().GetCurrentGear());
+    }
+
+    const auto& wheels = vehicleConstraint_->GetWheels();
+    const size_t count = std::min<size_t>(wheels.size(), VehicleTelemetrySample::MaxWheels);
+    sample.wheelCount = static_cast<uint8_t>(count);
+    for (size_t i = 0; i < count; ++i) {
+        const Wheel* wheel = wheels[i];
+        WheelTelemetry& out = sample.wheels[i];
+        out.suspensionLength = wheel->GetSuspensionLength();
+        out.angularVelocity = wheel->GetAngularVelocity();
+        out.contact = wheel->HasContact();
+        if (isTracked) {
+            out.longitudinalSlip = 0.f;
+            out.lateralSlip = 0.f;
+        } else {
+            const auto* wv = static_cast<const WheelWV*>(wheel);
+            out.longitudinalSlip = wv->mLongitudinalSlip;
+            out.lateralSlip = wv->mLateralSlip;
+        }
+    }
+}
+
+float PhysicsVehicle::speed() const {
+    Vec3 velocity = world_.bodyInterface().GetLinearVelocity(bodyId_);
+    return velocity.Length();
+}
+
+RVec3 PhysicsVehicle::position() const {
+    return world_.bodyInterface().GetPosition(bodyId_);
+}
+
+Quat PhysicsVehicle::rotation() const {
+    return world_.bodyInterface().GetRotation(bodyId_);
+}
+
+Vec3 PhysicsVehicle::velocity() const {
+    return world_.bodyInterface().GetLinearVelocity(bodyId_);
+}
 
-    VehicleConstraintSettings vehicleSettings;
+VehicleSettings& PhysicsVehicle::settings() {
+    return settings_;
+}
+
+VehicleType PhysicsVehicle::type() const {
+    return type_;
+}
+
+VehicleSettings PhysicsVehicle::defaultSettings(VehicleType type) {
+    const VehicleArchetypeParams& params = archetypeParams(type);
+    VehicleSettings settings;
+    settings.mass = params.mass;
+    settings.engineForce = params.engineForce;
+    settings.maxSpeed = params.maxSpeed;
+    settings.steerTorque = params.steerTorque;
+    return settings;
+}
+
+float PhysicsVehicle::spawnHeight(VehicleType type) {
+    return archetypeParams(type).spawnHeight();
+}
+
+VehicleBlueprint PhysicsVehicle::sharedBlueprint(VehicleType type) {
+    const auto cache = StartupCache::active();
+    std::lock_guard lock(blueprintMutex);
+    if (cache.get() != blueprintSource) {
+        sharedBlueprints = {};
+        blueprintSource = cache.get();
+    }
+
+    VehicleBlueprint& blueprint = sharedBlueprints[static_cast<size_t>(type)];
+    if (!blueprint.chassis && !(cache && restoreBlueprint(cache->find(vehicleBlueprintKey(type), BlueprintRevision), blueprint))) {
+        blueprint = buildBlueprint(type, VehicleFactory::createProcedural(type), defaultSettings(type));
+    }
+    return blueprint;
+}
+
+VehicleBlueprint PhysicsVehicle::buildBlueprint(VehicleType type, const VehicleModel& model, const VehicleSettings& settings) {
+    const VehicleArchetypeParams& params = archetypeParams(type);
+    const Vec3 halfExtent(params.halfX, params.halfY, params.halfZ);
+    const float wheelRadius = params.wheelRadius;
+    const float wheelWidth = params.wheelWidth;
+    const float comOffset = params.comOffset();
+    const float wheelBaseY = params.wheelBaseY();
+    auto shape = OffsetCenterOfMassShapeSettings(Vec3(0, comOffset, 0), new BoxShape(halfExtent)).Create().Get();
+
+    Ref<VehicleConstraintSettings> constraint = new VehicleConstraintSettings;
+    VehicleConstraintSettings& vehicleSettings = *constraint;
     vehicleSettings.mMaxPitchRollAngle = JPH_PI / 3.f;
 
-    vehicleSettings.mWheels.reserve(model_.wheels.size());
-    wheelRights_.reserve(model_.wheels.size());
+    vehicleSettings.mWheels.reserve(model.wheels.size());
 
-    if (type_ == VehicleType::Tank) {
+    if (params.drivetrain == Drivetrain::Tracked) {
         auto* controllerSettings = new TrackedVehicleControllerSettings;
         vehicleSettings.mController = controllerSettings;
 
@@ -134,10 +528,9 @@ PhysicsVehicle::PhysicsVehicle(PhysicsWorld& world, VehicleModel& model, Vehicle
 
                 trackSettings.mWheels.push_back(static_cast<uint>(vehicleSettings.mWheels.size()));
                 vehicleSettings.mWheels.push_back(w);
-                wheelRights_.push_back(Vec3::sAxisY());
             }
         }
-    } else if (type_ == VehicleType::Motorcycle) {
+    } else if (params.drivetrain == Drivetrain::Motorcycle) {
         const float frontWheelPosZ = 0.75f;
         const float backWheelPosZ = -0.75f;
         const float casterAngle = DegreesToRadians(30.0f);
@@ -175,8 +568,6 @@ PhysicsVehicle::PhysicsVehicle(PhysicsWorld& world, VehicleModel& model, Vehicle
         back->mMaxBrakeTorque = 250.0f;
 
         vehicleSettings.mWheels = {front, back};
-        wheelRights_.push_back(Vec3::sAxisY());
-        wheelRights_.push_back(Vec3::sAxisY());
 
         auto* controllerSettings = new MotorcycleControllerSettings;
         controllerSettings->mEngine.mMaxTorque = 150.0f;
@@ -198,7 +589,7 @@ PhysicsVehicle::PhysicsVehicle(PhysicsWorld& world, VehicleModel& model, Vehicle
         Vec3 wheelUp(0, 1, 0);
         Vec3 wheelForward(0, 0, 1);
 
-        for (const auto& wheel : model_.wheels) {
+        for (const auto& wheel : model.wheels) {
             auto* w = new WheelSettingsWV;
             // Keep wheel center relative to COM so that tire bottom sits near ground.
             w->mPosition = Vec3(wheel->position.x, wheelBaseY, wheel->position.z);
@@ -214,11 +605,10 @@ PhysicsVehicle::PhysicsVehicle(PhysicsWorld& world, VehicleModel& model, Vehicle
             w->mRadius = wheelRadius;
             w->mWidth = wheelWidth;
             w->mMaxSteerAngle = (wheel->position.z > 0) ? (JPH_PI / 6.f) : 0.f;
-            w->mMaxBrakeTorque = settings_.brakeForce;
-            w->mMaxHandBrakeTorque = (wheel->position.z > 0) ? 0.f : (settings_.brakeForce * 2.0f);
+            w->mMaxBrakeTorque = settings.brakeForce;
+            w->mMaxHandBrakeTorque = (wheel->position.z > 0) ? 0.f : (settings.brakeForce * 2.0f);
 
             vehicleSettings.mWheels.push_back(w);
-            wheelRights_.push_back(Vec3::sAxisY());
         }
 
         auto* controllerSettings = new WheeledVehicleControllerSettings;
@@ -247,160 +637,32 @@ PhysicsVehicle::PhysicsVehicle(PhysicsWorld& world, VehicleModel& model, Vehicle
         }
     }
 
-    vehicleConstraint_ = new VehicleConstraint(*body_, vehicleSettings);
-    if (type_ == VehicleType::Motorcycle) {
-        collisionTester_ = new VehicleCollisionTesterCastCylinder(PhysicsLayers::Dynamic, 0.5f * wheelWidth);
-    } else {
-        collisionTester_ = new VehicleCollisionTesterCastCylinder(PhysicsLayers::Dynamic);
-    }
-    vehicleConstraint_->SetVehicleCollisionTester(collisionTester_);
-
-    world_.system().AddConstraint(vehicleConstraint_);
-    world_.system().AddStepListener(vehicleConstraint_);
-    controllerBase_ = vehicleConstraint_->GetController();
-    if (type_ != VehicleType::Tank && type_ != VehicleType::Motorcycle) {
-        controller_ = static_cast<WheeledVehicleController*>(controllerBase_);
-    }
-}
-
-PhysicsVehicle::~PhysicsVehicle() {
-    if (vehicleConstraint_) {
-        world_.system().RemoveStepListener(vehicleConstraint_);
-        world_.system().RemoveConstraint(vehicleConstraint_);
-        vehicleConstraint_ = nullptr;
-    }
-    if (body_) {
-        BodyInterface& bodyInterface = world_.bodyInterface();
-        bodyInterface.RemoveBody(bodyId_);
-        bodyInterface.DestroyBody(bodyId_);
-        body_ = nullptr;
-    }
-}
-
-void PhysicsVehicle::applyInput(const VehicleInput& input) {
-    if (!controllerBase_) return;
-
-    BodyInterface& bodyInterface = world_.bodyInterface();
-    bodyInterface.ActivateBody(bodyId_);
-
-    Vec3 velocity = bodyInterface.GetLinearVelocity(bodyId_);
-    Quat rotation = bodyInterface.GetRotation(bodyId_);
-    Vec3 forward = rotation * Vec3::sAxisZ();
-    float forwardSpeed = velocity.Dot(forward);
-
-    float throttle = input.throttle;
-    if (std::abs(forwardSpeed) > settings_.maxSpeed) {
-        throttle = 0.f;
-    }
-
-    float brake = input.brake ? 1.f : 0.f;
-    if (throttle * forwardSpeed < -0.1f) {
-        brake = std::max(brake, 1.f);
-        throttle = 0.f;
-    } else if (std::abs(throttle) < 0.01f && std::abs(forwardSpeed) > 0.1f) {
-        brake = std::max(brake, 0.3f);
-    }
-
-    if (type_ == VehicleType::Tank) {
-        auto* tracked = static_cast<TrackedVehicleController*>(controllerBase_);
-        tracked->GetEngine().mMaxTorque = settings_.engineForce;
-
-        const float minVelocityPivotTurn = 1.0f;
-        float leftRatio = 1.0f;
-        float rightRatio = 1.0f;
-
-        if (std::abs(input.steer) > 0.01f) {
-            if (brake < 0.01f && std::abs(throttle) < 0.01f && std::abs(forwardSpeed) < minVelocityPivotTurn) {
-                // Pivot turn like Jolt demo
-                throttle = 1.0f;
-                leftRatio = input.steer < 0.f ? -1.0f : 1.0f;
-                rightRatio = input.steer < 0.f ? 1.0f : -1.0f;
-            } else if (input.steer < -0.01f) {
-                leftRatio = 0.6f;
-            } else if (input.steer > 0.01f) {
-                rightRatio = 0.6f;
-            }
-        }
-
-        tracked->SetDriverInput(throttle, leftRatio, rightRatio, brake);
-    } else if (type_ == VehicleType::Motorcycle) {
-        auto* motorcycle = static_cast<MotorcycleController*>(controllerBase_);
-        motorcycle->GetEngine().mMaxTorque = settings_.engineForce;
-        motorcycle->SetDriverInput(throttle, input.steer, brake, input.handbrake);
-        motorcycle->EnableLeanController(true);
-    } else if (controller_) {
-        controller_->GetEngine().mMaxTorque = settings_.engineForce;
-        controller_->SetDriverInput(throttle, input.steer, brake, input.handbrake ? 1.f : 0.f);
-    }
-}
-
-void PhysicsVehicle::syncVisual() {
-    BodyInterface& bodyInterface = world_.bodyInterface();
-    RVec3 position = bodyInterface.GetPosition(bodyId_);
-    Quat rotation = bodyInterface.GetRotation(bodyId_);
-
-    model_.group->position.set(position.GetX(), position.GetY(), position.GetZ());
-    model_.group->quaternion.set(rotation.GetX(), rotation.GetY(), rotation.GetZ(), rotation.GetW());
-
-    if (!vehicleConstraint_) return;
-    const Vec3 wheelUp = Vec3::sAxisX();
-    for (size_t i = 0; i < model_.wheels.size(); ++i) {
-        Mat44 transform = vehicleConstraint_->GetWheelLocalTransform(static_cast<uint>(i), wheelRights_[i], wheelUp);
-        Vec3 t = transform.GetTranslation();
-        Quat q = transform.GetQuaternion();
-        auto& wheel = model_.wheels[i];
-        wheel->position.set(t.GetX(), t.GetY(), t.GetZ());
-        wheel->quaternion.set(q.GetX(), q.GetY(), q.GetZ(), q.GetW());
-    }
-}
-
-float PhysicsVehicle::speed() const {
-    Vec3 velocity = world_.bodyInterface().GetLinearVelocity(bodyId_);
-    return velocity.Length();
+    return {shape, constraint};
 }
 
-VehicleSettings& PhysicsVehicle::settings() {
-    return settings_;
+std::vector<uint8_t> PhysicsVehicle::saveBlueprint(const VehicleBlueprint& blueprint) {
+    BlobStreamOut out;
+    Shape::ShapeToIDMap shapeMap;
+    Shape::MaterialToIDMap materialMap;
+    blueprint.chassis->SaveWithChildren(out, shapeMap, materialMap);
+    blueprint.constraint->SaveBinaryState(out);
+    return std::move(out.bytes);
 }
 
-VehicleType PhysicsVehicle::type() const {
-    return type_;
+bool PhysicsVehicle::restoreBlueprint(std::span<const uint8_t> data, VehicleBlueprint& blueprint) {
+    if (data.empty()) return false;
+
+    BlobStreamIn in(data);
+    Shape::IDToShapeMap shapeMap;
+    Shape::IDToMaterialMap materialMap;
+    Shape::ShapeResult shape = Shape::sRestoreWithChildren(in, shapeMap, materialMap);
+    if (shape.HasError() || in.IsFailed()) return false;
+    ConstraintSettings::ConstraintResult constraint = ConstraintSettings::sRestoreFromBinaryState(in);
+    if (constraint.HasError() || in.IsFailed()) return false;
+    auto* vehicleSettings = DynamicCast<VehicleConstraintSettings>(constraint.Get().GetPtr());
+    if (!vehicleSettings) return false;
+
+    blueprint.chassis = shape.Get();
+    blueprint.constraint = vehicleSettings;
+    return true;
 }
-
-float PhysicsVehicle::spawnHeight(VehicleType type) {
-    float halfY = 0.3f;
-    float wheelRadius = 0.4f;
-    float wheelBaseY = -0.9f * halfY;
-    switch (type) {
-        case VehicleType::Kart:
-            halfY = 0.2f;
-            wheelRadius = 0.35f;
-            wheelBaseY = -0.9f * halfY;
-            break;
-        case VehicleType::Sedan:
-            halfY = 0.3f;
-            wheelRadius = 0.45f;
-            wheelBaseY = -0.9f * halfY;
-            break;
-        case VehicleType::Truck:
-            halfY = 0.4f;
-            wheelRadius = 0.55f;
-            wheelBaseY = -0.9f * halfY;
-            break;
-        case VehicleType::Tank:
-            halfY = 0.5f;
-            wheelRadius = 0.3f;
-            wheelBaseY = -0.9f * halfY;
-            break;
-        case VehicleType::Motorcycle:
-            halfY = 0.3f;
-            wheelRadius = 0.31f;
-            wheelBaseY = -0.9f * halfY;
-            break;
-        default:
-            break;
-    }
-    const float suspensionRest = 0.4f;
-    return wheelRadius - wheelBaseY + suspensionRest;
-}
-
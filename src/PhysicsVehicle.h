@@ -4,11 +4,18 @@
 #include "VehicleFactory.h"
 
 #include <Jolt/Core/Reference.h>
+#include <Jolt/Physics/Collision/Shape/Shape.h>
 #include <Jolt/Physics/Vehicle/VehicleConstraint.h>
 #include <Jolt/Physics/Vehicle/VehicleCollisionTester.h>
 #include <Jolt/Physics/Vehicle/VehicleController.h>
 #include <Jolt/Physics/Vehicle/WheeledVehicleController.h>
 
+#include <cstdint>
+#include <span>
+#include <vector>
+
+struct VehicleTelemetrySample;
+
 struct VehicleInput {
     float throttle = 0.f;
     float steer = 0.f;
@@ -26,24 +33,108 @@ struct VehicleSettings {
     float angularDamping = 0.6f;
 };
 
+// Chassis shape and constraint settings of one vehicle type. Both are immutable
+// once built, so every vehicle of the type can share them.
+struct VehicleBlueprint {
+    JPH::RefConst<JPH::Shape> chassis;
+    JPH::RefConst<JPH::VehicleConstraintSettings> constraint;
+};
+
+// Dynamic state of one vehicle, enough to continue its motion in another world.
+struct VehicleState {
+    JPH::RVec3 position;
+    JPH::Quat rotation;
+    JPH::Vec3 linearVelocity;
+    JPH::Vec3 angularVelocity;
+    std::vector<float> wheelAngularVelocity;
+    std::vector<float> wheelSteerAngle;
+    float engineRpm = 0.f;
+    int gear = 0;
+    float clutchFriction = 0.f;
+    float trackAngularVelocity[2] = {0.f, 0.f};
+};
+
 class PhysicsVehicle {
 public:
-    PhysicsVehicle(PhysicsWorld& world, VehicleModel& model, VehicleType type, const JPH::RVec3& position);
+    // Bump when buildBlueprint() or the default settings change, so baked startup
+    // caches are rebuilt.
+    static constexpr uint32_t BlueprintRevision = 1;
+
+    // `overrides` replaces the per-type defaults from defaultSettings(), including
+    // values only consumed while building the body and wheels (mass, brake force).
+    // With `addToWorld` false the vehicle starts removed, ready for addToWorldBatch().
+    PhysicsVehicle(PhysicsWorld& world, VehicleModel model, VehicleType type, const JPH::RVec3& position,
+                   const VehicleSettings* overrides = nullptr, bool addToWorld = true);
     ~PhysicsVehicle();
 
+    // Takes the body and constraint out of the simulation but keeps them allocated,
+    // so a pool can bring the vehicle back without rebuilding it.
+    void removeFromWorld();
+    // Re-adds a removed vehicle at rest with a freshly reset engine and wheels.
+    void addToWorld(const JPH::RVec3& position, const JPH::Quat& rotation = JPH::Quat::sIdentity());
+    bool inWorld() const { return inWorld_; }
+    // addToWorld() for many removed vehicles of one world, with a single broadphase
+    // insertion for all bodies. Vehicles already in the world are skipped.
+    static void addToWorldBatch(std::span<PhysicsVehicle* const> vehicles, std::span<const JPH::RVec3> positions,
+                                std::span<const JPH::Quat> rotations);
+
+    void captureState(VehicleState& state) const;
+    // Expects a state captured from a vehicle of the same type.
+    void restoreState(const VehicleState& state);
+    // Jolt's own state of the vehicle constraint, which captureState() leaves out:
+    // suspension and wheel contacts, driver inputs including the handbrake, and
+    // controller state such as the motorcycle's lean. Same-type vehicles only.
+    void saveConstraintState(JPH::StateRecorder& stream) const;
+    void restoreConstraintState(JPH::StateRecorder& stream);
+
     void applyInput(const VehicleInput& input);
+    // Applies inputs[i] to vehicles[i]; every vehicle must be of `type`. The type
+    // is dispatched once for the whole batch.
+    static void applyInputBatch(VehicleType type, std::span<PhysicsVehicle* const> vehicles, std::span<const VehicleInput> inputs);
     void syncVisual();
+    size_t wheelCount() const { return wheelRights_.size(); }
+    // Wheel pose relative to the body, as syncVisual applies it to the model.
+    JPH::Mat44 wheelLocalTransform(size_t wheel) const;
+    // Whether the wheel touched the ground in the last step.
+    bool wheelHasContact(size_t wheel) const;
+    // Fills everything except tick, time and vehicle index.
+    void sampleTelemetry(VehicleTelemetrySample& sample) const;
 
     float speed() const;
+    JPH::RVec3 position() const;
+    JPH::Quat rotation() const;
+    JPH::Vec3 velocity() const;
     VehicleSettings& settings();
+    const VehicleSettings& settings() const { return settings_; }
+    // Settings the body and wheels were built with; later edits to settings() that
+    // touch mass, damping or brakes do not reach them.
+    const VehicleSettings& buildSettings() const { return buildSettings_; }
+    VehicleModel& model() { return model_; }
+    JPH::BodyID bodyId() const { return bodyId_; }
     VehicleType type() const;
+    static VehicleSettings defaultSettings(VehicleType type);
     static float spawnHeight(VehicleType type);
 
+    // Blueprint with the type's default settings, shared by every vehicle of the
+    // type: restored from the active StartupCache or built once. Thread-safe.
+    static VehicleBlueprint sharedBlueprint(VehicleType type);
+    // Procedural build; wheeled types place their wheels where `model` has them.
+    static VehicleBlueprint buildBlueprint(VehicleType type, const VehicleModel& model, const VehicleSettings& settings);
+    // Jolt binary state of the shape and constraint settings, for StartupCache.
+    static std::vector<uint8_t> saveBlueprint(const VehicleBlueprint& blueprint);
+    static bool restoreBlueprint(std::span<const uint8_t> data, VehicleBlueprint& blueprint);
+
 private:
+    template<typename Archetype>
+    void applyInputAs(const VehicleInput& input);
+    // Places the removed body and puts wheels, engine and transmission at rest.
+    void resetForAdd(const JPH::RVec3& position, const JPH::Quat& rotation);
+
     PhysicsWorld& world_;
-    VehicleModel& model_;
+    VehicleModel model_;
     VehicleType type_;
     VehicleSettings settings_;
+    VehicleSettings buildSettings_;
     JPH::BodyID bodyId_;
     JPH::Body* body_ = nullptr;
     JPH::Ref<JPH::VehicleConstraint> vehicleConstraint_;
@@ -51,4 +142,5 @@ private:
     JPH::VehicleController* controllerBase_ = nullptr;
     JPH::WheeledVehicleController* controller_ = nullptr;
     std::vector<JPH::Vec3> wheelRights_;
+    bool inWorld_ = true;
 };
@@ -1,21 +1,21 @@
 #include "PhysicsWorld.h"
 
 #include <algorithm>
-#include <thread>
-#include <Jolt/Core/Factory.h>
-#include <Jolt/Core/JobSystemThreadPool.h>
+#include <atomic>
+#include <cmath>
+#include <vector>
+#include <Jolt/Core/JobSystemSingleThreaded.h>
+#include <Jolt/Core/Profiler.h>
 #include <Jolt/Core/TempAllocator.h>
+#include <Jolt/Physics/Body/BodyInterface.h>
+#include <Jolt/Physics/Body/BodyLock.h>
 #include <Jolt/Physics/Body/BodyCreationSettings.h>
 #include <Jolt/Physics/Collision/BroadPhase/BroadPhaseLayer.h>
 #include <Jolt/Physics/Collision/ObjectLayer.h>
-#include <Jolt/RegisterTypes.h>
 
 using namespace JPH;
 
-static constexpr uint32_t cMaxBodies = 1024;
 static constexpr uint32_t cNumBodyMutexes = 0;
-static constexpr uint32_t cMaxBodyPairs = 1024;
-static constexpr uint32_t cMaxContactConstraints = 1024;
 
 namespace Layers {
     static constexpr ObjectLayer NON_MOVING = PhysicsLayers::Static;
@@ -23,6 +23,46 @@ namespace Layers {
     static constexpr ObjectLayer NUM_LAYERS = 2;
 }
 
+// Stack allocator that records its high-water mark and spills to the heap instead
+// of asserting when a step needs more than was reserved.
+class PhysicsWorld::TrackingTempAllocator final : public TempAllocator {
+public:
+    explicit TrackingTempAllocator(uint size)
+        : impl_(size) {}
+
+    void* Allocate(uint inSize) override {
+        if (!impl_.CanAllocate(inSize)) {
+            ++overflows_;
+            return AlignedAllocate(inSize, JPH_RVECTOR_ALIGNMENT);
+        }
+        void* address = impl_.Allocate(inSize);
+        peak_ = std::max<size_t>(peak_, impl_.GetUsage());
+        return address;
+    }
+
+    void Free(void* inAddress, uint inSize) override {
+        if (inAddress && !impl_.OwnsMemory(inAddress)) {
+            AlignedFree(inAddress);
+        } else {
+            impl_.Free(inAddress, inSize);
+        }
+    }
+
+    // Returns the peak since the last call.
+    size_t takePeak() {
+        const size_t peak = peak_;
+        peak_ = impl_.GetUsage();
+        return peak;
+    }
+    size_t capacity() const { return impl_.GetSize(); }
+    uint64_t overflows() const { return overflows_; }
+
+private:
+    TempAllocatorImpl impl_;
+    size_t peak_ = 0;
+    uint64_t overflows_ = 0;
+};
+
 class PhysicsWorld::BroadPhaseLayerInterfaceImpl final : public BroadPhaseLayerInterface {
 public:
     BroadPhaseLayerInterfaceImpl() {
@@ -72,42 +112,195 @@ public:
     }
 };
 
-PhysicsWorld::PhysicsWorld() {
-    RegisterDefaultAllocator();
+// Stand-in listener for worlds without contact events, so the manifold count in
+// CapacityStats does not read 0 there. One relaxed increment per manifold.
+class PhysicsWorld::ManifoldCounter final : public ContactListener {
+public:
+    void OnContactAdded(const Body&, const Body&, const ContactManifold&, ContactSettings&) override {
+        count_.fetch_add(1, std::memory_order_relaxed);
+    }
+    void OnContactPersisted(const Body&, const Body&, const ContactManifold&, ContactSettings&) override {
+        count_.fetch_add(1, std::memory_order_relaxed);
+    }
 
-    factory_ = std::make_unique<Factory>();
-    Factory::sInstance = factory_.get();
-    RegisterTypes();
+    uint32_t consume() { return count_.exchange(0, std::memory_order_relaxed); }
 
-    tempAllocator_ = std::make_unique<TempAllocatorImpl>(10 * 1024 * 1024);
-    const uint32_t threadCount = std::max(1u, std::thread::hardware_concurrency());
-    const uint32_t workerThreads = std::max(1u, threadCount - 1);
-    jobSystem_ = std::make_unique<JobSystemThreadPool>(cMaxBodies, cMaxBodies / 4, workerThreads);
+private:
+    std::atomic<uint32_t> count_{0};
+};
+
+PhysicsWorld::PhysicsWorld()
+    : PhysicsWorld(Config()) {}
+
+PhysicsWorld::PhysicsWorld(const Config& config)
+    : runtime_(JoltRuntime::acquire()), config_(config) {
+    tempAllocator_ = std::make_unique<TrackingTempAllocator>(config_.tempAllocatorBytes);
+    if (config_.singleThreaded) {
+        ownJobSystem_ = std::make_unique<JobSystemSingleThreaded>(cMaxPhysicsJobs);
+    }
 
     broadPhaseLayerInterface_ = std::make_unique<BroadPhaseLayerInterfaceImpl>();
     objectVsBroadPhaseLayerFilter_ = std::make_unique<ObjectVsBroadPhaseLayerFilterImpl>();
     objectLayerPairFilter_ = std::make_unique<ObjectLayerPairFilterImpl>();
+    contactEvents_ = std::make_unique<ContactEvents>(config_.contactEventsPerThread,
+                                                     ownJobSystem_ ? 0 : runtime_->workerThreads());
 
     physicsSystem_.Init(
-        cMaxBodies,
+        config_.maxBodies,
         cNumBodyMutexes,
-        cMaxBodyPairs,
-        cMaxContactConstraints,
+        config_.maxBodyPairs,
+        config_.maxContactConstraints,
         *broadPhaseLayerInterface_,
         *objectVsBroadPhaseLayerFilter_,
         *objectLayerPairFilter_);
 
     physicsSystem_.SetGravity(Vec3(0, -9.81f, 0));
+    if (config_.contactEventsPerThread > 0) {
+        physicsSystem_.SetContactListener(contactEvents_.get());
+    } else {
+        manifoldCounter_ = std::make_unique<ManifoldCounter>();
+        physicsSystem_.SetContactListener(manifoldCounter_.get());
+    }
 }
 
-PhysicsWorld::~PhysicsWorld() {
-    UnregisterTypes();
-    Factory::sInstance = nullptr;
-    factory_.reset();
-}
+PhysicsWorld::~PhysicsWorld() = default;
 
 void PhysicsWorld::step(float dt) {
-    physicsSystem_.Update(dt, 1, tempAllocator_.get(), jobSystem_.get());
+    JPH_PROFILE_FUNCTION();
+
+    const int collisionSteps = chooseCollisionSteps(dt);
+    const bool reportContacts = config_.contactEventsPerThread > 0;
+    if (reportContacts) contactEvents_->prepare();
+    const EPhysicsUpdateError error = physicsSystem_.Update(dt, collisionSteps, tempAllocator_.get(), &jobSystem());
+    if (reportContacts) contactEvents_->endStep(physicsSystem_.GetBodyInterfaceNoLock());
+    updateCapacityStats(error);
+}
+
+void PhysicsWorld::updateCapacityStats(EPhysicsUpdateError error) {
+    CapacityStats& stats = capacityStats_;
+    stats.lastError = error;
+    ++stats.steps;
+    if ((error & EPhysicsUpdateError::ManifoldCacheFull) != EPhysicsUpdateError::None) ++stats.manifoldCacheFullSteps;
+    if ((error & EPhysicsUpdateError::BodyPairCacheFull) != EPhysicsUpdateError::None) ++stats.bodyPairCacheFullSteps;
+    if ((error & EPhysicsUpdateError::ContactConstraintsFull) != EPhysicsUpdateError::None) ++stats.contactConstraintsFullSteps;
+
+    stats.bodies = physicsSystem_.GetNumBodies();
+    stats.maxBodies = physicsSystem_.GetMaxBodies();
+    stats.maxBodyPairs = config_.maxBodyPairs;
+    stats.maxContactConstraints = config_.maxContactConstraints;
+    stats.contactManifolds = manifoldCounter_ ? manifoldCounter_->consume() : contactEvents_->manifolds();
+
+    // One walk over the active bodies serves both the stats of this step and the
+    // collision step choice of the next: velocities at the end of a step are the
+    // ones the next step starts from.
+    physicsSystem_.GetActiveBodies(EBodyType::RigidBody, activeBodies_);
+    stats.activeBodies = static_cast<uint32_t>(activeBodies_.size());
+    stats.islands = 0;
+    measuredMaxSpeed_ = 0.f;
+    const bool promoteFast = substeps_.linearCastFastBodies;
+    const float promote = substeps_.linearCastSpeed;
+    BodyInterface& bodyInterface = physicsSystem_.GetBodyInterfaceNoLock();
+    const BodyLockInterfaceNoLock& locks = physicsSystem_.GetBodyLockInterfaceNoLock();
+    for (const BodyID& id : activeBodies_) {
+        bool makeLinearCast = false;
+        {
+            BodyLockRead lock(locks, id);
+            if (!lock.Succeeded()) continue;
+            const Body& body = lock.GetBody();
+            const float speed = body.GetLinearVelocity().Length();
+            measuredMaxSpeed_ = std::max(measuredMaxSpeed_, speed);
+            makeLinearCast = promoteFast && speed > promote &&
+                             body.GetMotionProperties()->GetMotionQuality() == EMotionQuality::Discrete;
+            // Island indices of active bodies are dense per step, so the largest one
+            // gives the island count without reaching into the island builder.
+            if (body.IsDynamic()) {
+                const uint32_t island = body.GetMotionProperties()->GetIslandIndexInternal();
+                if (island != Body::cInactiveIndex) {
+                    stats.islands = std::max(stats.islands, static_cast<int>(island) + 1);
+                }
+            }
+        }
+        if (makeLinearCast) {
+            bodyInterface.SetMotionQuality(id, EMotionQuality::LinearCast);
+            linearCastBodies_.push_back(id);
+        }
+    }
+
+    stats.tempPeak = tempAllocator_->takePeak();
+    stats.tempPeakEver = std::max(stats.tempPeakEver, stats.tempPeak);
+    stats.tempCapacity = tempAllocator_->capacity();
+    stats.tempOverflows = tempAllocator_->overflows();
+}
+
+int PhysicsWorld::chooseCollisionSteps(float dt) {
+    JPH_PROFILE("ChooseCollisionSteps");
+
+    // Measured and promoted by the active-body walk at the end of the last step.
+    stepStats_.maxBodySpeed = measuredMaxSpeed_;
+    BodyInterface& bodyInterface = physicsSystem_.GetBodyInterfaceNoLock();
+    // Hysteresis so bodies hovering around the threshold do not flip every frame.
+    const float demote = 0.8f * substeps_.linearCastSpeed;
+
+    // Inactive, removed or pooled bodies are demoted too; a stale ID is a no-op.
+    auto slow = [&](const BodyID& id) {
+        if (substeps_.linearCastFastBodies && bodyInterface.IsActive(id) && bodyInterface.GetLinearVelocity(id).Length() > demote) {
+            return false;
+        }
+        bodyInterface.SetMotionQuality(id, EMotionQuality::Discrete);
+        return true;
+    };
+    linearCastBodies_.erase(std::remove_if(linearCastBodies_.begin(), linearCastBodies_.end(), slow), linearCastBodies_.end());
+    stepStats_.linearCastBodies = static_cast<int>(linearCastBodies_.size());
+
+    int steps = std::max(substeps_.minSteps, 1);
+    if (substeps_.adaptive && substeps_.maxTravelPerStep > 0.f) {
+        const int needed = static_cast<int>(std::ceil(stepStats_.maxBodySpeed * dt / substeps_.maxTravelPerStep));
+        steps = std::clamp(needed, steps, std::max(substeps_.maxSteps, steps));
+    }
+    stepStats_.collisionSteps = steps;
+    return steps;
+}
+
+void PhysicsWorld::shiftOrigin(Vec3Arg shift) {
+    BodyInterface& bodyInterface = physicsSystem_.GetBodyInterfaceNoLock();
+    BodyIDVector bodies;
+    physicsSystem_.GetBodies(bodies);
+
+    BodyIDVector added;
+    BodyIDVector active;
+    std::vector<Vec3> linearVelocities;
+    std::vector<Vec3> angularVelocities;
+    added.reserve(bodies.size());
+    for (const BodyID& id : bodies) {
+        if (!bodyInterface.IsAdded(id)) {
+            bodyInterface.SetPosition(id, bodyInterface.GetPosition(id) - shift, EActivation::DontActivate);
+            continue;
+        }
+        added.push_back(id);
+        if (bodyInterface.IsActive(id)) {
+            active.push_back(id);
+            linearVelocities.push_back(bodyInterface.GetLinearVelocity(id));
+            angularVelocities.push_back(bodyInterface.GetAngularVelocity(id));
+        }
+    }
+    if (added.empty()) return;
+
+    // Moving bodies one by one would refit the broadphase tree per body; taking
+    // them all out and re-inserting builds the new tree in a single batch.
+    const int count = static_cast<int>(added.size());
+    bodyInterface.RemoveBodies(added.data(), count);
+    for (const BodyID& id : added) {
+        bodyInterface.SetPosition(id, bodyInterface.GetPosition(id) - shift, EActivation::DontActivate);
+    }
+    BodyInterface::AddState state = bodyInterface.AddBodiesPrepare(added.data(), count);
+    bodyInterface.AddBodiesFinalize(added.data(), count, state, EActivation::DontActivate);
+
+    if (!active.empty()) {
+        bodyInterface.ActivateBodies(active.data(), static_cast<int>(active.size()));
+        for (size_t i = 0; i < active.size(); ++i) {
+            bodyInterface.SetLinearAndAngularVelocity(active[i], linearVelocities[i], angularVelocities[i]);
+        }
+    }
 }
 
 JPH::PhysicsSystem& PhysicsWorld::system() {
@@ -117,3 +310,7 @@ JPH::PhysicsSystem& PhysicsWorld::system() {
 JPH::BodyInterface& PhysicsWorld::bodyInterface() {
     return physicsSystem_.GetBodyInterface();
 }
+
+JPH::JobSystem& PhysicsWorld::jobSystem() {
+    return ownJobSystem_ ? *ownJobSystem_ : runtime_->jobSystem();
+}
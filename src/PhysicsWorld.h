@@ -2,32 +2,131 @@
 
 #include <Jolt/Jolt.h>
 #include <Jolt/Physics/PhysicsSystem.h>
+#include "ContactEvents.h"
+#include "JoltRuntime.h"
 #include <memory>
+#include <vector>
 
 class PhysicsWorld {
 public:
+    // Fixed capacities handed to PhysicsSystem::Init. Scratch worlds that are
+    // stepped from inside a job use their own single-threaded job system rather
+    // than queueing more work on the shared pool.
+    struct Config {
+        uint32_t maxBodies = 1024;
+        uint32_t maxBodyPairs = 1024;
+        uint32_t maxContactConstraints = 1024;
+        uint32_t tempAllocatorBytes = 10 * 1024 * 1024;
+        bool singleThreaded = false;
+        // Capacity of each thread's contact event buffer. 0 is for worlds nobody
+        // reads events from: contactEvents() then stays empty and only a counter
+        // for the manifold count in CapacityStats is registered.
+        uint32_t contactEventsPerThread = 4096;
+    };
+
+    // Collision step selection. With `adaptive` the step count is the smallest one
+    // that keeps the fastest active body under `maxTravelPerStep` per collision step.
+    struct SubstepSettings {
+        bool adaptive = true;
+        int minSteps = 1;
+        int maxSteps = 4;
+        float maxTravelPerStep = 0.25f;
+        // Switch bodies faster than `linearCastSpeed` to LinearCast motion quality
+        // and back to Discrete once they slow down.
+        bool linearCastFastBodies = true;
+        float linearCastSpeed = 20.f;
+    };
+
+    struct StepStats {
+        int collisionSteps = 1;
+        float maxBodySpeed = 0.f;
+        int linearCastBodies = 0;
+    };
+
+    // Usage against the fixed capacities the world was created with. Jolt drops
+    // pairs and contacts silently when a cache fills; the error counters record it.
+    struct CapacityStats {
+        JPH::EPhysicsUpdateError lastError = JPH::EPhysicsUpdateError::None;
+        uint64_t steps = 0;
+        uint64_t manifoldCacheFullSteps = 0;
+        uint64_t bodyPairCacheFullSteps = 0;
+        uint64_t contactConstraintsFullSteps = 0;
+
+        uint32_t bodies = 0;
+        uint32_t maxBodies = 0;
+        uint32_t activeBodies = 0;
+        // Body pair count is not exposed by Jolt. Contact manifolds are only a lower
+        // bound on it, since the pair cache also holds AABB-overlap pairs without
+        // contacts; watch bodyPairCacheFullSteps instead.
+        uint32_t contactManifolds = 0;
+        uint32_t maxBodyPairs = 0;
+        uint32_t maxContactConstraints = 0;
+        int islands = 0;
+
+        size_t tempPeak = 0;      // last step
+        size_t tempPeakEver = 0;
+        size_t tempCapacity = 0;
+        // Temp allocations that did not fit and went to the heap instead.
+        uint64_t tempOverflows = 0;
+
+        uint64_t errorSteps() const { return manifoldCacheFullSteps + bodyPairCacheFullSteps + contactConstraintsFullSteps; }
+    };
+
     PhysicsWorld();
+    explicit PhysicsWorld(const Config& config);
     ~PhysicsWorld();
 
     void step(float dt);
+    void setSubstepSettings(const SubstepSettings& settings) { substeps_ = settings; }
+    const SubstepSettings& substepSettings() const { return substeps_; }
+    const StepStats& stepStats() const { return stepStats_; }
+    const CapacityStats& capacityStats() const { return capacityStats_; }
+    // Moves every body by -shift in one broadphase remove/add batch, keeping
+    // activation state and velocities. Used for floating-origin rebasing.
+    void shiftOrigin(JPH::Vec3Arg shift);
 
     JPH::PhysicsSystem& system();
     JPH::BodyInterface& bodyInterface();
+    // The job system step() runs on: the shared pool, or the world's own
+    // single-threaded one.
+    JPH::JobSystem& jobSystem();
+    const Config& config() const { return config_; }
+    // Contacts reported during the last step() as one sorted batch.
+    ContactEvents& contactEvents() { return *contactEvents_; }
 
 private:
+    int chooseCollisionSteps(float dt);
+    void updateCapacityStats(JPH::EPhysicsUpdateError error);
+
+    class TrackingTempAllocator;
     class BroadPhaseLayerInterfaceImpl;
     class ObjectVsBroadPhaseLayerFilterImpl;
     class ObjectLayerPairFilterImpl;
+    class ManifoldCounter;
 
-    std::unique_ptr<JPH::TempAllocator> tempAllocator_;
-    std::unique_ptr<JPH::JobSystem> jobSystem_;
-    std::unique_ptr<JPH::Factory> factory_;
+    // Declared first so the shared runtime outlives everything else in the world.
+    std::shared_ptr<JoltRuntime> runtime_;
+    Config config_;
+    std::unique_ptr<JPH::JobSystem> ownJobSystem_;
+    std::unique_ptr<TrackingTempAllocator> tempAllocator_;
 
     std::unique_ptr<BroadPhaseLayerInterfaceImpl> broadPhaseLayerInterface_;
     std::unique_ptr<ObjectVsBroadPhaseLayerFilterImpl> objectVsBroadPhaseLayerFilter_;
     std::unique_ptr<ObjectLayerPairFilterImpl> objectLayerPairFilter_;
+    std::unique_ptr<ContactEvents> contactEvents_;
+    // Only when contact events are off.
+    std::unique_ptr<ManifoldCounter> manifoldCounter_;
 
     JPH::PhysicsSystem physicsSystem_;
+
+    SubstepSettings substeps_;
+    StepStats stepStats_;
+    CapacityStats capacityStats_;
+    JPH::BodyIDVector activeBodies_;
+    // Fastest active body at the end of the last step.
+    float measuredMaxSpeed_ = 0.f;
+    // Bodies this world promoted to LinearCast, so user-set qualities are left alone.
+    std::vector<JPH::BodyID> linearCastBodies_;
 };
 
 namespace PhysicsLayers {
@@ -0,0 +1,308 @@
+#include "RollbackSession.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+using namespace JPH;
+
+namespace {
+
+constexpr uint8_t cInputPacket = 0x49;
+constexpr uint8_t cButtonBrake = 1;
+constexpr uint8_t cButtonHandbrake = 2;
+
+int8_t quantize(float value) {
+    return static_cast<int8_t>(std::lround(std::clamp(value, -1.f, 1.f) * 127.f));
+}
+
+float elapsedMs(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+} // namespace
+
+void SnapshotBuffer::clear() {
+    bytes_.clear();
+    readOffset_ = 0;
+    failed_ = false;
+}
+
+void SnapshotBuffer::WriteBytes(const void* data, size_t size) {
+    const auto* p = static_cast<const uint8_t*>(data);
+    bytes_.insert(bytes_.end(), p, p + size);
+}
+
+void SnapshotBuffer::ReadBytes(void* data, size_t size) {
+    if (size > bytes_.size() - readOffset_) {
+        failed_ = true;
+        std::memset(data, 0, size);
+        return;
+    }
+    std::memcpy(data, bytes_.data() + readOffset_, size);
+    readOffset_ += size;
+}
+
+NetInput NetInput::fromVehicleInput(const VehicleInput& input) {
+    NetInput net;
+    net.throttle = quantize(input.throttle);
+    net.steer = quantize(input.steer);
+    net.buttons = (input.brake ? cButtonBrake : 0) | (input.handbrake ? cButtonHandbrake : 0);
+    return net;
+}
+
+VehicleInput NetInput::toVehicleInput() const {
+    VehicleInput input;
+    input.throttle = throttle / 127.f;
+    input.steer = steer / 127.f;
+    input.brake = (buttons & cButtonBrake) != 0;
+    input.handbrake = (buttons & cButtonHandbrake) != 0;
+    return input;
+}
+
+void RollbackSession::encodeInputs(std::vector<uint8_t>& packet, int player, uint32_t lastTick, const NetInput* inputs, int count) {
+    // [type u8][player u8][lastTick u32][count u8] then `count` inputs ending at lastTick.
+    packet.clear();
+    packet.push_back(cInputPacket);
+    packet.push_back(static_cast<uint8_t>(player));
+    for (int i = 0; i < 4; ++i) {
+        packet.push_back(static_cast<uint8_t>(lastTick >> (8 * i)));
+    }
+    packet.push_back(static_cast<uint8_t>(count));
+    for (int i = 0; i < count; ++i) {
+        packet.push_back(static_cast<uint8_t>(inputs[i].throttle));
+        packet.push_back(static_cast<uint8_t>(inputs[i].steer));
+        packet.push_back(inputs[i].buttons);
+    }
+}
+
+RollbackSession::RollbackSession(PhysicsWorld& world, std::vector<PhysicsVehicle*> vehicles, std::vector<int> playerVehicles,
+                                 int localPlayer, NetTransport& transport)
+    : RollbackSession(world, std::move(vehicles), std::move(playerVehicles), localPlayer, transport, Config{}) {}
+
+RollbackSession::RollbackSession(PhysicsWorld& world, std::vector<PhysicsVehicle*> vehicles, std::vector<int> playerVehicles,
+                                 int localPlayer, NetTransport& transport, const Config& config)
+    : world_(world),
+      vehicles_(std::move(vehicles)),
+      playerVehicles_(std::move(playerVehicles)),
+      localPlayer_(localPlayer),
+      transport_(transport),
+      config_(config),
+      inputHistorySize_(static_cast<size_t>(config.maxRollback) + static_cast<size_t>(std::max(config.maxFrameAdvantage, 0)) + 1) {
+    vehiclePlayer_.assign(vehicles_.size(), -1);
+    for (size_t p = 0; p < playerVehicles_.size(); ++p) {
+        vehiclePlayer_[playerVehicles_[p]] = static_cast<int8_t>(p);
+    }
+
+    players_.resize(playerVehicles_.size());
+    for (auto& player : players_) {
+        player.inputs.resize(inputHistorySize_);
+        player.inputTicks.assign(inputHistorySize_, NoTick);
+        player.used.resize(inputHistorySize_);
+        player.usedTicks.assign(inputHistorySize_, NoTick);
+    }
+    snapshots_.resize(static_cast<size_t>(config.maxRollback) + 1);
+    snapshotTicks_.assign(snapshots_.size(), NoTick);
+}
+
+void RollbackSession::advance(const VehicleInput& localInput) {
+    storeInput(localPlayer_, tick_, NetInput::fromVehicleInput(localInput));
+    sendLocal();
+    receive();
+
+    if (rollbackTo_ != NoTick && rollbackTo_ < tick_) {
+        const auto start = std::chrono::steady_clock::now();
+        if (restoreSnapshot(rollbackTo_)) {
+            for (uint32_t t = rollbackTo_; t < tick_; ++t) {
+                if (t != rollbackTo_) {
+                    saveSnapshot(t);
+                }
+                simulateTick(t);
+            }
+            const int depth = static_cast<int>(tick_ - rollbackTo_);
+            stats_.lastRollbackDepth = depth;
+            stats_.maxRollbackDepth = std::max(stats_.maxRollbackDepth, depth);
+            stats_.resimulatedTicks += depth;
+            ++stats_.rollbacks;
+            stats_.lastResimMs = elapsedMs(start);
+            stats_.totalResimMs += stats_.lastResimMs;
+        }
+    } else {
+        stats_.lastRollbackDepth = 0;
+        stats_.lastResimMs = 0.f;
+    }
+    rollbackTo_ = NoTick;
+
+    const auto saveStart = std::chrono::steady_clock::now();
+    saveSnapshot(tick_);
+    stats_.lastSaveMs = elapsedMs(saveStart);
+    simulateTick(tick_);
+    ++tick_;
+}
+
+void RollbackSession::resetHistory() {
+    std::fill(snapshotTicks_.begin(), snapshotTicks_.end(), NoTick);
+    historyStart_ = tick_;
+    rollbackTo_ = NoTick;
+}
+
+NetInput RollbackSession::inputFor(int player, uint32_t tick) const {
+    const PlayerInputs& p = players_[player];
+    const size_t s = inputSlot(tick);
+    if (p.inputTicks[s] == tick) {
+        return p.inputs[s];
+    }
+    // Predict by repeating the newest input we have.
+    return p.lastConfirmed;
+}
+
+void RollbackSession::storeInput(int player, uint32_t tick, const NetInput& input) {
+    PlayerInputs& p = players_[player];
+    const size_t s = inputSlot(tick);
+    if (p.inputTicks[s] == tick) return;
+
+    p.inputs[s] = input;
+    p.inputTicks[s] = tick;
+    if (p.lastConfirmedTick == NoTick || tick > p.lastConfirmedTick) {
+        p.lastConfirmedTick = tick;
+        p.lastConfirmed = input;
+    }
+}
+
+void RollbackSession::acceptInput(int player, uint32_t t, const NetInput& input) {
+    PlayerInputs& p = players_[player];
+    if (p.inputTicks[inputSlot(t)] == t) return;
+
+    if (t > tick_ + static_cast<uint32_t>(std::max(config_.maxFrameAdvantage, 0))) {
+        // Its ring slot still belongs to a tick we may roll back to. The peer only
+        // resends its last few inputs, so dropping it would lose it for good.
+        for (const HeldInput& held : heldInputs_) {
+            if (held.player == player && held.tick == t) return;
+        }
+        if (heldInputs_.size() < inputHistorySize_ * players_.size()) {
+            heldInputs_.push_back({player, t, input});
+        } else {
+            ++stats_.earlyInputs;
+        }
+        return;
+    }
+
+    if (t < tick_) {
+        if (t < historyStart_ || tick_ - t > static_cast<uint32_t>(config_.maxRollback)) {
+            ++stats_.lateInputs;
+            return;
+        }
+        // Simulated already: roll back only if the prediction was wrong.
+        const size_t s = inputSlot(t);
+        if (p.usedTicks[s] != t || !(p.used[s] == input)) {
+            rollbackTo_ = std::min(rollbackTo_, t);
+        }
+    }
+    storeInput(player, t, input);
+}
+
+void RollbackSession::receive() {
+    // Held inputs whose tick is now within the frame advantage move into the ring.
+    const uint32_t horizon = tick_ + static_cast<uint32_t>(std::max(config_.maxFrameAdvantage, 0));
+    size_t kept = 0;
+    for (size_t i = 0; i < heldInputs_.size(); ++i) {
+        const HeldInput held = heldInputs_[i];
+        if (held.tick > horizon) {
+            heldInputs_[kept++] = held;
+        } else {
+            acceptInput(held.player, held.tick, held.input);
+        }
+    }
+    heldInputs_.resize(kept);
+
+    while (transport_.receive(packet_)) {
+        if (packet_.size() < 7 || packet_[0] != cInputPacket) continue;
+
+        const int player = packet_[1];
+        uint32_t lastTick = 0;
+        for (int i = 0; i < 4; ++i) {
+            lastTick |= static_cast<uint32_t>(packet_[2 + i]) << (8 * i);
+        }
+        const int count = packet_[6];
+        if (player == localPlayer_ || player >= static_cast<int>(players_.size()) || packet_.size() < 7 + 3 * static_cast<size_t>(count)) {
+            continue;
+        }
+
+        for (int i = 0; i < count; ++i) {
+            const uint32_t t = lastTick - static_cast<uint32_t>(count - 1 - i);
+            if (t > lastTick) continue; // wrapped below zero
+            NetInput input;
+            input.throttle = static_cast<int8_t>(packet_[7 + 3 * i]);
+            input.steer = static_cast<int8_t>(packet_[8 + 3 * i]);
+            input.buttons = packet_[9 + 3 * i];
+            acceptInput(player, t, input);
+        }
+    }
+}
+
+void RollbackSession::sendLocal() {
+    const int count = static_cast<int>(std::min<uint32_t>(static_cast<uint32_t>(std::clamp(config_.redundantInputs, 1, 255)), tick_ + 1));
+    NetInput inputs[255];
+    for (int i = 0; i < count; ++i) {
+        inputs[i] = inputFor(localPlayer_, tick_ - static_cast<uint32_t>(count - 1 - i));
+    }
+    encodeInputs(packet_, localPlayer_, tick_, inputs, count);
+    transport_.send(packet_.data(), packet_.size());
+}
+
+void RollbackSession::simulateTick(uint32_t tick) {
+    for (size_t i = 0; i < vehicles_.size(); ++i) {
+        const int player = vehiclePlayer_[i];
+        if (player < 0) {
+            vehicles_[i]->applyInput({});
+            continue;
+        }
+        PlayerInputs& p = players_[player];
+        const NetInput input = inputFor(player, tick);
+        p.used[inputSlot(tick)] = input;
+        p.usedTicks[inputSlot(tick)] = tick;
+        vehicles_[i]->applyInput(input.toVehicleInput());
+    }
+    world_.step(config_.dt);
+}
+
+void RollbackSession::saveSnapshot(uint32_t tick) {
+    SnapshotBuffer& snapshot = snapshots_[snapshotSlot(tick)];
+    snapshot.clear();
+    world_.system().SaveState(snapshot);
+    snapshotTicks_[snapshotSlot(tick)] = tick;
+}
+
+bool RollbackSession::restoreSnapshot(uint32_t tick) {
+    if (snapshotTicks_[snapshotSlot(tick)] != tick) return false;
+
+    SnapshotBuffer& snapshot = snapshots_[snapshotSlot(tick)];
+    snapshot.rewind();
+    return world_.system().RestoreState(snapshot);
+}
+
+ScriptedRemotePeer::ScriptedRemotePeer(NetTransport& transport, int player, int redundantInputs)
+    : transport_(transport), player_(player), redundantInputs_(redundantInputs) {}
+
+void ScriptedRemotePeer::update(uint32_t tick) {
+    for (; nextTick_ <= tick; ++nextTick_) {
+        recent_.push_back(inputAt(nextTick_));
+        if (static_cast<int>(recent_.size()) > redundantInputs_) {
+            recent_.erase(recent_.begin());
+        }
+        RollbackSession::encodeInputs(packet_, player_, nextTick_, recent_.data(), static_cast<int>(recent_.size()));
+        transport_.send(packet_.data(), packet_.size());
+    }
+}
+
+NetInput ScriptedRemotePeer::inputAt(uint32_t tick) const {
+    // Throttle pulses every few seconds and a weaving steer that changes every
+    // quarter second, similar to a human tapping keys.
+    VehicleInput input;
+    const uint32_t phase = tick / 15;
+    input.throttle = (tick / 180) % 4 == 3 ? 0.f : 1.f;
+    input.steer = std::sin(static_cast<float>(phase) * 0.7f) * 0.6f;
+    input.brake = (tick / 180) % 8 == 7;
+    return NetInput::fromVehicleInput(input);
+}
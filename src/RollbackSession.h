@@ -0,0 +1,164 @@
+#pragma once
+
+#include "NetTransport.h"
+#include "PhysicsVehicle.h"
+#include "PhysicsWorld.h"
+
+#include <Jolt/Physics/StateRecorder.h>
+#include <cstdint>
+#include <vector>
+
+// Quantized driver input as sent over the wire. Comparing quantized values keeps
+// misprediction checks exact.
+struct NetInput {
+    int8_t throttle = 0;
+    int8_t steer = 0;
+    uint8_t buttons = 0;
+
+    bool operator==(const NetInput&) const = default;
+
+    static NetInput fromVehicleInput(const VehicleInput& input);
+    VehicleInput toVehicleInput() const;
+};
+
+// Saved world state. Unlike StateRecorderImpl, which frees its stream on Clear(),
+// the buffer keeps its capacity, so saving a tick allocates nothing once warm.
+class SnapshotBuffer final : public JPH::StateRecorder {
+public:
+    void clear();
+    void rewind() { readOffset_ = 0; failed_ = false; }
+
+    void WriteBytes(const void* data, size_t size) override;
+    void ReadBytes(void* data, size_t size) override;
+    bool IsEOF() const override { return readOffset_ >= bytes_.size(); }
+    bool IsFailed() const override { return failed_; }
+
+private:
+    std::vector<uint8_t> bytes_;
+    size_t readOffset_ = 0;
+    bool failed_ = false;
+};
+
+// Rollback netcode over a PhysicsWorld: every tick the full Jolt state is saved
+// with a StateRecorder, remote inputs are predicted by repeating the last one
+// received, and when a late input contradicts a prediction the world is restored
+// to that tick and resimulated up to the present.
+class RollbackSession {
+public:
+    struct Config {
+        float dt = 1.f / 60.f;
+        // Number of ticks that can be rolled back; inputs older than this are late.
+        int maxRollback = 30;
+        // How many ticks ahead of us remote inputs go straight into the input ring.
+        // Later ones are held aside until we catch up, so they never overwrite
+        // inputs still inside the rollback window.
+        int maxFrameAdvantage = 8;
+        // Local inputs repeated in every packet so a lost packet does not stall remotes.
+        int redundantInputs = 8;
+    };
+
+    struct Stats {
+        int lastRollbackDepth = 0;
+        int maxRollbackDepth = 0;
+        uint64_t rollbacks = 0;
+        uint64_t resimulatedTicks = 0;
+        uint64_t lateInputs = 0;
+        // Inputs too far ahead that did not fit the held-aside buffer either.
+        uint64_t earlyInputs = 0;
+        float lastResimMs = 0.f;
+        double totalResimMs = 0.0;
+        float lastSaveMs = 0.f;
+
+        double resimTicksPerSecond() const { return totalResimMs > 0.0 ? resimulatedTicks * 1000.0 / totalResimMs : 0.0; }
+    };
+
+    // `vehicles` are all vehicles in the world; `playerVehicles[p]` is the index of
+    // player p's vehicle. Vehicles without a player receive an idle input.
+    RollbackSession(PhysicsWorld& world, std::vector<PhysicsVehicle*> vehicles, std::vector<int> playerVehicles,
+                    int localPlayer, NetTransport& transport);
+    RollbackSession(PhysicsWorld& world, std::vector<PhysicsVehicle*> vehicles, std::vector<int> playerVehicles,
+                    int localPlayer, NetTransport& transport, const Config& config);
+
+    // Advances one fixed tick with the local player's input.
+    void advance(const VehicleInput& localInput);
+    // Forgets all snapshots, e.g. after the world was modified outside the session.
+    void resetHistory();
+
+    uint32_t tick() const { return tick_; }
+    float dt() const { return config_.dt; }
+    int localPlayer() const { return localPlayer_; }
+    int playerVehicle(int player) const { return playerVehicles_[player]; }
+    const Stats& stats() const { return stats_; }
+
+    static void encodeInputs(std::vector<uint8_t>& packet, int player, uint32_t lastTick, const NetInput* inputs, int count);
+
+private:
+    static constexpr uint32_t NoTick = UINT32_MAX;
+
+    struct HeldInput {
+        int player;
+        uint32_t tick;
+        NetInput input;
+    };
+
+    struct PlayerInputs {
+        std::vector<NetInput> inputs;
+        std::vector<uint32_t> inputTicks;
+        std::vector<NetInput> used;
+        std::vector<uint32_t> usedTicks;
+        uint32_t lastConfirmedTick = NoTick;
+        NetInput lastConfirmed;
+    };
+
+    size_t inputSlot(uint32_t tick) const { return tick % inputHistorySize_; }
+    size_t snapshotSlot(uint32_t tick) const { return tick % snapshots_.size(); }
+    NetInput inputFor(int player, uint32_t tick) const;
+    void storeInput(int player, uint32_t tick, const NetInput& input);
+    void acceptInput(int player, uint32_t tick, const NetInput& input);
+    void receive();
+    void sendLocal();
+    void simulateTick(uint32_t tick);
+    void saveSnapshot(uint32_t tick);
+    bool restoreSnapshot(uint32_t tick);
+
+    PhysicsWorld& world_;
+    std::vector<PhysicsVehicle*> vehicles_;
+    std::vector<int> playerVehicles_;
+    std::vector<int8_t> vehiclePlayer_;
+    int localPlayer_;
+    NetTransport& transport_;
+    Config config_;
+    // Rollback window plus the frame advantage, so past and future ticks never share a slot.
+    size_t inputHistorySize_;
+
+    uint32_t tick_ = 0;
+    uint32_t historyStart_ = 0;
+    uint32_t rollbackTo_ = NoTick;
+    std::vector<PlayerInputs> players_;
+    // Remote inputs beyond the frame advantage, waiting to enter the input ring.
+    std::vector<HeldInput> heldInputs_;
+    std::vector<SnapshotBuffer> snapshots_;
+    std::vector<uint32_t> snapshotTicks_;
+    std::vector<uint8_t> packet_;
+    Stats stats_;
+};
+
+// Remote player stand-in for loopback testing: sends a deterministic, frequently
+// changing input stream so the local session has something to mispredict.
+class ScriptedRemotePeer {
+public:
+    ScriptedRemotePeer(NetTransport& transport, int player, int redundantInputs = 8);
+
+    // Produces and sends inputs for every tick up to and including `tick`.
+    void update(uint32_t tick);
+
+private:
+    NetInput inputAt(uint32_t tick) const;
+
+    NetTransport& transport_;
+    int player_;
+    int redundantInputs_;
+    uint32_t nextTick_ = 0;
+    std::vector<uint8_t> packet_;
+    std::vector<NetInput> recent_;
+};
@@ -0,0 +1,445 @@
+#include "SceneCuller.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace threepp;
+
+namespace {
+
+enum class Containment {
+    Outside,
+    Intersecting,
+    Inside
+};
+
+bool castsShadow(const Object3D& object) {
+    if (object.castShadow) return true;
+    for (const Object3D* child : object.children) {
+        if (castsShadow(*child)) return true;
+    }
+    return false;
+}
+
+} // namespace
+
+SceneCuller::SceneCuller(float fatMargin)
+    : fatMargin_(fatMargin) {}
+
+SceneCuller::ProxyId SceneCuller::add(Object3D& object) {
+    object.updateMatrixWorld(true);
+    Box3 box;
+    box.setFromObject(object);
+    Vector3 center;
+    object.getWorldPosition(center);
+
+    float radiusSq = 0.f;
+    if (!box.isEmpty()) {
+        const float dx = std::max(std::abs(box.min.x - center.x), std::abs(box.max.x - center.x));
+        const float dy = std::max(std::abs(box.min.y - center.y), std::abs(box.max.y - center.y));
+        const float dz = std::max(std::abs(box.min.z - center.z), std::abs(box.max.z - center.z));
+        radiusSq = dx * dx + dy * dy + dz * dz;
+    }
+    return add(object, center, std::sqrt(radiusSq));
+}
+
+SceneCuller::ProxyId SceneCuller::add(Object3D& object, const Vector3& center, float radius) {
+    const int leaf = allocateNode();
+    Node& node = nodes_[leaf];
+    node.box = fatBounds(center, radius);
+    node.height = 0;
+    node.object = &object;
+    node.radius = radius;
+    node.caster = castsShadow(object);
+    insertLeaf(leaf);
+    ++proxyCount_;
+
+    // New objects start out visible, so track them until the next cull decides otherwise.
+    visible_.push_back(leaf);
+    return leaf;
+}
+
+void SceneCuller::remove(ProxyId proxy) {
+    if (proxy < 0 || proxy >= static_cast<int>(nodes_.size()) || !nodes_[proxy].object) return;
+
+    nodes_[proxy].object->visible = true;
+    removeLeaf(proxy);
+    freeNode(proxy);
+    --proxyCount_;
+}
+
+void SceneCuller::move(ProxyId proxy, const Vector3& center) {
+    if (proxy < 0 || proxy >= static_cast<int>(nodes_.size()) || !nodes_[proxy].object) return;
+
+    Node& node = nodes_[proxy];
+    const float r = node.radius;
+    const Bounds& fat = node.box;
+    if (center.x - r >= fat.min[0] && center.y - r >= fat.min[1] && center.z - r >= fat.min[2] &&
+        center.x + r <= fat.max[0] && center.y + r <= fat.max[1] && center.z + r <= fat.max[2]) {
+        return;
+    }
+
+    removeLeaf(proxy);
+    nodes_[proxy].box = fatBounds(center, r);
+    insertLeaf(proxy);
+}
+
+void SceneCuller::clear() {
+    for (const Node& node : nodes_) {
+        if (node.height == 0 && node.object) {
+            node.object->visible = true;
+        }
+    }
+    nodes_.clear();
+    visible_.clear();
+    nextVisible_.clear();
+    root_ = NullNode;
+    freeList_ = NullNode;
+    proxyCount_ = 0;
+    stats_ = {};
+}
+
+void SceneCuller::shiftOrigin(const Vector3& shift) {
+    const float d[3] = {shift.x, shift.y, shift.z};
+    for (Node& node : nodes_) {
+        if (node.height < 0) continue;
+        for (int i = 0; i < 3; ++i) {
+            node.box.min[i] -= d[i];
+            node.box.max[i] -= d[i];
+        }
+    }
+}
+
+void SceneCuller::setEnabled(bool enabled) {
+    if (enabled_ == enabled) return;
+    enabled_ = enabled;
+    if (!enabled_) {
+        for (const Node& node : nodes_) {
+            if (node.height == 0 && node.object) {
+                node.object->visible = true;
+            }
+        }
+    }
+}
+
+void SceneCuller::cull(Camera& camera, Camera* shadowCamera) {
+    stats_.proxies = proxyCount_;
+    stats_.nodesTested = 0;
+    stats_.toggled = 0;
+    if (!enabled_) {
+        stats_.visible = proxyCount_;
+        stats_.culled = 0;
+        return;
+    }
+
+    ++frame_;
+    nextVisible_.clear();
+    Plane planes[6];
+    extractPlanes(camera, planes);
+    collectVisible(planes, false);
+    if (shadowCamera) {
+        extractPlanes(*shadowCamera, planes);
+        collectVisible(planes, true);
+    }
+
+    // Only objects that were visible last frame can need hiding, which keeps the
+    // cost proportional to what is on screen instead of the whole scene.
+    for (ProxyId id : visible_) {
+        Node& node = nodes_[id];
+        if (node.height == 0 && node.object && node.visibleFrame != frame_ && node.object->visible) {
+            node.object->visible = false;
+            ++stats_.toggled;
+        }
+    }
+    visible_.swap(nextVisible_);
+
+    stats_.visible = static_cast<int>(visible_.size());
+    stats_.culled = proxyCount_ - stats_.visible;
+}
+
+void SceneCuller::collectVisible(const Plane (&planes)[6], bool castersOnly) {
+    stack_.clear();
+    if (root_ != NullNode) {
+        stack_.emplace_back(root_, false);
+    }
+
+    while (!stack_.empty()) {
+        auto [index, inside] = stack_.back();
+        stack_.pop_back();
+        Node& node = nodes_[index];
+
+        if (!inside) {
+            ++stats_.nodesTested;
+            Containment result = Containment::Inside;
+            for (const Plane& p : planes) {
+                const float px = p.nx >= 0.f ? node.box.max[0] : node.box.min[0];
+                const float py = p.ny >= 0.f ? node.box.max[1] : node.box.min[1];
+                const float pz = p.nz >= 0.f ? node.box.max[2] : node.box.min[2];
+                if (p.nx * px + p.ny * py + p.nz * pz + p.d < -frustumMargin_) {
+                    result = Containment::Outside;
+                    break;
+                }
+                const float nx = p.nx >= 0.f ? node.box.min[0] : node.box.max[0];
+                const float ny = p.ny >= 0.f ? node.box.min[1] : node.box.max[1];
+                const float nz = p.nz >= 0.f ? node.box.min[2] : node.box.max[2];
+                if (p.nx * nx + p.ny * ny + p.nz * nz + p.d < -frustumMargin_) {
+                    result = Containment::Intersecting;
+                }
+            }
+            if (result == Containment::Outside) continue;
+            inside = result == Containment::Inside;
+        }
+
+        if (node.isLeaf()) {
+            // Already shown by the camera pass, or not a caster in the shadow pass.
+            if (node.visibleFrame == frame_ || (castersOnly && !node.caster)) continue;
+            node.visibleFrame = frame_;
+            if (!node.object->visible) {
+                node.object->visible = true;
+                ++stats_.toggled;
+            }
+            nextVisible_.push_back(index);
+        } else {
+            stack_.emplace_back(node.child1, inside);
+            stack_.emplace_back(node.child2, inside);
+        }
+    }
+}
+
+void SceneCuller::extractPlanes(Camera& camera, Plane (&planes)[6]) {
+    camera.updateMatrixWorld();
+    Matrix4 m;
+    m.multiplyMatrices(camera.projectionMatrix, camera.matrixWorldInverse);
+    const auto& e = m.elements;
+    const float rows[6][4] = {
+        {e[3] - e[0], e[7] - e[4], e[11] - e[8], e[15] - e[12]},
+        {e[3] + e[0], e[7] + e[4], e[11] + e[8], e[15] + e[12]},
+        {e[3] + e[1], e[7] + e[5], e[11] + e[9], e[15] + e[13]},
+        {e[3] - e[1], e[7] - e[5], e[11] - e[9], e[15] - e[13]},
+        {e[3] - e[2], e[7] - e[6], e[11] - e[10], e[15] - e[14]},
+        {e[3] + e[2], e[7] + e[6], e[11] + e[10], e[15] + e[14]},
+    };
+    for (int i = 0; i < 6; ++i) {
+        const float len = std::sqrt(rows[i][0] * rows[i][0] + rows[i][1] * rows[i][1] + rows[i][2] * rows[i][2]);
+        const float inv = len > 0.f ? 1.f / len : 0.f;
+        planes[i] = {rows[i][0] * inv, rows[i][1] * inv, rows[i][2] * inv, rows[i][3] * inv};
+    }
+}
+
+SceneCuller::Bounds SceneCuller::fatBounds(const Vector3& center, float radius) const {
+    const float r = radius + fatMargin_;
+    return {{center.x - r, center.y - r, center.z - r}, {center.x + r, center.y + r, center.z + r}};
+}
+
+int SceneCuller::allocateNode() {
+    if (freeList_ == NullNode) {
+        nodes_.emplace_back();
+        return static_cast<int>(nodes_.size()) - 1;
+    }
+    const int node = freeList_;
+    freeList_ = nodes_[node].parent;
+    nodes_[node] = Node{};
+    return node;
+}
+
+void SceneCuller::freeNode(int node) {
+    nodes_[node] = Node{};
+    nodes_[node].parent = freeList_;
+    freeList_ = node;
+}
+
+SceneCuller::Bounds SceneCuller::merge(const Bounds& a, const Bounds& b) {
+    Bounds result;
+    for (int i = 0; i < 3; ++i) {
+        result.min[i] = std::min(a.min[i], b.min[i]);
+        result.max[i] = std::max(a.max[i], b.max[i]);
+    }
+    return result;
+}
+
+float SceneCuller::perimeter(const Bounds& b) {
+    return 2.f * ((b.max[0] - b.min[0]) + (b.max[1] - b.min[1]) + (b.max[2] - b.min[2]));
+}
+
+void SceneCuller::insertLeaf(int leaf) {
+    if (root_ == NullNode) {
+        root_ = leaf;
+        nodes_[root_].parent = NullNode;
+        return;
+    }
+
+    // Descend towards the sibling with the lowest surface-area-heuristic cost.
+    const Bounds leafBox = nodes_[leaf].box;
+    int index = root_;
+    while (!nodes_[index].isLeaf()) {
+        const Node& node = nodes_[index];
+        const float area = perimeter(node.box);
+        const float combinedArea = perimeter(merge(node.box, leafBox));
+        const float cost = 2.f * combinedArea;
+        const float inheritance = 2.f * (combinedArea - area);
+
+        auto childCost = [&](int child) {
+            const Node& c = nodes_[child];
+            const float merged = perimeter(merge(c.box, leafBox));
+            return (c.isLeaf() ? merged : merged - perimeter(c.box)) + inheritance;
+        };
+        const float cost1 = childCost(node.child1);
+        const float cost2 = childCost(node.child2);
+
+        if (cost < cost1 && cost < cost2) break;
+        index = cost1 < cost2 ? node.child1 : node.child2;
+    }
+
+    const int sibling = index;
+    const int newParent = allocateNode();
+    const int oldParent = nodes_[sibling].parent;
+    nodes_[newParent].parent = oldParent;
+    nodes_[newParent].box = merge(leafBox, nodes_[sibling].box);
+    nodes_[newParent].height = nodes_[sibling].height + 1;
+    nodes_[newParent].child1 = sibling;
+    nodes_[newParent].child2 = leaf;
+    nodes_[sibling].parent = newParent;
+    nodes_[leaf].parent = newParent;
+
+    if (oldParent != NullNode) {
+        if (nodes_[oldParent].child1 == sibling) {
+            nodes_[oldParent].child1 = newParent;
+        } else {
+            nodes_[oldParent].child2 = newParent;
+        }
+    } else {
+        root_ = newParent;
+    }
+
+    index = nodes_[leaf].parent;
+    while (index != NullNode) {
+        index = balance(index);
+        Node& node = nodes_[index];
+        node.height = 1 + std::max(nodes_[node.child1].height, nodes_[node.child2].height);
+        node.box = merge(nodes_[node.child1].box, nodes_[node.child2].box);
+        index = node.parent;
+    }
+}
+
+void SceneCuller::removeLeaf(int leaf) {
+    if (leaf == root_) {
+        root_ = NullNode;
+        return;
+    }
+
+    const int parent = nodes_[leaf].parent;
+    const int grandParent = nodes_[parent].parent;
+    const int sibling = nodes_[parent].child1 == leaf ? nodes_[parent].child2 : nodes_[parent].child1;
+
+    if (grandParent == NullNode) {
+        root_ = sibling;
+        nodes_[sibling].parent = NullNode;
+        freeNode(parent);
+        return;
+    }
+
+    if (nodes_[grandParent].child1 == parent) {
+        nodes_[grandParent].child1 = sibling;
+    } else {
+        nodes_[grandParent].child2 = sibling;
+    }
+    nodes_[sibling].parent = grandParent;
+    freeNode(parent);
+
+    int index = grandParent;
+    while (index != NullNode) {
+        index = balance(index);
+        Node& node = nodes_[index];
+        node.height = 1 + std::max(nodes_[node.child1].height, nodes_[node.child2].height);
+        node.box = merge(nodes_[node.child1].box, nodes_[node.child2].box);
+        index = node.parent;
+    }
+}
+
+int SceneCuller::balance(int iA) {
+    Node& A = nodes_[iA];
+    if (A.isLeaf() || A.height < 2) return iA;
+
+    const int iB = A.child1;
+    const int iC = A.child2;
+    Node& B = nodes_[iB];
+    Node& C = nodes_[iC];
+    const int diff = C.height - B.height;
+
+    auto replaceInParent = [&](int oldChild, int newChild) {
+        const int parent = nodes_[newChild].parent;
+        if (parent == NullNode) {
+            root_ = newChild;
+        } else if (nodes_[parent].child1 == oldChild) {
+            nodes_[parent].child1 = newChild;
+        } else {
+            nodes_[parent].child2 = newChild;
+        }
+    };
+
+    // Rotate C up.
+    if (diff > 1) {
+        const int iF = C.child1;
+        const int iG = C.child2;
+        Node& F = nodes_[iF];
+        Node& G = nodes_[iG];
+
+        C.child1 = iA;
+        C.parent = A.parent;
+        A.parent = iC;
+        replaceInParent(iA, iC);
+
+        if (F.height > G.height) {
+            C.child2 = iF;
+            A.child2 = iG;
+            G.parent = iA;
+            A.box = merge(B.box, G.box);
+            C.box = merge(A.box, F.box);
+            A.height = 1 + std::max(B.height, G.height);
+            C.height = 1 + std::max(A.height, F.height);
+        } else {
+            C.child2 = iG;
+            A.child2 = iF;
+            F.parent = iA;
+            A.box = merge(B.box, F.box);
+            C.box = merge(A.box, G.box);
+            A.height = 1 + std::max(B.height, F.height);
+            C.height = 1 + std::max(A.height, G.height);
+        }
+        return iC;
+    }
+
+    // Rotate B up.
+    if (diff < -1) {
+        const int iD = B.child1;
+        const int iE = B.child2;
+        Node& D = nodes_[iD];
+        Node& E = nodes_[iE];
+
+        B.child1 = iA;
+        B.parent = A.parent;
+        A.parent = iB;
+        replaceInParent(iA, iB);
+
+        if (D.height > E.height) {
+            B.child2 = iD;
+            A.child1 = iE;
+            E.parent = iA;
+            A.box = merge(C.box, E.box);
+            B.box = merge(A.box, D.box);
+            A.height = 1 + std::max(C.height, E.height);
+            B.height = 1 + std::max(A.height, D.height);
+        } else {
+            B.child2 = iE;
+            A.child1 = iD;
+            D.parent = iA;
+            A.box = merge(C.box, D.box);
+            B.box = merge(A.box, E.box);
+            A.height = 1 + std::max(C.height, D.height);
+            B.height = 1 + std::max(A.height, E.height);
+        }
+        return iB;
+    }
+
+    return iA;
+}
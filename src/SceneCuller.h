@@ -0,0 +1,98 @@
+#pragma once
+
+#include "threepp/threepp.hpp"
+#include <vector>
+
+// Dynamic AABB tree over scene objects used to cull whole subtrees before the
+// renderer walks the scene graph. Each proxy owns a fattened box so small moves
+// do not touch the tree; culling visits O(log N + visible) nodes.
+class SceneCuller {
+public:
+    using ProxyId = int;
+    static constexpr ProxyId NullProxy = -1;
+
+    struct Stats {
+        int proxies = 0;
+        int visible = 0;
+        int culled = 0;
+        int nodesTested = 0;
+        // Objects whose visibility flipped during the last cull.
+        int toggled = 0;
+    };
+
+    explicit SceneCuller(float fatMargin = 2.f);
+
+    // Registers an object whose world transform is already up to date. The bounding
+    // radius is measured around the object's origin, so it stays valid under rotation.
+    // Objects with a shadow-casting mesh anywhere in their subtree are tracked as casters.
+    ProxyId add(threepp::Object3D& object);
+    ProxyId add(threepp::Object3D& object, const threepp::Vector3& center, float radius);
+    void remove(ProxyId proxy);
+    void move(ProxyId proxy, const threepp::Vector3& center);
+    void clear();
+    // Translates every proxy by -shift. A uniform translation keeps the tree valid.
+    void shiftOrigin(const threepp::Vector3& shift);
+
+    // Shows objects inside the camera frustum. When a shadow camera is given, casters
+    // inside its frustum stay visible too, so off-screen objects keep their shadows.
+    void cull(threepp::Camera& camera, threepp::Camera* shadowCamera = nullptr);
+
+    void setEnabled(bool enabled);
+    bool enabled() const { return enabled_; }
+    // Extra distance outside the view frustum that is still treated as visible, so
+    // objects just off screen are not toggled on every small camera move.
+    void setFrustumMargin(float margin) { frustumMargin_ = margin; }
+    float frustumMargin() const { return frustumMargin_; }
+
+    const Stats& stats() const { return stats_; }
+
+private:
+    static constexpr int NullNode = -1;
+
+    struct Bounds {
+        float min[3];
+        float max[3];
+    };
+
+    struct Node {
+        Bounds box{};
+        int parent = NullNode; // next free node while on the free list
+        int child1 = NullNode;
+        int child2 = NullNode;
+        int height = -1;
+        threepp::Object3D* object = nullptr;
+        float radius = 0.f;
+        unsigned visibleFrame = 0;
+        bool caster = false;
+
+        bool isLeaf() const { return child1 == NullNode; }
+    };
+
+    struct Plane {
+        float nx, ny, nz, d;
+    };
+
+    static void extractPlanes(threepp::Camera& camera, Plane (&planes)[6]);
+    void collectVisible(const Plane (&planes)[6], bool castersOnly);
+    int allocateNode();
+    void freeNode(int node);
+    void insertLeaf(int leaf);
+    void removeLeaf(int leaf);
+    int balance(int node);
+    Bounds fatBounds(const threepp::Vector3& center, float radius) const;
+    static Bounds merge(const Bounds& a, const Bounds& b);
+    static float perimeter(const Bounds& b);
+
+    std::vector<Node> nodes_;
+    int root_ = NullNode;
+    int freeList_ = NullNode;
+    int proxyCount_ = 0;
+    float fatMargin_;
+    float frustumMargin_ = 2.f;
+    bool enabled_ = true;
+    unsigned frame_ = 0;
+    std::vector<ProxyId> visible_;
+    std::vector<ProxyId> nextVisible_;
+    std::vector<std::pair<int, bool>> stack_;
+    Stats stats_;
+};
@@ -0,0 +1,85 @@
+#include "ShadowRig.h"
+
+#include "threepp/cameras/OrthographicCamera.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace threepp;
+
+ShadowRig::ShadowRig(Scene& scene, const Vector3& lightDirection, const ShadowSettings& settings)
+    : settings_(settings) {
+    direction_.copy(lightDirection).normalize();
+
+    // Light-space axes used for texel snapping.
+    Vector3 worldUp(0, 1, 0);
+    if (std::abs(direction_.dot(worldUp)) > 0.99f) {
+        worldUp.set(0, 0, 1);
+    }
+    right_.crossVectors(worldUp, direction_).normalize();
+    up_.crossVectors(direction_, right_).normalize();
+
+    const float extent = settings_.extent;
+    light_ = DirectionalLight::create(Color::white, 1.f);
+    light_->castShadow = true;
+    light_->shadow->mapSize.set(settings_.mapSize, settings_.mapSize);
+    light_->shadow->camera->nearPlane = 1.f;
+    light_->shadow->camera->farPlane = settings_.distance * 2.f;
+    if (auto* shadowCam = dynamic_cast<OrthographicCamera*>(light_->shadow->camera.get())) {
+        shadowCam->left = -extent;
+        shadowCam->right = extent;
+        shadowCam->top = extent;
+        shadowCam->bottom = -extent;
+        shadowCam->updateProjectionMatrix();
+    }
+    scene.add(light_);
+}
+
+void ShadowRig::update(const Vector3& focus) {
+    // Move in whole texels only; sub-texel moves would resample every static
+    // shadow edge and make it crawl.
+    const float texel = 2.f * settings_.extent / static_cast<float>(settings_.mapSize);
+    const float snappedR = std::floor(focus.dot(right_) / texel) * texel;
+    const float snappedU = std::floor(focus.dot(up_) / texel) * texel;
+    const Vector3 center = right_ * snappedR + up_ * snappedU + direction_ * focus.dot(direction_);
+
+    if (placed_ && center.x == center_.x && center.y == center_.y && center.z == center_.z) {
+        return;
+    }
+
+    center_ = center;
+    placed_ = true;
+    light_->position.copy(center + direction_ * settings_.distance);
+    light_->target->position.copy(center);
+    light_->target->updateMatrixWorld();
+    // The renderer places the shadow camera itself, but only when it renders the
+    // map; placing it here keeps it valid for culling casters in between.
+    Camera& shadowCamera = *light_->shadow->camera;
+    shadowCamera.position.copy(light_->position);
+    shadowCamera.lookAt(center);
+    shadowCamera.updateMatrixWorld();
+    dirty_ = true;
+}
+
+bool ShadowRig::covers(const Vector3& position, float radius) const {
+    if (!placed_) return true;
+    // The frustum is a box along the light direction, so only the two
+    // cross-light axes can put a caster outside it.
+    const Vector3 offset = position - center_;
+    const float reach = settings_.extent + radius;
+    return std::abs(offset.dot(right_)) <= reach && std::abs(offset.dot(up_)) <= reach;
+}
+
+bool ShadowRig::consumeDirty() {
+    ++framesSinceRender_;
+    const bool dirty = dirty_ || (moved_ && framesSinceRender_ >= std::max(settings_.dynamicInterval, 1));
+    if (dirty) {
+        dirty_ = false;
+        moved_ = false;
+        framesSinceRender_ = 0;
+        ++renderedFrames_;
+    } else {
+        ++skippedFrames_;
+    }
+    return dirty;
+}
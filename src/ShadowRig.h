@@ -0,0 +1,65 @@
+#pragma once
+
+#include "threepp/threepp.hpp"
+#include <memory>
+
+struct ShadowSettings {
+    int mapSize = 4096;
+    // Half-size of the orthographic shadow frustum.
+    float extent = 60.f;
+    // Distance of the light from the focus point along the light direction.
+    float distance = 80.f;
+    // Moving casters re-render the map at most every this many frames; static
+    // changes and frustum moves still re-render on the next frame. Anything above
+    // 1 leaves moving shadows that many frames behind their casters.
+    int dynamicInterval = 1;
+};
+
+// Directional light whose shadow frustum follows a focus point. The frustum is
+// snapped to whole shadow-map texels so static shadows do not shimmer, and the
+// shadow map is only re-rendered when the frustum moves or a caster inside it
+// changes.
+//
+// This is deliberately one map rather than cascades. threepp's shaders sample a
+// single map per light and cannot pick a cascade per fragment, so cascades would
+// mean extra lights that each add their own lighting. The camera stays close to
+// the followed vehicle, so a 120 m square at 4096 texels (about 3 cm per texel)
+// covers everything near enough to need a shadow; beyond it the ground is lit
+// without shadows.
+class ShadowRig {
+public:
+    // Bounding radius of the largest vehicle, for covers() tests on vehicles.
+    static constexpr float VehicleCasterRadius = 6.f;
+
+    ShadowRig(threepp::Scene& scene, const threepp::Vector3& lightDirection, const ShadowSettings& settings = {});
+
+    void update(const threepp::Vector3& focus);
+    // Re-render on the next frame, e.g. after casters were added or removed.
+    void markDirty() { dirty_ = true; }
+    // Whether a caster of `radius` around `position` can fall into the shadow map.
+    bool covers(const threepp::Vector3& position, float radius) const;
+    // A covered caster moved; re-rendered at the dynamic interval.
+    void casterMoved() { moved_ = true; }
+    // Returns whether the shadow map must be re-rendered this frame and clears the flags.
+    bool consumeDirty();
+
+    // Camera covering the current shadow frustum.
+    threepp::Camera& camera() { return *light_->shadow->camera; }
+    const ShadowSettings& settings() const { return settings_; }
+    int renderedFrames() const { return renderedFrames_; }
+    int skippedFrames() const { return skippedFrames_; }
+
+private:
+    ShadowSettings settings_;
+    threepp::Vector3 direction_;
+    threepp::Vector3 right_;
+    threepp::Vector3 up_;
+    std::shared_ptr<threepp::DirectionalLight> light_;
+    threepp::Vector3 center_;
+    bool placed_ = false;
+    bool dirty_ = true;
+    bool moved_ = false;
+    int framesSinceRender_ = 0;
+    int renderedFrames_ = 0;
+    int skippedFrames_ = 0;
+};
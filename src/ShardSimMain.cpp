@@ -0,0 +1,108 @@
+#include "ShardedSim.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+struct Options {
+    ShardedSim::Config sim;
+    float seconds = 30.f;
+};
+
+void printUsage() {
+    std::printf(
+        "Usage: VehicleShardSim [options]\n"
+        "  --grid CxR      shard columns and rows (default 2x1)\n"
+        "  --vehicles N    vehicles spawned per shard (default 500)\n"
+        "  --seconds S     simulated seconds (default 30)\n"
+        "  --border M      proxy margin around each shard in metres (default 12)\n"
+        "  --threads N     Jolt worker threads per shard (default: cores / shards)\n");
+}
+
+void printReport(const ShardedSim& sim) {
+    std::printf("t=%6.1fs  %d vehicles, tick %.2f ms\n", static_cast<float>(sim.tick()) * sim.config().dt,
+                sim.totalVehicles(), sim.lastTickMs());
+    for (int i = 0; i < sim.shardCount(); ++i) {
+        const ShardedSim::ShardStats& s = sim.shardStats(i);
+        std::printf("  shard %d pid %-7d %5d vehicles %4d proxies  step %6.2f ms mean %6.2f max  handoff in %llu out %llu\n", i,
+                    s.pid, s.vehicles, s.proxies, s.meanStepMs(), s.maxStepMs, static_cast<unsigned long long>(s.handoffsIn),
+                    static_cast<unsigned long long>(s.handoffsOut));
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (std::strcmp(arg, "--help") == 0) {
+            printUsage();
+            return 0;
+        }
+        if (!value) {
+            printUsage();
+            return 1;
+        }
+        if (std::strcmp(arg, "--grid") == 0) {
+            if (std::sscanf(value, "%dx%d", &options.sim.columns, &options.sim.rows) != 2) {
+                printUsage();
+                return 1;
+            }
+        } else if (std::strcmp(arg, "--vehicles") == 0) {
+            options.sim.vehiclesPerShard = std::max(0, std::atoi(value));
+        } else if (std::strcmp(arg, "--seconds") == 0) {
+            options.seconds = std::strtof(value, nullptr);
+        } else if (std::strcmp(arg, "--border") == 0) {
+            options.sim.borderMargin = std::strtof(value, nullptr);
+        } else if (std::strcmp(arg, "--threads") == 0) {
+            options.sim.threadsPerShard = static_cast<uint32_t>(std::max(0, std::atoi(value)));
+        } else {
+            printUsage();
+            return 1;
+        }
+        ++i;
+    }
+
+    // No Jolt state may exist in this process before the shards fork.
+    auto sim = ShardedSim::launch(options.sim);
+    if (!sim) return 1;
+
+    const ShardedSim::Config& config = sim->config();
+    const auto steps = static_cast<uint64_t>(std::max(options.seconds, 0.f) / config.dt);
+    const auto stepsPerReport = std::max<uint64_t>(1, static_cast<uint64_t>(1.f / config.dt));
+    std::printf("%dx%d shards, %d vehicles, %.0f simulated seconds\n", config.columns, config.rows, sim->totalVehicles(),
+                options.seconds);
+
+    double totalTickMs = 0.0;
+    float maxTickMs = 0.f;
+    while (sim->tick() < steps) {
+        if (!sim->step()) {
+            std::fprintf(stderr, "error: a shard stopped responding at tick %llu\n", static_cast<unsigned long long>(sim->tick()));
+            return 1;
+        }
+        totalTickMs += sim->lastTickMs();
+        maxTickMs = std::max(maxTickMs, sim->lastTickMs());
+        if (sim->tick() % stepsPerReport == 0) {
+            printReport(*sim);
+            sim->resetMaxima();
+        }
+    }
+
+    uint64_t handoffs = 0;
+    uint64_t bytes = 0;
+    for (int i = 0; i < sim->shardCount(); ++i) {
+        handoffs += sim->shardStats(i).handoffsOut;
+        bytes += sim->shardStats(i).bytesIn + sim->shardStats(i).bytesOut;
+    }
+    const double meanTickMs = steps > 0 ? totalTickMs / static_cast<double>(steps) : 0.0;
+    std::printf("done: %llu ticks, tick %.2f ms mean %.2f ms max (%.1fx real time), %llu handoffs, %.1f MB exchanged\n",
+                static_cast<unsigned long long>(steps), meanTickMs, maxTickMs,
+                meanTickMs > 0.0 ? 1000.0 * config.dt / meanTickMs : 0.0, static_cast<unsigned long long>(handoffs),
+                static_cast<double>(bytes) / (1024.0 * 1024.0));
+    return 0;
+}
@@ -0,0 +1,719 @@
+#include "ShardedSim.h"
+
+#include "FleetSpawner.h"
+#include "JoltRuntime.h"
+#include "PhysicsVehicle.h"
+#include "PhysicsWorld.h"
+#include "TrackLayout.h"
+#include "VehicleRegistry.h"
+
+#include <Jolt/Physics/Body/BodyCreationSettings.h>
+#include <Jolt/Physics/Body/BodyInterface.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <unordered_map>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace JPH;
+
+namespace {
+
+enum class FrameType : uint8_t {
+    Ready = 1,
+    Step,
+    StepDone,
+    Shutdown
+};
+
+enum class RecordType : uint8_t {
+    Handoff = 1,
+    Proxy
+};
+
+// Little helpers over a byte vector; both ends run the same binary, so PODs are
+// copied as they are.
+class FrameWriter {
+public:
+    explicit FrameWriter(std::vector<uint8_t>& out)
+        : out_(out) {}
+
+    template<typename T>
+    void put(const T& value) {
+        putBytes(&value, sizeof(T));
+    }
+    void putBytes(const void* data, size_t size) {
+        const size_t at = out_.size();
+        out_.resize(at + size);
+        std::memcpy(out_.data() + at, data, size);
+    }
+    size_t size() const { return out_.size(); }
+    // Patches a value written earlier, e.g. a record count or size.
+    template<typename T>
+    void patch(size_t at, const T& value) {
+        std::memcpy(out_.data() + at, &value, sizeof(T));
+    }
+
+private:
+    std::vector<uint8_t>& out_;
+};
+
+class FrameReader {
+public:
+    FrameReader(const uint8_t* data, size_t size)
+        : data_(data), size_(size) {}
+
+    template<typename T>
+    T get() {
+        T value{};
+        if (pos_ + sizeof(T) > size_) {
+            ok_ = false;
+            return value;
+        }
+        std::memcpy(&value, data_ + pos_, sizeof(T));
+        pos_ += sizeof(T);
+        return value;
+    }
+    const uint8_t* take(size_t size) {
+        if (pos_ + size > size_) {
+            ok_ = false;
+            return nullptr;
+        }
+        const uint8_t* at = data_ + pos_;
+        pos_ += size;
+        return at;
+    }
+    bool ok() const { return ok_; }
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+    size_t pos_ = 0;
+    bool ok_ = true;
+};
+
+struct Cell {
+    float minX;
+    float minZ;
+    float maxX;
+    float maxZ;
+};
+
+// Area a shard owns. Edge shards own everything beyond the grid on their side.
+Cell ownedArea(const ShardedSim::Config& config, int shard) {
+    const int column = shard % config.columns;
+    const int row = shard / config.columns;
+    const float width = (config.maxX - config.minX) / static_cast<float>(config.columns);
+    const float depth = (config.maxZ - config.minZ) / static_cast<float>(config.rows);
+    Cell cell{config.minX + width * column, config.minZ + depth * row, config.minX + width * (column + 1),
+              config.minZ + depth * (row + 1)};
+    if (column == 0) cell.minX = -FLT_MAX;
+    if (row == 0) cell.minZ = -FLT_MAX;
+    if (column == config.columns - 1) cell.maxX = FLT_MAX;
+    if (row == config.rows - 1) cell.maxZ = FLT_MAX;
+    return cell;
+}
+
+float distanceOutside(const Cell& cell, float x, float z) {
+    const float dx = std::max({cell.minX - x, 0.f, x - cell.maxX});
+    const float dz = std::max({cell.minZ - z, 0.f, z - cell.maxZ});
+    return std::sqrt(dx * dx + dz * dz);
+}
+
+#ifndef _WIN32
+
+bool writeAll(int fd, const uint8_t* data, size_t size) {
+    while (size > 0) {
+#ifdef MSG_NOSIGNAL
+        // A dead peer must surface as an error, not SIGPIPE.
+        const ssize_t written = ::send(fd, data, size, MSG_NOSIGNAL);
+#else
+        const ssize_t written = ::write(fd, data, size);
+#endif
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool readAll(int fd, uint8_t* data, size_t size) {
+    while (size > 0) {
+        const ssize_t got = ::read(fd, data, size);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return false;
+        data += got;
+        size -= static_cast<size_t>(got);
+    }
+    return true;
+}
+
+// Frames are length-prefixed on a stream socket.
+bool sendFrame(int fd, const std::vector<uint8_t>& frame) {
+    const auto size = static_cast<uint32_t>(frame.size());
+    return writeAll(fd, reinterpret_cast<const uint8_t*>(&size), sizeof(size)) && writeAll(fd, frame.data(), frame.size());
+}
+
+bool receiveFrame(int fd, std::vector<uint8_t>& frame) {
+    uint32_t size = 0;
+    if (!readAll(fd, reinterpret_cast<uint8_t*>(&size), sizeof(size))) return false;
+    frame.resize(size);
+    return readAll(fd, frame.data(), size);
+}
+
+// One region's world, living in its own process.
+class ShardWorker {
+public:
+    ShardWorker(int index, int fd, const ShardedSim::Config& config)
+        : index_(index), fd_(fd), config_(config), owned_(ownedArea(config, index)) {}
+
+    int run() {
+        createWorld();
+        frame_.clear();
+        FrameWriter ready(frame_);
+        ready.put(FrameType::Ready);
+        ready.put(static_cast<uint32_t>(vehicles_->size()));
+        if (!sendFrame(fd_, frame_)) return 1;
+
+        while (receiveFrame(fd_, frame_)) {
+            FrameReader in(frame_.data(), frame_.size());
+            const auto type = in.get<FrameType>();
+            if (type == FrameType::Shutdown) return 0;
+            if (type != FrameType::Step) return 1;
+            tick_ = in.get<uint32_t>();
+            if (!applyRecords(in, in.get<uint32_t>())) return 1;
+
+            drive();
+            const auto start = std::chrono::steady_clock::now();
+            world_->step(config_.dt);
+            const float stepMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            frame_.clear();
+            FrameWriter out(frame_);
+            out.put(FrameType::StepDone);
+            out.put(stepMs);
+            const size_t countsAt = out.size();
+            out.put(uint32_t(0));
+            out.put(uint32_t(0));
+            out.put(uint32_t(0));
+            const uint32_t records = emitRecords(out);
+            out.patch(countsAt, static_cast<uint32_t>(vehicles_->size()));
+            out.patch(countsAt + 4, static_cast<uint32_t>(proxies_.size()));
+            out.patch(countsAt + 8, records);
+            if (!sendFrame(fd_, frame_)) return 1;
+        }
+        // The coordinator went away.
+        return 1;
+    }
+
+private:
+    struct Proxy {
+        BodyID body;
+        uint32_t seenTick = 0;
+    };
+
+    void createWorld() {
+        PhysicsWorld::Config worldConfig;
+        worldConfig.maxBodies = static_cast<uint32_t>(std::max(config_.vehiclesPerShard, 0)) * 4 + 1024;
+        worldConfig.maxBodyPairs = worldConfig.maxBodies * 2;
+        worldConfig.maxContactConstraints = worldConfig.maxBodies * 2;
+        worldConfig.tempAllocatorBytes = 32 * 1024 * 1024;
+        world_ = std::make_unique<PhysicsWorld>(worldConfig);
+        Track::createGroundBody(*world_);
+        vehicles_ = std::make_unique<VehicleRegistry>(*world_);
+
+        // The track ring clipped to this shard's grid cell.
+        const int column = index_ % config_.columns;
+        const int row = index_ / config_.columns;
+        const float width = (config_.maxX - config_.minX) / static_cast<float>(config_.columns);
+        const float depth = (config_.maxZ - config_.minZ) / static_cast<float>(config_.rows);
+        FleetSpawner::Region region = FleetSpawner::Region::track();
+        region.centerX = config_.minX + width * (column + 0.5f);
+        region.centerZ = config_.minZ + depth * (row + 0.5f);
+        region.halfExtentX = 0.5f * width;
+        region.halfExtentZ = 0.5f * depth;
+
+        FleetSpawner spawner(*world_);
+        spawner.config().seed = static_cast<uint32_t>(index_) + 1;
+        std::vector<VehiclePlacement> placements;
+        spawner.plan(region, config_.vehiclesPerShard, placements);
+        // Headless: vehicles never sync a visual.
+        std::vector<VehicleModel> models(placements.size());
+        std::vector<VehicleHandle> handles;
+        vehicles_->spawnBatch(placements, models, handles);
+        for (size_t i = 0; i < handles.size(); ++i) {
+            setId(handles[i], (static_cast<uint32_t>(index_) << 20) | static_cast<uint32_t>(i));
+        }
+    }
+
+    void setId(VehicleHandle handle, uint32_t id) {
+        if (ids_.size() <= handle.index) ids_.resize(handle.index + 1);
+        ids_[handle.index] = id;
+    }
+
+    bool applyRecords(FrameReader& in, uint32_t count) {
+        for (uint32_t i = 0; i < count && in.ok(); ++i) {
+            const auto type = in.get<RecordType>();
+            const auto size = in.get<uint16_t>();
+            const uint8_t* payload = in.take(size);
+            if (!payload) break;
+            FrameReader record(payload, size);
+            if (type == RecordType::Handoff) {
+                receiveHandoff(record);
+            } else {
+                receiveProxy(record);
+            }
+        }
+
+        // Proxies whose vehicle moved away from the border were not refreshed.
+        BodyInterface& bodies = world_->bodyInterface();
+        for (auto it = proxies_.begin(); it != proxies_.end();) {
+            if (it->second.seenTick != tick_) {
+                bodies.RemoveBody(it->second.body);
+                bodies.DestroyBody(it->second.body);
+                it = proxies_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        return in.ok();
+    }
+
+    void receiveHandoff(FrameReader& in) {
+        const auto id = in.get<uint32_t>();
+        const auto type = static_cast<VehicleType>(in.get<uint8_t>());
+        const auto settings = in.get<VehicleSettings>();
+        const double x = in.get<double>();
+        const double y = in.get<double>();
+        const double z = in.get<double>();
+        state_.position = RVec3(static_cast<Real>(x), static_cast<Real>(y), static_cast<Real>(z));
+        const Float4 rotation = in.get<Float4>();
+        state_.rotation = Quat(Vec4::sLoadFloat4(&rotation));
+        state_.linearVelocity = Vec3(in.get<Float3>());
+        state_.angularVelocity = Vec3(in.get<Float3>());
+        const auto wheels = in.get<uint8_t>();
+        state_.wheelAngularVelocity.resize(wheels);
+        state_.wheelSteerAngle.resize(wheels);
+        for (uint8_t w = 0; w < wheels; ++w) {
+            state_.wheelAngularVelocity[w] = in.get<float>();
+            state_.wheelSteerAngle[w] = in.get<float>();
+        }
+        state_.engineRpm = in.get<float>();
+        state_.gear = in.get<int32_t>();
+        state_.clutchFriction = in.get<float>();
+        state_.trackAngularVelocity[0] = in.get<float>();
+        state_.trackAngularVelocity[1] = in.get<float>();
+        if (!in.ok()) return;
+
+        // The vehicle may have been mirrored here while it approached.
+        removeProxy(id);
+        const VehicleHandle handle = vehicles_->spawn(type, state_.position, &settings);
+        vehicles_->get(handle)->restoreState(state_);
+        setId(handle, id);
+    }
+
+    void receiveProxy(FrameReader& in) {
+        const auto id = in.get<uint32_t>();
+        const auto type = static_cast<VehicleType>(in.get<uint8_t>());
+        const double x = in.get<double>();
+        const double y = in.get<double>();
+        const double z = in.get<double>();
+        const RVec3 position(static_cast<Real>(x), static_cast<Real>(y), static_cast<Real>(z));
+        const Float4 q = in.get<Float4>();
+        const Quat rotation(Vec4::sLoadFloat4(&q));
+        const Vec3 linear(in.get<Float3>());
+        const Vec3 angular(in.get<Float3>());
+        if (!in.ok()) return;
+
+        BodyInterface& bodies = world_->bodyInterface();
+        auto it = proxies_.find(id);
+        if (it == proxies_.end()) {
+            // Chassis only, dynamic with the vehicle's mass: a local vehicle hitting it
+            // gets the response of hitting the real vehicle, where a kinematic proxy
+            // would act as an immovable wall. The proxy's own response is discarded
+            // when the owner's next state arrives. Without wheels it would sink, so
+            // it carries no gravity and simply coasts at the sent velocity.
+            BodyCreationSettings settings(PhysicsVehicle::sharedBlueprint(type).chassis.GetPtr(), position, rotation,
+                                          EMotionType::Dynamic, PhysicsLayers::Dynamic);
+            settings.mGravityFactor = 0.f;
+            settings.mAllowSleeping = false;
+            settings.mOverrideMassProperties = EOverrideMassProperties::CalculateInertia;
+            settings.mMassPropertiesOverride.mMass = PhysicsVehicle::defaultSettings(type).mass;
+            const BodyID body = bodies.CreateAndAddBody(settings, EActivation::Activate);
+            if (body.IsInvalid()) return;
+            it = proxies_.emplace(id, Proxy{body, tick_}).first;
+        } else {
+            bodies.SetPositionAndRotation(it->second.body, position, rotation, EActivation::Activate);
+        }
+        bodies.SetLinearAndAngularVelocity(it->second.body, linear, angular);
+        it->second.seenTick = tick_;
+    }
+
+    void removeProxy(uint32_t id) {
+        auto it = proxies_.find(id);
+        if (it == proxies_.end()) return;
+        BodyInterface& bodies = world_->bodyInterface();
+        bodies.RemoveBody(it->second.body);
+        bodies.DestroyBody(it->second.body);
+        proxies_.erase(it);
+    }
+
+    // Every vehicle keeps to the lane it is in.
+    void drive() {
+        inputs_.resize(vehicles_->size());
+        for (size_t i = 0; i < vehicles_->size(); ++i) {
+            const PhysicsVehicle& vehicle = (*vehicles_)[i];
+            const RVec3 position = vehicle.position();
+            const float radius = std::sqrt(static_cast<float>(position.GetX() * position.GetX() + position.GetZ() * position.GetZ()));
+            const float lane = std::clamp(radius, Track::Inner + 2.f, Track::Outer - 2.f);
+            inputs_[i] = Track::followRacingLine(position, vehicle.rotation(), vehicle.velocity(), config_.targetSpeed, lane);
+        }
+        vehicles_->applyInputs(inputs_);
+    }
+
+    // Hands off vehicles that left the owned area and mirrors the ones near a
+    // neighbour. Records are written as kind, target, size, payload.
+    uint32_t emitRecords(FrameWriter& out) {
+        uint32_t records = 0;
+        const int column = index_ % config_.columns;
+        const int row = index_ / config_.columns;
+        leaving_.clear();
+
+        for (size_t i = 0; i < vehicles_->size(); ++i) {
+            const PhysicsVehicle& vehicle = (*vehicles_)[i];
+            const VehicleHandle handle = vehicles_->handleAt(i);
+            const RVec3 position = vehicle.position();
+            const float x = static_cast<float>(position.GetX());
+            const float z = static_cast<float>(position.GetZ());
+
+            const int owner = ShardedSim::shardAt(config_, x, z);
+            if (owner != index_ && distanceOutside(owned_, x, z) > config_.handoffHysteresis) {
+                writeHandoff(out, owner, ids_[handle.index], vehicle);
+                leaving_.push_back(handle);
+                ++records;
+                continue;
+            }
+
+            for (int r = std::max(row - 1, 0); r <= std::min(row + 1, config_.rows - 1); ++r) {
+                for (int c = std::max(column - 1, 0); c <= std::min(column + 1, config_.columns - 1); ++c) {
+                    const int neighbour = r * config_.columns + c;
+                    if (neighbour == index_ || distanceOutside(ownedArea(config_, neighbour), x, z) > config_.borderMargin) continue;
+                    writeProxy(out, neighbour, ids_[handle.index], vehicle);
+                    ++records;
+                }
+            }
+        }
+
+        // Despawned after the scan, since despawn reorders the dense array.
+        for (const VehicleHandle& handle : leaving_) {
+            vehicles_->despawn(handle);
+        }
+        return records;
+    }
+
+    void writeHeader(FrameWriter& out, RecordType type, int target, size_t& sizeAt) {
+        out.put(type);
+        out.put(static_cast<int32_t>(target));
+        sizeAt = out.size();
+        out.put(uint16_t(0));
+    }
+
+    void writeBody(FrameWriter& out, uint32_t id, const PhysicsVehicle& vehicle, RVec3Arg position, QuatArg rotation,
+                   Vec3Arg linear, Vec3Arg angular) {
+        out.put(id);
+        out.put(static_cast<uint8_t>(vehicle.type()));
+        out.put(static_cast<double>(position.GetX()));
+        out.put(static_cast<double>(position.GetY()));
+        out.put(static_cast<double>(position.GetZ()));
+        Float4 q;
+        rotation.GetXYZW().StoreFloat4(&q);
+        out.put(q);
+        Float3 v;
+        linear.StoreFloat3(&v);
+        out.put(v);
+        angular.StoreFloat3(&v);
+        out.put(v);
+    }
+
+    void writeHandoff(FrameWriter& out, int target, uint32_t id, const PhysicsVehicle& vehicle) {
+        size_t sizeAt = 0;
+        writeHeader(out, RecordType::Handoff, target, sizeAt);
+        const size_t begin = out.size();
+
+        vehicle.captureState(state_);
+        out.put(id);
+        out.put(static_cast<uint8_t>(vehicle.type()));
+        out.put(vehicle.settings());
+        out.put(static_cast<double>(state_.position.GetX()));
+        out.put(static_cast<double>(state_.position.GetY()));
+        out.put(static_cast<double>(state_.position.GetZ()));
+        Float4 q;
+        state_.rotation.GetXYZW().StoreFloat4(&q);
+        out.put(q);
+        Float3 v;
+        state_.linearVelocity.StoreFloat3(&v);
+        out.put(v);
+        state_.angularVelocity.StoreFloat3(&v);
+        out.put(v);
+        const auto wheels = static_cast<uint8_t>(state_.wheelAngularVelocity.size());
+        out.put(wheels);
+        for (uint8_t w = 0; w < wheels; ++w) {
+            out.put(state_.wheelAngularVelocity[w]);
+            out.put(state_.wheelSteerAngle[w]);
+        }
+        out.put(state_.engineRpm);
+        out.put(static_cast<int32_t>(state_.gear));
+        out.put(state_.clutchFriction);
+        out.put(state_.trackAngularVelocity[0]);
+        out.put(state_.trackAngularVelocity[1]);
+
+        out.patch(sizeAt, static_cast<uint16_t>(out.size() - begin));
+    }
+
+    void writeProxy(FrameWriter& out, int target, uint32_t id, const PhysicsVehicle& vehicle) {
+        size_t sizeAt = 0;
+        writeHeader(out, RecordType::Proxy, target, sizeAt);
+        const size_t begin = out.size();
+        const BodyInterface& bodies = world_->system().GetBodyInterfaceNoLock();
+        RVec3 position;
+        Quat rotation;
+        bodies.GetPositionAndRotation(vehicle.bodyId(), position, rotation);
+        Vec3 linear, angular;
+        bodies.GetLinearAndAngularVelocity(vehicle.bodyId(), linear, angular);
+        writeBody(out, id, vehicle, position, rotation, linear, angular);
+        out.patch(sizeAt, static_cast<uint16_t>(out.size() - begin));
+    }
+
+    int index_;
+    int fd_;
+    ShardedSim::Config config_;
+    Cell owned_;
+    std::unique_ptr<PhysicsWorld> world_;
+    std::unique_ptr<VehicleRegistry> vehicles_;
+    // Global vehicle id by registry slot.
+    std::vector<uint32_t> ids_;
+    std::unordered_map<uint32_t, Proxy> proxies_;
+    std::vector<VehicleInput> inputs_;
+    std::vector<VehicleHandle> leaving_;
+    std::vector<uint8_t> frame_;
+    VehicleState state_;
+    uint32_t tick_ = 0;
+};
+
+#endif
+
+} // namespace
+
+ShardedSim::ShardedSim(const Config& config)
+    : config_(config) {}
+
+ShardedSim::~ShardedSim() {
+    shutdown();
+}
+
+int ShardedSim::shardAt(const Config& config, float x, float z) {
+    const float width = (config.maxX - config.minX) / static_cast<float>(config.columns);
+    const float depth = (config.maxZ - config.minZ) / static_cast<float>(config.rows);
+    const int column = std::clamp(static_cast<int>(std::floor((x - config.minX) / width)), 0, config.columns - 1);
+    const int row = std::clamp(static_cast<int>(std::floor((z - config.minZ) / depth)), 0, config.rows - 1);
+    return row * config.columns + column;
+}
+
+int ShardedSim::totalVehicles() const {
+    int total = 0;
+    for (const Shard& shard : shards_) {
+        total += shard.stats.vehicles;
+    }
+    return total;
+}
+
+void ShardedSim::resetMaxima() {
+    for (Shard& shard : shards_) {
+        shard.stats.maxStepMs = 0.f;
+    }
+}
+
+#ifdef _WIN32
+
+std::unique_ptr<ShardedSim> ShardedSim::launch(const Config&) {
+    std::fprintf(stderr, "error: sharded simulation needs fork() and is not available on this platform\n");
+    return nullptr;
+}
+
+bool ShardedSim::step() {
+    return false;
+}
+
+void ShardedSim::shutdown() {}
+
+#else
+
+std::unique_ptr<ShardedSim> ShardedSim::launch(const Config& requested) {
+    Config config = requested;
+    config.columns = std::max(config.columns, 1);
+    config.rows = std::max(config.rows, 1);
+    const int count = config.columns * config.rows;
+    const uint32_t cores = std::max(1u, std::thread::hardware_concurrency());
+    const uint32_t threads = config.threadsPerShard > 0 ? config.threadsPerShard : std::max(1u, cores / static_cast<uint32_t>(count));
+    // A child would inherit the runtime's mutexes and factory but none of its
+    // worker threads, and deadlock on the first step.
+    if (JoltRuntime::alive()) {
+        std::fprintf(stderr, "error: sharded simulation must be launched before any Jolt runtime exists\n");
+        return nullptr;
+    }
+
+    std::unique_ptr<ShardedSim> sim(new ShardedSim(config));
+    sim->shards_.resize(count);
+    // Buffered output would otherwise be written once per process.
+    std::fflush(stdout);
+    std::fflush(stderr);
+    for (int i = 0; i < count; ++i) {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+            std::fprintf(stderr, "error: socketpair failed: %s\n", std::strerror(errno));
+            return nullptr;
+        }
+        const pid_t pid = fork();
+        if (pid < 0) {
+            std::fprintf(stderr, "error: fork failed: %s\n", std::strerror(errno));
+            ::close(fds[0]);
+            ::close(fds[1]);
+            return nullptr;
+        }
+        if (pid == 0) {
+            ::close(fds[0]);
+            for (int j = 0; j < i; ++j) {
+                ::close(sim->shards_[j].fd);
+            }
+            JoltRuntime::setWorkerThreads(threads);
+            int code = 0;
+            {
+                ShardWorker worker(i, fds[1], config);
+                code = worker.run();
+            }
+            ::close(fds[1]);
+            // Never unwind into the coordinator's stack.
+            _exit(code);
+        }
+        ::close(fds[1]);
+        sim->shards_[i].pid = pid;
+        sim->shards_[i].fd = fds[0];
+        sim->shards_[i].stats.pid = pid;
+    }
+
+    for (Shard& shard : sim->shards_) {
+        if (!receiveFrame(shard.fd, sim->frame_)) return nullptr;
+        FrameReader in(sim->frame_.data(), sim->frame_.size());
+        if (in.get<FrameType>() != FrameType::Ready) return nullptr;
+        shard.stats.vehicles = static_cast<int>(in.get<uint32_t>());
+    }
+    return sim;
+}
+
+bool ShardedSim::step() {
+    if (failed_) return false;
+    const auto start = std::chrono::steady_clock::now();
+
+    // Every shard gets its step before any result is read, so they run concurrently.
+    for (Shard& shard : shards_) {
+        frame_.clear();
+        FrameWriter out(frame_);
+        out.put(FrameType::Step);
+        out.put(static_cast<uint32_t>(tick_));
+        out.put(shard.inboxRecords);
+        out.putBytes(shard.inbox.data(), shard.inbox.size());
+        shard.inbox.clear();
+        shard.inboxRecords = 0;
+        if (!sendFrame(shard.fd, frame_)) {
+            failed_ = true;
+            return false;
+        }
+        shard.stats.bytesOut += frame_.size();
+    }
+
+    const int count = shardCount();
+    for (Shard& shard : shards_) {
+        if (!receiveFrame(shard.fd, frame_)) {
+            failed_ = true;
+            return false;
+        }
+        shard.stats.bytesIn += frame_.size();
+        FrameReader in(frame_.data(), frame_.size());
+        if (in.get<FrameType>() != FrameType::StepDone) {
+            failed_ = true;
+            return false;
+        }
+        ShardStats& stats = shard.stats;
+        stats.lastStepMs = in.get<float>();
+        stats.maxStepMs = std::max(stats.maxStepMs, stats.lastStepMs);
+        stats.totalStepMs += stats.lastStepMs;
+        ++stats.steps;
+        stats.vehicles = static_cast<int>(in.get<uint32_t>());
+        stats.proxies = static_cast<int>(in.get<uint32_t>());
+        const auto records = in.get<uint32_t>();
+
+        // Forward each record to its target without decoding the payload.
+        for (uint32_t i = 0; i < records; ++i) {
+            const auto type = in.get<RecordType>();
+            const auto target = in.get<int32_t>();
+            const auto size = in.get<uint16_t>();
+            const uint8_t* payload = in.take(size);
+            if (!in.ok() || target < 0 || target >= count) {
+                failed_ = true;
+                return false;
+            }
+            Shard& to = shards_[target];
+            FrameWriter routed(to.inbox);
+            routed.put(type);
+            routed.put(size);
+            routed.putBytes(payload, size);
+            ++to.inboxRecords;
+            if (type == RecordType::Handoff) {
+                ++stats.handoffsOut;
+                ++to.stats.handoffsIn;
+            } else {
+                ++stats.proxiesSent;
+            }
+        }
+    }
+
+    ++tick_;
+    lastTickMs_ = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+void ShardedSim::shutdown() {
+    frame_.clear();
+    FrameWriter(frame_).put(FrameType::Shutdown);
+    for (Shard& shard : shards_) {
+        if (shard.fd >= 0) {
+            sendFrame(shard.fd, frame_);
+            ::close(shard.fd);
+            shard.fd = -1;
+        }
+    }
+    for (Shard& shard : shards_) {
+        if (shard.pid > 0) {
+            int status = 0;
+            waitpid(shard.pid, &status, 0);
+            shard.pid = -1;
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Spatially sharded simulation across local processes. The XZ plane is cut into
+// a grid of regions, and each region is simulated by its own PhysicsWorld in a
+// forked child process. The calling process is the coordinator: it advances all
+// shards in lock-step over socketpairs and routes messages between them.
+//
+// After every step a shard hands off the vehicles that left its region, with body
+// and drivetrain state, to the owning shard. Vehicles within `borderMargin` of a
+// neighbouring region are mirrored there as proxies so that vehicles collide
+// across borders. A proxy is a dynamic chassis with the vehicle's mass and the
+// sent velocity, so both sides of a cross-border contact get a mass-correct
+// response in their own shard; the proxy's response itself is thrown away when
+// the next state arrives. Proxies lag the real vehicle by one tick.
+//
+// Shards fork before any Jolt state exists in the coordinator, and launch()
+// fails while a JoltRuntime is alive; POSIX only.
+class ShardedSim {
+public:
+    struct Config {
+        int columns = 2;
+        int rows = 1;
+        // World area covered by the grid; positions outside clamp to the edge shards.
+        float minX = -300.f;
+        float minZ = -300.f;
+        float maxX = 300.f;
+        float maxZ = 300.f;
+        float borderMargin = 12.f;
+        // How far past its border a vehicle must be before it is handed off, so
+        // vehicles driving along a border do not bounce between shards.
+        float handoffHysteresis = 1.f;
+        // Spawned on the track ring inside each shard's region.
+        int vehiclesPerShard = 500;
+        float dt = 1.f / 60.f;
+        float targetSpeed = 20.f;
+        // Jolt worker threads per shard; 0 splits the cores evenly.
+        uint32_t threadsPerShard = 0;
+    };
+
+    struct ShardStats {
+        int pid = 0;
+        int vehicles = 0;
+        int proxies = 0;
+        float lastStepMs = 0.f;
+        float maxStepMs = 0.f;
+        double totalStepMs = 0.0;
+        uint64_t steps = 0;
+        uint64_t handoffsIn = 0;
+        uint64_t handoffsOut = 0;
+        uint64_t proxiesSent = 0;
+        uint64_t bytesIn = 0;
+        uint64_t bytesOut = 0;
+
+        double meanStepMs() const { return steps > 0 ? totalStepMs / static_cast<double>(steps) : 0.0; }
+    };
+
+    // Forks the shards and waits until each has spawned its vehicles. Returns
+    // null when processes cannot be created on this platform or a shard fails.
+    static std::unique_ptr<ShardedSim> launch(const Config& config);
+    // Shuts every shard down and reaps it.
+    ~ShardedSim();
+
+    ShardedSim(const ShardedSim&) = delete;
+    ShardedSim& operator=(const ShardedSim&) = delete;
+
+    // Advances every shard by one tick. Returns false once a shard has died.
+    bool step();
+
+    uint64_t tick() const { return tick_; }
+    int shardCount() const { return static_cast<int>(shards_.size()); }
+    const ShardStats& shardStats(int shard) const { return shards_[shard].stats; }
+    int totalVehicles() const;
+    // Wall time of the last step(), i.e. of the slowest shard plus routing.
+    float lastTickMs() const { return lastTickMs_; }
+    // Per-interval maxima are reset here, e.g. after printing a report.
+    void resetMaxima();
+    const Config& config() const { return config_; }
+
+    // Grid cell that owns the position.
+    static int shardAt(const Config& config, float x, float z);
+
+private:
+    struct Shard {
+        int pid = -1;
+        int fd = -1;
+        ShardStats stats;
+        // Records routed to this shard for its next step.
+        std::vector<uint8_t> inbox;
+        uint32_t inboxRecords = 0;
+    };
+
+    explicit ShardedSim(const Config& config);
+    void shutdown();
+
+    Config config_;
+    std::vector<Shard> shards_;
+    std::vector<uint8_t> frame_;
+    uint64_t tick_ = 0;
+    float lastTickMs_ = 0.f;
+    bool failed_ = false;
+};
@@ -0,0 +1,560 @@
+#include "AiDrivers.h"
+#include "FleetSpawner.h"
+#include "JoltRuntime.h"
+#include "LatencyHistogram.h"
+#include "TrackLayout.h"
+#include "VehicleRegistry.h"
+#include "VehicleTelemetry.h"
+
+#include <Jolt/Core/Memory.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#ifndef _WIN32
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+using namespace JPH;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    // Wall-clock run time; the simulation runs as fast as it can.
+    double seconds = 600.0;
+    // Wall seconds left out of the histograms and the growth fits.
+    double warmup = 30.0;
+    int vehicles = 200;
+    int maxVehicles = 400;
+    // Spawn or despawn events per simulated second, each of 1-8 vehicles.
+    float churnPerSecond = 4.f;
+    // Full world rebuild every this many simulated seconds; 0 never resets.
+    float resetEvery = 300.f;
+    // Share of vehicles driven by random inputs instead of the AI.
+    float randomShare = 0.25f;
+    float dt = 1.f / 60.f;
+    uint32_t seed = 1;
+    double sampleEvery = 10.0;
+    double reportEvery = 60.0;
+    std::string csv;
+
+    // Pass/fail limits; 0 disables a check. Times in ms, growth per hour.
+    double maxStepP99 = 16.7;
+    double maxStepP999 = 0.0;
+    double maxStepMax = 0.0;
+    double maxFrameP99 = 0.0;
+    double maxFrameP999 = 50.0;
+    double maxFrameMax = 0.0;
+    double maxResetMax = 0.0;
+    double maxRssGrowth = 64.0;
+    double maxHeapGrowth = 0.0;
+    double maxJoltGrowth = 0.0;
+};
+
+void printUsage() {
+    std::printf(
+        "Usage: VehicleSoakTest [options]\n"
+        "  --seconds S          wall-clock run time (default 600)\n"
+        "  --hours H            same, in hours\n"
+        "  --warmup S           wall seconds excluded from the statistics (default 30)\n"
+        "  --vehicles N         vehicles kept around on average (default 200)\n"
+        "  --max-vehicles N     upper bound while churning (default 400)\n"
+        "  --churn N            spawn/despawn events per simulated second (default 4)\n"
+        "  --reset-every S      simulated seconds between world rebuilds, 0 never (default 300)\n"
+        "  --random-share F     share of vehicles on random inputs (default 0.25)\n"
+        "  --seed N             scenario seed (default 1)\n"
+        "  --sample-every S     wall seconds between memory samples (default 10)\n"
+        "  --report-every S     wall seconds between progress lines (default 60)\n"
+        "  --csv FILE           memory and latency time series\n"
+        "Thresholds, 0 disables (times in ms, growth per hour after warm-up):\n"
+        "  --max-step-p99 (16.7) --max-step-p999 --max-step-max\n"
+        "  --max-frame-p99 --max-frame-p999 (50) --max-frame-max --max-reset-max\n"
+        "  --max-rss-growth MB (64) --max-heap-growth MB --max-jolt-growth allocations\n");
+}
+
+// Live Jolt allocations, counted by wrapping the allocator the runtime installed.
+std::atomic<int64_t> joltLive{0};
+std::atomic<uint64_t> joltTotal{0};
+
+#ifndef JPH_DISABLE_CUSTOM_ALLOCATOR
+AllocateFunction baseAllocate = nullptr;
+ReallocateFunction baseReallocate = nullptr;
+FreeFunction baseFree = nullptr;
+AlignedAllocateFunction baseAlignedAllocate = nullptr;
+AlignedFreeFunction baseAlignedFree = nullptr;
+
+void* countedAllocate(size_t size) {
+    void* block = baseAllocate(size);
+    if (block) {
+        joltLive.fetch_add(1, std::memory_order_relaxed);
+        joltTotal.fetch_add(1, std::memory_order_relaxed);
+    }
+    return block;
+}
+
+void* countedReallocate(void* block, size_t oldSize, size_t newSize) {
+    void* moved = baseReallocate(block, oldSize, newSize);
+    if (!block && moved) {
+        joltLive.fetch_add(1, std::memory_order_relaxed);
+        joltTotal.fetch_add(1, std::memory_order_relaxed);
+    }
+    return moved;
+}
+
+void countedFree(void* block) {
+    if (block) joltLive.fetch_sub(1, std::memory_order_relaxed);
+    baseFree(block);
+}
+
+void* countedAlignedAllocate(size_t size, size_t alignment) {
+    void* block = baseAlignedAllocate(size, alignment);
+    if (block) {
+        joltLive.fetch_add(1, std::memory_order_relaxed);
+        joltTotal.fetch_add(1, std::memory_order_relaxed);
+    }
+    return block;
+}
+
+void countedAlignedFree(void* block) {
+    if (block) joltLive.fetch_sub(1, std::memory_order_relaxed);
+    baseAlignedFree(block);
+}
+#endif
+
+// Must run after the runtime registered its allocator. Blocks allocated before
+// are freed through the wrappers too, so only the change in the count is meaningful.
+void countJoltAllocations() {
+#ifndef JPH_DISABLE_CUSTOM_ALLOCATOR
+    baseAllocate = JPH::Allocate;
+    baseReallocate = JPH::Reallocate;
+    baseFree = JPH::Free;
+    baseAlignedAllocate = JPH::AlignedAllocate;
+    baseAlignedFree = JPH::AlignedFree;
+    JPH::Allocate = countedAllocate;
+    JPH::Reallocate = countedReallocate;
+    JPH::Free = countedFree;
+    JPH::AlignedAllocate = countedAlignedAllocate;
+    JPH::AlignedFree = countedAlignedFree;
+#endif
+}
+
+double residentMb() {
+#ifdef __linux__
+    std::FILE* file = std::fopen("/proc/self/statm", "r");
+    if (!file) return 0.0;
+    unsigned long long pages = 0;
+    unsigned long long resident = 0;
+    const int read = std::fscanf(file, "%llu %llu", &pages, &resident);
+    std::fclose(file);
+    return read == 2 ? static_cast<double>(resident) * static_cast<double>(sysconf(_SC_PAGESIZE)) / (1024.0 * 1024.0) : 0.0;
+#else
+    return 0.0;
+#endif
+}
+
+double peakResidentMb() {
+#ifndef _WIN32
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0.0;
+#ifdef __APPLE__
+    return static_cast<double>(usage.ru_maxrss) / (1024.0 * 1024.0);
+#else
+    return static_cast<double>(usage.ru_maxrss) / 1024.0;
+#endif
+#else
+    return 0.0;
+#endif
+}
+
+// Bytes handed out by malloc, including large mmapped blocks; 0 where unknown.
+double heapInUseMb() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    const struct mallinfo2 info = mallinfo2();
+    return static_cast<double>(info.uordblks + info.hblkhd) / (1024.0 * 1024.0);
+#else
+    return 0.0;
+#endif
+}
+
+struct MemorySample {
+    double wall = 0.0;
+    double rssMb = 0.0;
+    double heapMb = 0.0;
+    int64_t joltLive = 0;
+};
+
+// Least-squares slope per hour of `value` over samples taken after the warm-up.
+template<typename F>
+double growthPerHour(const std::vector<MemorySample>& samples, double warmup, F&& value) {
+    double n = 0.0, sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+    for (const MemorySample& sample : samples) {
+        if (sample.wall < warmup) continue;
+        const double x = sample.wall / 3600.0;
+        const double y = value(sample);
+        n += 1.0;
+        sx += x;
+        sy += y;
+        sxx += x * x;
+        sxy += x * y;
+    }
+    const double denominator = n * sxx - sx * sx;
+    return n >= 2.0 && denominator > 0.0 ? (n * sxy - sx * sy) / denominator : 0.0;
+}
+
+double ms(uint64_t us) {
+    return static_cast<double>(us) / 1000.0;
+}
+
+uint64_t us(Clock::duration duration) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+}
+
+// One world with its vehicles, rebuilt from scratch on every reset like the demo's.
+struct Scenario {
+    std::unique_ptr<PhysicsWorld> world;
+    std::unique_ptr<VehicleRegistry> vehicles;
+    std::unique_ptr<AiDrivers> ai;
+    std::unique_ptr<FleetSpawner> fleet;
+    std::vector<VehiclePlacement> placements;
+    std::vector<VehicleHandle> handles;
+    uint64_t capacityErrors = 0;
+};
+
+void build(Scenario& scenario, const Options& options, uint32_t seed) {
+    PhysicsWorld::Config config;
+    config.maxBodies = static_cast<uint32_t>(options.maxVehicles) * 2 + 64;
+    config.maxBodyPairs = config.maxBodies * 4;
+    config.maxContactConstraints = config.maxBodies * 4;
+    config.tempAllocatorBytes = 32 * 1024 * 1024;
+    scenario.world = std::make_unique<PhysicsWorld>(config);
+    Track::createGroundBody(*scenario.world);
+    scenario.vehicles = std::make_unique<VehicleRegistry>(*scenario.world);
+    scenario.ai = std::make_unique<AiDrivers>(*scenario.world);
+    scenario.fleet = std::make_unique<FleetSpawner>(*scenario.world);
+    scenario.fleet->config().seed = seed;
+    scenario.fleet->plan(FleetSpawner::Region::track(), options.vehicles, scenario.placements);
+    scenario.vehicles->spawnBatch(scenario.placements, {}, scenario.handles);
+}
+
+void teardown(Scenario& scenario) {
+    if (scenario.world) scenario.capacityErrors += scenario.world->capacityStats().errorSteps();
+    scenario.vehicles.reset();
+    scenario.ai.reset();
+    scenario.fleet.reset();
+    scenario.world.reset();
+}
+
+struct LatencySet {
+    LatencyHistogram step;
+    LatencyHistogram frame;
+    LatencyHistogram reset;
+
+    void add(const LatencySet& other) {
+        step.add(other.step);
+        frame.add(other.frame);
+        reset.add(other.reset);
+    }
+    void clear() {
+        step.reset();
+        frame.reset();
+        reset.reset();
+    }
+};
+
+void printLatency(const char* name, const LatencyHistogram& histogram) {
+    std::printf("  %-6s %10llu %9.3f %9.3f %9.3f %9.3f %9.3f\n", name, static_cast<unsigned long long>(histogram.count()),
+                ms(histogram.valueAtPercentile(50.0)), ms(histogram.valueAtPercentile(99.0)),
+                ms(histogram.valueAtPercentile(99.9)), ms(histogram.max()), histogram.mean() / 1000.0);
+}
+
+struct Check {
+    const char* name;
+    double value;
+    double limit;
+    const char* unit;
+};
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    struct NumberFlag {
+        const char* name;
+        double* value;
+    };
+    double vehicles = options.vehicles;
+    double maxVehicles = options.maxVehicles;
+    double churn = options.churnPerSecond;
+    double resetEvery = options.resetEvery;
+    double randomShare = options.randomShare;
+    double seed = options.seed;
+    double hours = 0.0;
+    const NumberFlag flags[] = {
+        {"--seconds", &options.seconds},
+        {"--hours", &hours},
+        {"--warmup", &options.warmup},
+        {"--vehicles", &vehicles},
+        {"--max-vehicles", &maxVehicles},
+        {"--churn", &churn},
+        {"--reset-every", &resetEvery},
+        {"--random-share", &randomShare},
+        {"--seed", &seed},
+        {"--sample-every", &options.sampleEvery},
+        {"--report-every", &options.reportEvery},
+        {"--max-step-p99", &options.maxStepP99},
+        {"--max-step-p999", &options.maxStepP999},
+        {"--max-step-max", &options.maxStepMax},
+        {"--max-frame-p99", &options.maxFrameP99},
+        {"--max-frame-p999", &options.maxFrameP999},
+        {"--max-frame-max", &options.maxFrameMax},
+        {"--max-reset-max", &options.maxResetMax},
+        {"--max-rss-growth", &options.maxRssGrowth},
+        {"--max-heap-growth", &options.maxHeapGrowth},
+        {"--max-jolt-growth", &options.maxJoltGrowth},
+    };
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!value) return false;
+        ++i;
+        if (std::strcmp(arg, "--csv") == 0) {
+            options.csv = value;
+            continue;
+        }
+        auto flag = std::find_if(std::begin(flags), std::end(flags), [&](const NumberFlag& f) { return std::strcmp(arg, f.name) == 0; });
+        if (flag == std::end(flags)) return false;
+        *flag->value = std::strtod(value, nullptr);
+    }
+
+    if (hours > 0.0) options.seconds = hours * 3600.0;
+    options.vehicles = std::max(1, static_cast<int>(vehicles));
+    options.maxVehicles = std::max(options.vehicles, static_cast<int>(maxVehicles));
+    options.churnPerSecond = static_cast<float>(std::max(churn, 0.0));
+    options.resetEvery = static_cast<float>(std::max(resetEvery, 0.0));
+    options.randomShare = static_cast<float>(std::clamp(randomShare, 0.0, 1.0));
+    options.seed = static_cast<uint32_t>(seed);
+    options.sampleEvery = std::max(options.sampleEvery, 0.1);
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (argc > 1 && std::strcmp(argv[1], "--help") == 0) {
+        printUsage();
+        return 0;
+    }
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return 1;
+    }
+
+    auto runtime = JoltRuntime::acquire();
+    countJoltAllocations();
+
+    std::FILE* csv = nullptr;
+    if (!options.csv.empty()) {
+        csv = std::fopen(options.csv.c_str(), "w");
+        if (!csv) {
+            std::fprintf(stderr, "error: cannot write %s\n", options.csv.c_str());
+            return 1;
+        }
+        std::fprintf(csv, "wall_s,sim_s,vehicles,rss_mb,heap_mb,jolt_live,step_p99_ms,frame_p99_ms,frame_max_ms\n");
+    }
+
+    std::mt19937 rng(options.seed);
+    std::uniform_real_distribution<float> unit(0.f, 1.f);
+    Scenario scenario;
+    VehicleTelemetry telemetry;
+    std::vector<VehicleInput> inputs;
+    // Random inputs by registry slot; re-rolled about once per simulated second.
+    std::vector<VehicleInput> randomInputs;
+    std::vector<VehiclePlacement> placements;
+    std::vector<VehicleHandle> handles;
+
+    LatencySet total;
+    LatencySet interval;
+    // Wall time the current interval began; only intervals begun after the warm-up
+    // count towards the totals.
+    double intervalStart = 0.0;
+    std::vector<MemorySample> samples;
+    uint64_t frames = 0;
+    uint64_t spawned = 0;
+    uint64_t despawned = 0;
+    uint64_t resets = 0;
+    uint32_t tick = 0;
+    double simTime = 0.0;
+    float sinceReset = 0.f;
+    float churnDue = 0.f;
+    uint32_t spawnSeed = options.seed;
+
+    std::printf("Soak: %.0f s, %d-%d vehicles, churn %.1f/s, reset every %.0f sim s, %u worker threads\n", options.seconds,
+                options.vehicles, options.maxVehicles, options.churnPerSecond, options.resetEvery, runtime->workerThreads());
+    build(scenario, options, ++spawnSeed);
+
+    const auto runStart = Clock::now();
+    double nextSample = 0.0;
+    double nextReport = options.reportEvery;
+    for (;;) {
+        const auto frameStart = Clock::now();
+        const double wall = std::chrono::duration<double>(frameStart - runStart).count();
+        if (wall >= options.seconds) break;
+        if (intervalStart < options.warmup && wall >= options.warmup) {
+            interval.clear();
+            intervalStart = wall;
+        }
+
+        if (wall >= nextSample) {
+            nextSample += options.sampleEvery;
+            const MemorySample sample{wall, residentMb(), heapInUseMb(), joltLive.load(std::memory_order_relaxed)};
+            samples.push_back(sample);
+            if (csv) {
+                std::fprintf(csv, "%.1f,%.1f,%zu,%.2f,%.2f,%lld,%.3f,%.3f,%.3f\n", wall, simTime, scenario.vehicles->size(),
+                             sample.rssMb, sample.heapMb, static_cast<long long>(sample.joltLive),
+                             ms(interval.step.valueAtPercentile(99.0)), ms(interval.frame.valueAtPercentile(99.0)),
+                             ms(interval.frame.max()));
+                std::fflush(csv);
+            }
+            if (intervalStart >= options.warmup) total.add(interval);
+            interval.clear();
+            intervalStart = wall;
+        }
+        if (wall >= nextReport) {
+            nextReport += options.reportEvery;
+            std::printf("[%7.0f s] sim %.0f s, %zu vehicles, rss %.1f MB, heap %.1f MB, jolt live %lld, resets %llu\n", wall, simTime,
+                        scenario.vehicles->size(), samples.back().rssMb, samples.back().heapMb,
+                        static_cast<long long>(samples.back().joltLive), static_cast<unsigned long long>(resets));
+            std::fflush(stdout);
+        }
+
+        if (options.resetEvery > 0.f && sinceReset >= options.resetEvery) {
+            const auto resetStart = Clock::now();
+            teardown(scenario);
+            build(scenario, options, ++spawnSeed);
+            interval.reset.record(us(Clock::now() - resetStart));
+            sinceReset = 0.f;
+            ++resets;
+        }
+
+        VehicleRegistry& vehicles = *scenario.vehicles;
+        churnDue += options.churnPerSecond * options.dt;
+        while (churnDue >= 1.f) {
+            churnDue -= 1.f;
+            const int size = static_cast<int>(vehicles.size());
+            const int count = 1 + static_cast<int>(unit(rng) * 7.99f);
+            const bool spawn = size + count <= options.maxVehicles && (size <= options.vehicles / 2 || unit(rng) < 0.5f);
+            if (spawn) {
+                scenario.fleet->config().seed = ++spawnSeed;
+                scenario.fleet->plan(FleetSpawner::Region::track(), count, placements);
+                vehicles.spawnBatch(placements, {}, handles);
+                spawned += handles.size();
+            } else {
+                for (int i = 0; i < count && !vehicles.empty(); ++i) {
+                    const auto index = static_cast<size_t>(unit(rng) * static_cast<float>(vehicles.size())) % vehicles.size();
+                    vehicles.despawn(vehicles.handleAt(index));
+                    ++despawned;
+                }
+            }
+        }
+
+        inputs.assign(vehicles.size(), VehicleInput{});
+        scenario.ai->update(vehicles, inputs);
+        randomInputs.resize(vehicles.slotCount());
+        for (size_t i = 0; i < vehicles.size(); ++i) {
+            const uint32_t slot = vehicles.handleAt(i).index;
+            // Slots hash to a fixed driver kind, so a vehicle keeps its kind while alive.
+            if (static_cast<float>((slot * 2654435761u) >> 16 & 0xffff) >= options.randomShare * 65536.f) continue;
+            VehicleInput& input = randomInputs[slot];
+            if (unit(rng) < options.dt) {
+                input.throttle = unit(rng) * 2.f - 0.5f;
+                input.steer = unit(rng) * 2.f - 1.f;
+                input.brake = unit(rng) < 0.1f;
+                input.handbrake = unit(rng) < 0.05f;
+            }
+            inputs[i] = input;
+        }
+        vehicles.applyInputs(inputs);
+
+        const auto stepStart = Clock::now();
+        scenario.world->step(options.dt);
+        const auto stepEnd = Clock::now();
+        ++tick;
+        simTime += options.dt;
+        sinceReset += options.dt;
+        for (size_t i = 0; i < vehicles.size(); ++i) {
+            const VehicleHandle handle = vehicles.handleAt(i);
+            telemetry.record(tick, static_cast<float>(simTime), static_cast<uint16_t>(handle.index),
+                             static_cast<uint16_t>(handle.generation), vehicles[i]);
+        }
+
+        interval.step.record(us(stepEnd - stepStart));
+        interval.frame.record(us(Clock::now() - frameStart));
+        ++frames;
+    }
+    const double wall = std::chrono::duration<double>(Clock::now() - runStart).count();
+    samples.push_back({wall, residentMb(), heapInUseMb(), joltLive.load(std::memory_order_relaxed)});
+    if (intervalStart >= options.warmup) total.add(interval);
+    teardown(scenario);
+    if (csv) std::fclose(csv);
+
+    const double rssGrowth = growthPerHour(samples, options.warmup, [](const MemorySample& s) { return s.rssMb; });
+    const double heapGrowth = growthPerHour(samples, options.warmup, [](const MemorySample& s) { return s.heapMb; });
+    const double joltGrowth =
+        growthPerHour(samples, options.warmup, [](const MemorySample& s) { return static_cast<double>(s.joltLive); });
+
+    std::printf("\n%llu frames in %.0f s (%.0f simulated), %llu spawned, %llu despawned, %llu resets, %llu capacity error steps\n",
+                static_cast<unsigned long long>(frames), wall, simTime, static_cast<unsigned long long>(spawned),
+                static_cast<unsigned long long>(despawned), static_cast<unsigned long long>(resets),
+                static_cast<unsigned long long>(scenario.capacityErrors));
+    std::printf("  %-6s %10s %9s %9s %9s %9s %9s  (ms, after %.0f s warm-up)\n", "", "count", "p50", "p99", "p99.9", "max", "mean",
+                options.warmup);
+    printLatency("step", total.step);
+    printLatency("frame", total.frame);
+    printLatency("reset", total.reset);
+    std::printf("  rss    %.1f MB at start, %.1f MB at end, %.1f MB peak, %+.2f MB/h\n", samples.front().rssMb, samples.back().rssMb,
+                peakResidentMb(), rssGrowth);
+    std::printf("  heap   %.1f MB at start, %.1f MB at end, %+.2f MB/h\n", samples.front().heapMb, samples.back().heapMb, heapGrowth);
+    std::printf("  jolt   %lld live allocations at start, %lld at end, %+.0f/h, %llu total\n",
+                static_cast<long long>(samples.front().joltLive), static_cast<long long>(samples.back().joltLive), joltGrowth,
+                static_cast<unsigned long long>(joltTotal.load()));
+
+    const Check checks[] = {
+        {"step p99", ms(total.step.valueAtPercentile(99.0)), options.maxStepP99, "ms"},
+        {"step p99.9", ms(total.step.valueAtPercentile(99.9)), options.maxStepP999, "ms"},
+        {"step max", ms(total.step.max()), options.maxStepMax, "ms"},
+        {"frame p99", ms(total.frame.valueAtPercentile(99.0)), options.maxFrameP99, "ms"},
+        {"frame p99.9", ms(total.frame.valueAtPercentile(99.9)), options.maxFrameP999, "ms"},
+        {"frame max", ms(total.frame.max()), options.maxFrameMax, "ms"},
+        {"reset max", ms(total.reset.max()), options.maxResetMax, "ms"},
+        {"rss growth", rssGrowth, options.maxRssGrowth, "MB/h"},
+        {"heap growth", heapGrowth, options.maxHeapGrowth, "MB/h"},
+        {"jolt allocation growth", joltGrowth, options.maxJoltGrowth, "/h"},
+    };
+    int failures = 0;
+    std::printf("\n");
+    for (const Check& check : checks) {
+        if (check.limit <= 0.0) continue;
+        const bool pass = check.value <= check.limit;
+        failures += pass ? 0 : 1;
+        std::printf("%s %s %.3f %s (limit %.3f)\n", pass ? "PASS" : "FAIL", check.name, check.value, check.unit, check.limit);
+    }
+    if (total.step.count() == 0) {
+        std::printf("FAIL no frames after the warm-up\n");
+        ++failures;
+    }
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,237 @@
+#include "SpatialHash.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace JPH;
+
+SpatialHash::SpatialHash(float cellSize)
+    : cellSize_(cellSize), invCellSize_(1.f / cellSize) {}
+
+int SpatialHash::cellCoord(float v) const {
+    return static_cast<int>(std::floor(v * invCellSize_));
+}
+
+uint64_t SpatialHash::key(int cx, int cz) {
+    return (uint64_t(uint32_t(cx)) << 32) | uint32_t(cz);
+}
+
+void SpatialHash::update(Id id, const Vec3& position) {
+    if (id >= entries_.size()) {
+        entries_.resize(id + 1);
+    }
+    Entry& entry = entries_[id];
+    entry.x = position.GetX();
+    entry.z = position.GetZ();
+
+    const int cx = cellCoord(entry.x);
+    const int cz = cellCoord(entry.z);
+    const uint64_t cell = key(cx, cz);
+    if (entry.alive && entry.cell == cell) return;
+
+    if (entry.alive) {
+        removeFromCell(id);
+        ++cellChanges_;
+    } else {
+        entry.alive = true;
+        ++count_;
+    }
+    auto [it, inserted] = cells_.try_emplace(cell);
+    if (inserted && !spareCells_.empty()) {
+        it->second = std::move(spareCells_.back());
+        spareCells_.pop_back();
+    }
+    auto& ids = it->second;
+    entry.cell = cell;
+    entry.slot = static_cast<uint32_t>(ids.size());
+    ids.push_back(id);
+
+    if (minCellX_ > maxCellX_) {
+        minCellX_ = maxCellX_ = cx;
+        minCellZ_ = maxCellZ_ = cz;
+    } else {
+        minCellX_ = std::min(minCellX_, cx);
+        maxCellX_ = std::max(maxCellX_, cx);
+        minCellZ_ = std::min(minCellZ_, cz);
+        maxCellZ_ = std::max(maxCellZ_, cz);
+    }
+}
+
+void SpatialHash::remove(Id id) {
+    if (!contains(id)) return;
+    removeFromCell(id);
+    entries_[id].alive = false;
+    --count_;
+}
+
+void SpatialHash::removeFromCell(Id id) {
+    const Entry& entry = entries_[id];
+    const auto it = cells_.find(entry.cell);
+    auto& ids = it->second;
+    const Id last = ids.back();
+    ids[entry.slot] = last;
+    entries_[last].slot = entry.slot;
+    ids.pop_back();
+    // Empty cells leave the map so it only holds occupied ones, but their id
+    // lists are kept for the next cell that fills up.
+    if (ids.empty()) {
+        spareCells_.push_back(std::move(ids));
+        cells_.erase(it);
+    }
+}
+
+void SpatialHash::clear() {
+    for (auto& [cell, ids] : cells_) {
+        ids.clear();
+        spareCells_.push_back(std::move(ids));
+    }
+    cells_.clear();
+    entries_.clear();
+    count_ = 0;
+    cellChanges_ = 0;
+    minCellX_ = minCellZ_ = 0;
+    maxCellX_ = maxCellZ_ = -1;
+}
+
+size_t SpatialHash::consumeCellChanges() {
+    const size_t changes = cellChanges_;
+    cellChanges_ = 0;
+    return changes;
+}
+
+void SpatialHash::visitCell(int cx, int cz, float x, float z, float radiusSq, Id exclude, std::vector<Neighbor>& out) const {
+    const auto it = cells_.find(key(cx, cz));
+    if (it == cells_.end()) return;
+    for (Id id : it->second) {
+        const Entry& entry = entries_[id];
+        const float dx = entry.x - x;
+        const float dz = entry.z - z;
+        const float distanceSq = dx * dx + dz * dz;
+        if (distanceSq <= radiusSq && id != exclude) {
+            out.push_back({id, distanceSq});
+        }
+    }
+}
+
+void SpatialHash::queryRadius(const Vec3& center, float radius, std::vector<Neighbor>& out, Id exclude) const {
+    if (count_ == 0) return;
+    const float x = center.GetX();
+    const float z = center.GetZ();
+    const int x0 = std::max(cellCoord(x - radius), minCellX_);
+    const int x1 = std::min(cellCoord(x + radius), maxCellX_);
+    const int z0 = std::max(cellCoord(z - radius), minCellZ_);
+    const int z1 = std::min(cellCoord(z + radius), maxCellZ_);
+    const float radiusSq = radius * radius;
+    for (int cx = x0; cx <= x1; ++cx) {
+        for (int cz = z0; cz <= z1; ++cz) {
+            visitCell(cx, cz, x, z, radiusSq, exclude, out);
+        }
+    }
+}
+
+void SpatialHash::queryNearest(const Vec3& center, size_t k, std::vector<Neighbor>& out, Id exclude, float maxDistance) const {
+    out.clear();
+    if (k == 0 || count_ == 0) return;
+
+    const float x = center.GetX();
+    const float z = center.GetZ();
+    const int cx = cellCoord(x);
+    const int cz = cellCoord(z);
+    const float maxDistanceSq = maxDistance < std::sqrt(std::numeric_limits<float>::max()) ? maxDistance * maxDistance
+                                                                                           : std::numeric_limits<float>::max();
+    auto farther = [](const Neighbor& a, const Neighbor& b) { return a.distanceSq < b.distanceSq; };
+
+    // Visit square rings of cells outwards, keeping a max-heap of the k best.
+    // Once the k-th best is closer than anything outside the visited square can
+    // be, the search is done.
+    std::vector<Neighbor> ring;
+    for (int r = 0;; ++r) {
+        ring.clear();
+        for (int dx = -r; dx <= r; ++dx) {
+            const bool edge = dx == -r || dx == r;
+            for (int dz = -r; dz <= r; dz += edge ? 1 : 2 * r) {
+                visitCell(cx + dx, cz + dz, x, z, maxDistanceSq, exclude, ring);
+                if (r == 0) break;
+            }
+        }
+        for (const Neighbor& neighbor : ring) {
+            if (out.size() < k) {
+                out.push_back(neighbor);
+                std::push_heap(out.begin(), out.end(), farther);
+            } else if (neighbor.distanceSq < out.front().distanceSq) {
+                std::pop_heap(out.begin(), out.end(), farther);
+                out.back() = neighbor;
+                std::push_heap(out.begin(), out.end(), farther);
+            }
+        }
+
+        const float boundary = std::min({x - (cx - r) * cellSize_, (cx + r + 1) * cellSize_ - x,
+                                         z - (cz - r) * cellSize_, (cz + r + 1) * cellSize_ - z});
+        const float boundarySq = boundary * boundary;
+        if (out.size() == k && out.front().distanceSq <= boundarySq) break;
+        if (boundarySq > maxDistanceSq) break;
+        if (cx - r <= minCellX_ && cx + r >= maxCellX_ && cz - r <= minCellZ_ && cz + r >= maxCellZ_) break;
+    }
+    std::sort_heap(out.begin(), out.end(), farther);
+}
+
+template<typename Query>
+void SpatialHash::runBatch(JobSystem& jobSystem, size_t count, BatchResult& out, const Query& query) const {
+    // Every job fills its own buffer; the slices are stitched together afterwards
+    // in query order.
+    struct Slice {
+        size_t begin = 0;
+        size_t end = 0;
+        std::vector<uint32_t> counts;
+        std::vector<Neighbor> neighbors;
+    };
+    std::vector<Slice> slices;
+    for (size_t begin = 0; begin < count; begin += queriesPerJob_) {
+        slices.push_back({begin, std::min(count, begin + queriesPerJob_), {}, {}});
+    }
+
+    auto run = [&query](Slice& slice) {
+        std::vector<Neighbor> scratch;
+        slice.counts.reserve(slice.end - slice.begin);
+        for (size_t q = slice.begin; q < slice.end; ++q) {
+            scratch.clear();
+            query(q, scratch);
+            slice.counts.push_back(static_cast<uint32_t>(scratch.size()));
+            slice.neighbors.insert(slice.neighbors.end(), scratch.begin(), scratch.end());
+        }
+    };
+    if (slices.size() == 1) {
+        run(slices[0]);
+    } else if (!slices.empty()) {
+        JobSystem::Barrier* barrier = jobSystem.CreateBarrier();
+        for (Slice& slice : slices) {
+            barrier->AddJob(jobSystem.CreateJob("SpatialQuery", Color::sCyan, [&run, &slice] { run(slice); }));
+        }
+        jobSystem.WaitForJobs(barrier);
+        jobSystem.DestroyBarrier(barrier);
+    }
+
+    out.offsets.resize(count + 1);
+    out.offsets[0] = 0;
+    out.neighbors.clear();
+    for (const Slice& slice : slices) {
+        for (size_t i = 0; i < slice.counts.size(); ++i) {
+            out.offsets[slice.begin + i + 1] = out.offsets[slice.begin + i] + slice.counts[i];
+        }
+        out.neighbors.insert(out.neighbors.end(), slice.neighbors.begin(), slice.neighbors.end());
+    }
+}
+
+void SpatialHash::queryRadiusBatch(JobSystem& jobSystem, std::span<const Vec3> centers, float radius, BatchResult& out,
+                                   std::span<const Id> exclude) const {
+    runBatch(jobSystem, centers.size(), out, [&](size_t q, std::vector<Neighbor>& result) {
+        queryRadius(centers[q], radius, result, exclude.empty() ? InvalidId : exclude[q]);
+    });
+}
+
+void SpatialHash::queryNearestBatch(JobSystem& jobSystem, std::span<const Vec3> centers, size_t k, BatchResult& out,
+                                    std::span<const Id> exclude) const {
+    runBatch(jobSystem, centers.size(), out, [&](size_t q, std::vector<Neighbor>& result) {
+        queryNearest(centers[q], k, result, exclude.empty() ? InvalidId : exclude[q]);
+    });
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Core/JobSystem.h>
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+// Uniform grid over the ground plane (XZ) for neighbour queries between vehicles.
+// Objects are keyed by a small integer id (the registry slot) and updated in
+// place every step; only objects that cross a cell border touch the grid.
+class SpatialHash {
+public:
+    using Id = uint32_t;
+    static constexpr Id InvalidId = std::numeric_limits<Id>::max();
+
+    struct Neighbor {
+        Id id;
+        float distanceSq;
+    };
+
+    // Results of a batch query: neighbours of query q are
+    // neighbors[offsets[q]] .. neighbors[offsets[q + 1]].
+    struct BatchResult {
+        std::vector<uint32_t> offsets;
+        std::vector<Neighbor> neighbors;
+
+        size_t size() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+        std::span<const Neighbor> operator[](size_t query) const {
+            return {neighbors.data() + offsets[query], offsets[query + 1] - offsets[query]};
+        }
+    };
+
+    explicit SpatialHash(float cellSize = 16.f);
+
+    // Inserts the id or moves it to `position`.
+    void update(Id id, const JPH::Vec3& position);
+    void remove(Id id);
+    void clear();
+    bool contains(Id id) const { return id < entries_.size() && entries_[id].alive; }
+    size_t size() const { return count_; }
+    // Occupied cells.
+    size_t cellCount() const { return cells_.size(); }
+    float cellSize() const { return cellSize_; }
+    // Updates that moved an object to another cell since the last call.
+    size_t consumeCellChanges();
+
+    // Appends every object within `radius` of `center`, in no particular order.
+    void queryRadius(const JPH::Vec3& center, float radius, std::vector<Neighbor>& out, Id exclude = InvalidId) const;
+    // Replaces `out` with up to k nearest objects, closest first.
+    void queryNearest(const JPH::Vec3& center, size_t k, std::vector<Neighbor>& out, Id exclude = InvalidId,
+                      float maxDistance = std::numeric_limits<float>::max()) const;
+
+    // Batch variants split the queries into slices on the job system. exclude[q],
+    // when given, is left out of the results of query q.
+    void queryRadiusBatch(JPH::JobSystem& jobSystem, std::span<const JPH::Vec3> centers, float radius, BatchResult& out,
+                          std::span<const Id> exclude = {}) const;
+    void queryNearestBatch(JPH::JobSystem& jobSystem, std::span<const JPH::Vec3> centers, size_t k, BatchResult& out,
+                           std::span<const Id> exclude = {}) const;
+
+    void setQueriesPerJob(int queries) { queriesPerJob_ = queries < 16 ? 16 : queries; }
+
+private:
+    struct Entry {
+        float x = 0.f;
+        float z = 0.f;
+        uint64_t cell = 0;
+        // Position inside the cell's id list.
+        uint32_t slot = 0;
+        bool alive = false;
+    };
+
+    int cellCoord(float v) const;
+    static uint64_t key(int cx, int cz);
+    void removeFromCell(Id id);
+    void visitCell(int cx, int cz, float x, float z, float radiusSq, Id exclude, std::vector<Neighbor>& out) const;
+
+    template<typename Query>
+    void runBatch(JPH::JobSystem& jobSystem, size_t count, BatchResult& out, const Query& query) const;
+
+    float cellSize_;
+    float invCellSize_;
+    // Occupied cells only.
+    std::unordered_map<uint64_t, std::vector<Id>> cells_;
+    // Id lists of cells that emptied, reused when a new cell is occupied.
+    std::vector<std::vector<Id>> spareCells_;
+    std::vector<Entry> entries_;
+    size_t count_ = 0;
+    size_t cellChanges_ = 0;
+    int queriesPerJob_ = 64;
+    // Cell range that has ever been occupied; bounds the nearest-neighbour search.
+    int minCellX_ = 0, maxCellX_ = -1, minCellZ_ = 0, maxCellZ_ = -1;
+};
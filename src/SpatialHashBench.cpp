@@ -0,0 +1,178 @@
+#include "JoltRuntime.h"
+#include "SpatialHash.h"
+#include "TrackLayout.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace JPH;
+
+namespace {
+
+struct Options {
+    int vehicles = 10000;
+    size_t k = 8;
+    float radius = 25.f;
+    float cellSize = 16.f;
+    int repeats = 5;
+};
+
+void printUsage() {
+    std::printf(
+        "Usage: VehicleSpatialBench [options]\n"
+        "  --vehicles N   vehicles scattered over the track (default 10000)\n"
+        "  --k N          neighbours per nearest query (default 8)\n"
+        "  --radius M     radius query size in metres (default 25)\n"
+        "  --cell M       grid cell size in metres (default 16)\n"
+        "  --repeats N    timed repetitions, best is reported (default 5)\n");
+}
+
+template<typename F>
+double bestMs(int repeats, F&& f) {
+    double best = 1e30;
+    for (int i = 0; i < repeats; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        f();
+        best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (std::strcmp(arg, "--help") == 0) {
+            printUsage();
+            return 0;
+        }
+        if (!value) {
+            printUsage();
+            return 1;
+        }
+        if (std::strcmp(arg, "--vehicles") == 0) options.vehicles = std::max(2, std::atoi(value));
+        else if (std::strcmp(arg, "--k") == 0) options.k = static_cast<size_t>(std::max(1, std::atoi(value)));
+        else if (std::strcmp(arg, "--radius") == 0) options.radius = std::strtof(value, nullptr);
+        else if (std::strcmp(arg, "--cell") == 0) options.cellSize = std::strtof(value, nullptr);
+        else if (std::strcmp(arg, "--repeats") == 0) options.repeats = std::max(1, std::atoi(value));
+        else {
+            printUsage();
+            return 1;
+        }
+        ++i;
+    }
+
+    // Vehicles spread over the ring like a packed race, plus a small jitter per step.
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> angle(0.f, 2.f * JPH_PI);
+    std::uniform_real_distribution<float> lane(Track::Inner, Track::Outer);
+    std::uniform_real_distribution<float> jitter(-0.5f, 0.5f);
+    const size_t n = static_cast<size_t>(options.vehicles);
+    std::vector<Vec3> positions(n);
+    std::vector<SpatialHash::Id> ids(n);
+    for (size_t i = 0; i < n; ++i) {
+        const float a = angle(rng);
+        const float r = lane(rng);
+        positions[i] = Vec3(r * std::cos(a), 0.f, r * std::sin(a));
+        ids[i] = static_cast<SpatialHash::Id>(i);
+    }
+
+    auto runtime = JoltRuntime::acquire();
+    SpatialHash hash(options.cellSize);
+    const double buildMs = bestMs(1, [&] {
+        for (size_t i = 0; i < n; ++i) hash.update(ids[i], positions[i]);
+    });
+
+    std::vector<Vec3> moved = positions;
+    for (Vec3& p : moved) p += Vec3(jitter(rng), 0.f, jitter(rng));
+    const double updateMs = bestMs(1, [&] {
+        for (size_t i = 0; i < n; ++i) hash.update(ids[i], moved[i]);
+    });
+    const size_t cellChanges = hash.consumeCellChanges();
+    positions.swap(moved);
+
+    // Brute force: every vehicle against every other, with the grid's distance formula.
+    auto distanceSq = [&](size_t a, size_t b) {
+        const float dx = positions[a].GetX() - positions[b].GetX();
+        const float dz = positions[a].GetZ() - positions[b].GetZ();
+        return dx * dx + dz * dz;
+    };
+    const float radiusSq = options.radius * options.radius;
+    size_t bruteRadiusHits = 0;
+    const double bruteRadiusMs = bestMs(std::min(options.repeats, 2), [&] {
+        bruteRadiusHits = 0;
+        for (size_t q = 0; q < n; ++q) {
+            for (size_t i = 0; i < n; ++i) {
+                if (i != q && distanceSq(i, q) <= radiusSq) ++bruteRadiusHits;
+            }
+        }
+    });
+    std::vector<std::pair<float, uint32_t>> candidates;
+    std::vector<float> bruteKth(n);
+    const double bruteNearestMs = bestMs(std::min(options.repeats, 2), [&] {
+        for (size_t q = 0; q < n; ++q) {
+            candidates.clear();
+            for (size_t i = 0; i < n; ++i) {
+                if (i != q) candidates.emplace_back(distanceSq(i, q), static_cast<uint32_t>(i));
+            }
+            const size_t k = std::min(options.k, candidates.size());
+            std::nth_element(candidates.begin(), candidates.begin() + (k - 1), candidates.end());
+            bruteKth[q] = candidates[k - 1].first;
+        }
+    });
+
+    std::vector<SpatialHash::Neighbor> result;
+    size_t hashRadiusHits = 0;
+    const double radiusMs = bestMs(options.repeats, [&] {
+        hashRadiusHits = 0;
+        for (size_t q = 0; q < n; ++q) {
+            result.clear();
+            hash.queryRadius(positions[q], options.radius, result, ids[q]);
+            hashRadiusHits += result.size();
+        }
+    });
+    size_t nearestMismatches = 0;
+    const double nearestMs = bestMs(options.repeats, [&] {
+        nearestMismatches = 0;
+        for (size_t q = 0; q < n; ++q) {
+            hash.queryNearest(positions[q], options.k, result, ids[q]);
+            if (result.empty() || result.back().distanceSq != bruteKth[q]) ++nearestMismatches;
+        }
+    });
+
+    JobSystem& jobSystem = runtime->jobSystem();
+    SpatialHash::BatchResult batch;
+    const double radiusBatchMs = bestMs(options.repeats, [&] {
+        hash.queryRadiusBatch(jobSystem, positions, options.radius, batch, ids);
+    });
+    const size_t batchRadiusHits = batch.neighbors.size();
+    const double nearestBatchMs = bestMs(options.repeats, [&] {
+        hash.queryNearestBatch(jobSystem, positions, options.k, batch, ids);
+    });
+
+    std::printf("%zu vehicles, %zu cells of %.0f m, %u worker threads\n", n, hash.cellCount(), options.cellSize,
+                runtime->workerThreads());
+    std::printf("  build            %9.3f ms\n", buildMs);
+    std::printf("  update (jitter)  %9.3f ms, %zu cell changes\n", updateMs, cellChanges);
+    std::printf("  radius %.0f m     brute %9.3f ms | grid %9.3f ms | batch %9.3f ms | %.1f hits/query\n", options.radius,
+                bruteRadiusMs, radiusMs, radiusBatchMs, double(hashRadiusHits) / n);
+    std::printf("  nearest k=%-3zu   brute %9.3f ms | grid %9.3f ms | batch %9.3f ms\n", options.k, bruteNearestMs,
+                nearestMs, nearestBatchMs);
+
+    const bool ok = bruteRadiusHits == hashRadiusHits && batchRadiusHits == hashRadiusHits && nearestMismatches == 0;
+    if (!ok) {
+        std::fprintf(stderr, "mismatch: radius brute %zu grid %zu batch %zu, nearest mismatches %zu\n", bruteRadiusHits,
+                     hashRadiusHits, batchRadiusHits, nearestMismatches);
+        return 1;
+    }
+    return 0;
+}
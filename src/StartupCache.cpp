@@ -0,0 +1,474 @@
+#include "StartupCache.h"
+#include "PhysicsVehicle.h"
+#include "VehicleArchetypes.h"
+
+#include <Jolt/Jolt.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <type_traits>
+
+#ifdef _WIN32
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace threepp;
+
+namespace {
+
+constexpr char Magic[8] = {'V', 'D', 'C', 'A', 'C', 'H', 'E', '\0'};
+constexpr uint32_t JoltVersion = (JPH_VERSION_MAJOR << 16) | (JPH_VERSION_MINOR << 8) | JPH_VERSION_PATCH;
+constexpr size_t BlobAlignment = 16;
+
+#ifdef JPH_DOUBLE_PRECISION
+constexpr uint32_t JoltConfig = 1;
+#else
+constexpr uint32_t JoltConfig = 0;
+#endif
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t joltVersion;
+    uint32_t joltConfig;
+    uint32_t entryCount;
+    uint64_t contentHash;
+};
+
+struct Entry {
+    char name[48];
+    uint64_t offset;
+    uint64_t size;
+    uint32_t revision;
+    uint32_t reserved;
+};
+
+// FNV-1a, 64-bit.
+uint64_t hashBytes(uint64_t hash, const void* data, size_t size) {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+std::mutex activeMutex;
+std::shared_ptr<const StartupCache> activeCache;
+
+enum MeshFlags : uint8_t {
+    CastShadow = 1,
+    ReceiveShadow = 2,
+    DoubleSided = 4,
+    HasUv = 8
+};
+
+enum class MaterialKind : uint8_t {
+    Phong,
+    Lambert
+};
+
+struct MeshRecord {
+    int32_t tag;
+    MaterialKind material;
+    uint8_t flags;
+    uint16_t reserved;
+    float position[3];
+    float quaternion[4];
+    float scale[3];
+    float color[3];
+    uint32_t vertexCount;
+    uint32_t indexCount;
+};
+
+template<typename T>
+void append(std::vector<uint8_t>& out, const T* data, size_t count) {
+    const auto* bytes = reinterpret_cast<const uint8_t*>(data);
+    out.insert(out.end(), bytes, bytes + count * sizeof(T));
+}
+
+// Bounds-checked cursor; a failed read leaves the reader failed for good.
+struct Reader {
+    std::span<const uint8_t> data;
+    size_t cursor = 0;
+    bool failed = false;
+
+    template<typename T>
+    bool read(T* out, size_t count) {
+        const size_t bytes = count * sizeof(T);
+        if (failed || data.size() - cursor < bytes) {
+            failed = true;
+            return false;
+        }
+        std::memcpy(out, data.data() + cursor, bytes);
+        cursor += bytes;
+        return true;
+    }
+};
+
+} // namespace
+
+void StartupCache::Builder::add(std::string name, std::vector<uint8_t> data, uint32_t revision) {
+    entries_.push_back({std::move(name), std::move(data), revision});
+}
+
+uint64_t StartupCache::contentHash() {
+    static_assert(std::is_trivially_copyable_v<VehicleArchetypeParams>);
+    uint64_t hash = 0xcbf29ce484222325ull;
+    hash = hashBytes(hash, vehicleArchetypes.data(), sizeof(vehicleArchetypes));
+    const uint32_t revisions[] = {VehicleFactory::ModelRevision, PhysicsVehicle::BlueprintRevision};
+    return hashBytes(hash, revisions, sizeof(revisions));
+}
+
+bool StartupCache::Builder::write(const std::string& path) const {
+    Header header{};
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.joltVersion = JoltVersion;
+    header.joltConfig = JoltConfig;
+    header.entryCount = static_cast<uint32_t>(entries_.size());
+    header.contentHash = contentHash();
+
+    std::vector<Entry> table(entries_.size());
+    uint64_t offset = sizeof(Header) + table.size() * sizeof(Entry);
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        const Blob& blob = entries_[i];
+        if (blob.name.size() >= sizeof(Entry::name)) return false;
+        offset = (offset + BlobAlignment - 1) & ~uint64_t(BlobAlignment - 1);
+        std::memcpy(table[i].name, blob.name.c_str(), blob.name.size() + 1);
+        table[i].offset = offset;
+        table[i].size = blob.data.size();
+        table[i].revision = blob.revision;
+        offset += blob.data.size();
+    }
+
+    std::vector<uint8_t> file;
+    file.reserve(offset);
+    append(file, &header, 1);
+    append(file, table.data(), table.size());
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        file.resize(table[i].offset, 0);
+        append(file, entries_[i].data.data(), entries_[i].data.size());
+    }
+
+    // Write next to the target and rename, so concurrent runs never map a
+    // half-written cache.
+    const std::string tmp = path + ".tmp" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        out.write(reinterpret_cast<const char*>(file.data()), static_cast<std::streamsize>(file.size()));
+        if (!out) {
+            out.close();
+            std::remove(tmp.c_str());
+            return false;
+        }
+    }
+#ifdef _WIN32
+    std::remove(path.c_str());
+#endif
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+StartupCache::~StartupCache() {
+#ifndef _WIN32
+    if (mapped_) {
+        munmap(const_cast<uint8_t*>(data_), size_);
+    }
+#endif
+}
+
+std::unique_ptr<StartupCache> StartupCache::open(const std::string& path) {
+    std::unique_ptr<StartupCache> cache(new StartupCache());
+
+#ifdef _WIN32
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return nullptr;
+    cache->fallback_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    cache->data_ = cache->fallback_.data();
+    cache->size_ = cache->fallback_.size();
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return nullptr;
+    struct stat info {};
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(Header))) {
+        ::close(fd);
+        return nullptr;
+    }
+    void* mapping = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) return nullptr;
+    cache->data_ = static_cast<const uint8_t*>(mapping);
+    cache->size_ = static_cast<size_t>(info.st_size);
+    cache->mapped_ = true;
+#endif
+
+    if (cache->size_ < sizeof(Header)) return nullptr;
+    Header header;
+    std::memcpy(&header, cache->data_, sizeof(Header));
+    if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 || header.version != Version ||
+        header.joltVersion != JoltVersion || header.joltConfig != JoltConfig || header.contentHash != contentHash()) {
+        return nullptr;
+    }
+
+    // Reject truncated files up front so find() can trust the table.
+    const uint64_t tableEnd = sizeof(Header) + uint64_t(header.entryCount) * sizeof(Entry);
+    if (tableEnd > cache->size_) return nullptr;
+    const auto* table = reinterpret_cast<const Entry*>(cache->data_ + sizeof(Header));
+    for (uint32_t i = 0; i < header.entryCount; ++i) {
+        if (table[i].offset > cache->size_ || table[i].size > cache->size_ - table[i].offset) return nullptr;
+    }
+    return cache;
+}
+
+std::shared_ptr<const StartupCache> StartupCache::openOrBake(const std::string& path,
+                                                             const std::function<void(Builder&)>& bakeExtra) {
+    if (auto cache = open(path)) return cache;
+    return bake(path, bakeExtra);
+}
+
+std::shared_ptr<const StartupCache> StartupCache::bake(const std::string& path, const std::function<void(Builder&)>& bakeExtra) {
+    Builder builder;
+    bakeVehicleAssets(builder);
+    if (bakeExtra) bakeExtra(builder);
+    if (!builder.write(path)) {
+        std::fprintf(stderr, "warning: cannot write startup cache %s\n", path.c_str());
+        return nullptr;
+    }
+    return open(path);
+}
+
+std::span<const uint8_t> StartupCache::find(std::string_view name, uint32_t revision) const {
+    Header header;
+    std::memcpy(&header, data_, sizeof(Header));
+    const auto* table = reinterpret_cast<const Entry*>(data_ + sizeof(Header));
+    for (uint32_t i = 0; i < header.entryCount; ++i) {
+        if (name == std::string_view(table[i].name, strnlen(table[i].name, sizeof(Entry::name)))) {
+            if (table[i].revision != revision) return {};
+            return {data_ + table[i].offset, static_cast<size_t>(table[i].size)};
+        }
+    }
+    return {};
+}
+
+void StartupCache::setActive(std::shared_ptr<const StartupCache> cache) {
+    std::lock_guard lock(activeMutex);
+    activeCache = std::move(cache);
+}
+
+std::shared_ptr<const StartupCache> StartupCache::active() {
+    std::lock_guard lock(activeMutex);
+    return activeCache;
+}
+
+std::string vehicleModelKey(VehicleType type) {
+    return "vehicle/" + std::to_string(static_cast<int>(type)) + "/model";
+}
+
+std::string vehicleBlueprintKey(VehicleType type) {
+    return "vehicle/" + std::to_string(static_cast<int>(type)) + "/physics";
+}
+
+void bakeVehicleAssets(StartupCache::Builder& builder) {
+    for (const VehicleArchetypeParams& params : vehicleArchetypes) {
+        const VehicleModel model = VehicleFactory::createProcedural(params.type);
+
+        // Wheels keep their index into model.wheels, steering ones get bit 8 set.
+        builder.add(vehicleModelKey(params.type), encodeMeshes(*model.detail, [&](const Mesh& mesh) {
+            for (size_t i = 0; i < model.wheels.size(); ++i) {
+                if (model.wheels[i].get() != &mesh) continue;
+                bool steering = false;
+                for (const auto& wheel : model.steeringWheels) steering |= wheel.get() == &mesh;
+                return static_cast<int32_t>(i) | (steering ? 0x100 : 0);
+            }
+            return int32_t(-1);
+        }), VehicleFactory::ModelRevision);
+
+        const VehicleBlueprint blueprint =
+                PhysicsVehicle::buildBlueprint(params.type, model, PhysicsVehicle::defaultSettings(params.type));
+        builder.add(vehicleBlueprintKey(params.type), PhysicsVehicle::saveBlueprint(blueprint), PhysicsVehicle::BlueprintRevision);
+    }
+}
+
+std::vector<uint8_t> encodeMeshes(const Object3D& root, const std::function<int32_t(const Mesh&)>& tagOf) {
+    std::vector<uint8_t> out;
+    uint32_t count = 0;
+    append(out, &count, 1);
+
+    for (auto* child : root.children) {
+        // The format has no hierarchy and only knows two materials, so anything
+        // else would silently go missing from the cached copy. Refuse instead, and
+        // let the caller build the object procedurally.
+        auto* mesh = dynamic_cast<Mesh*>(child);
+        const char* unsupported = nullptr;
+        if (!mesh) {
+            unsupported = "a child that is not a mesh";
+        } else if (!mesh->children.empty()) {
+            unsupported = "a mesh with children";
+        } else if (!dynamic_cast<MeshPhongMaterial*>(mesh->material().get()) &&
+                   !dynamic_cast<MeshLambertMaterial*>(mesh->material().get())) {
+            unsupported = "a material other than Phong or Lambert";
+        } else if (!mesh->geometry()->hasAttribute("position") || !mesh->geometry()->hasAttribute("normal")) {
+            unsupported = "a mesh without positions or normals";
+        }
+        if (unsupported) {
+            std::fprintf(stderr, "warning: not caching '%s': it contains %s\n", root.name.c_str(), unsupported);
+            return {};
+        }
+
+        const auto geometry = mesh->geometry();
+        const auto* positions = geometry->getAttribute<float>("position");
+        const auto* normals = geometry->getAttribute<float>("normal");
+        const auto* uvs = geometry->hasAttribute("uv") ? geometry->getAttribute<float>("uv") : nullptr;
+        const auto* index = geometry->getIndex();
+
+        MeshRecord record{};
+        record.tag = tagOf ? tagOf(*mesh) : -1;
+        auto* material = mesh->material().get();
+        record.material = dynamic_cast<MeshLambertMaterial*>(material) ? MaterialKind::Lambert : MaterialKind::Phong;
+        record.flags = (mesh->castShadow ? CastShadow : 0) | (mesh->receiveShadow ? ReceiveShadow : 0) |
+                       (material->side == Side::Double ? DoubleSided : 0) | (uvs ? HasUv : 0);
+        const float position[3] = {mesh->position.x, mesh->position.y, mesh->position.z};
+        const float quaternion[4] = {mesh->quaternion.x, mesh->quaternion.y, mesh->quaternion.z, mesh->quaternion.w};
+        const float scale[3] = {mesh->scale.x, mesh->scale.y, mesh->scale.z};
+        std::memcpy(record.position, position, sizeof(position));
+        std::memcpy(record.quaternion, quaternion, sizeof(quaternion));
+        std::memcpy(record.scale, scale, sizeof(scale));
+        Color color = Color::gray;
+        if (auto* withColor = dynamic_cast<MaterialWithColor*>(material)) {
+            color = withColor->color;
+        }
+        record.color[0] = color.r;
+        record.color[1] = color.g;
+        record.color[2] = color.b;
+        record.vertexCount = static_cast<uint32_t>(positions->array().size() / 3);
+        record.indexCount = index ? static_cast<uint32_t>(index->array().size()) : 0;
+
+        append(out, &record, 1);
+        append(out, positions->array().data(), positions->array().size());
+        append(out, normals->array().data(), normals->array().size());
+        if (uvs) append(out, uvs->array().data(), uvs->array().size());
+        if (index) {
+            std::vector<uint32_t> indices(index->array().begin(), index->array().end());
+            append(out, indices.data(), indices.size());
+        }
+        ++count;
+    }
+
+    std::memcpy(out.data(), &count, sizeof(count));
+    return out;
+}
+
+bool decodeMeshBuffers(std::span<const uint8_t> data, std::vector<MeshBuffers>& meshes) {
+    meshes.clear();
+    Reader reader{data};
+    uint32_t count = 0;
+    // A corrupt count must not turn into a huge allocation.
+    if (!reader.read(&count, 1) || count > data.size() / sizeof(MeshRecord)) return false;
+
+    meshes.resize(count);
+    for (MeshBuffers& mesh : meshes) {
+        MeshRecord record;
+        if (!reader.read(&record, 1)) break;
+        mesh.tag = record.tag;
+        mesh.lambert = record.material == MaterialKind::Lambert;
+        mesh.castShadow = record.flags & CastShadow;
+        mesh.receiveShadow = record.flags & ReceiveShadow;
+        mesh.doubleSided = record.flags & DoubleSided;
+        std::memcpy(mesh.position, record.position, sizeof(mesh.position));
+        std::memcpy(mesh.quaternion, record.quaternion, sizeof(mesh.quaternion));
+        std::memcpy(mesh.scale, record.scale, sizeof(mesh.scale));
+        std::memcpy(mesh.color, record.color, sizeof(mesh.color));
+        mesh.positions.resize(size_t(record.vertexCount) * 3);
+        mesh.normals.resize(size_t(record.vertexCount) * 3);
+        mesh.uvs.resize((record.flags & HasUv) ? size_t(record.vertexCount) * 2 : 0);
+        mesh.indices.resize(record.indexCount);
+        reader.read(mesh.positions.data(), mesh.positions.size());
+        reader.read(mesh.normals.data(), mesh.normals.size());
+        reader.read(mesh.uvs.data(), mesh.uvs.size());
+        reader.read(mesh.indices.data(), mesh.indices.size());
+        if (reader.failed) break;
+    }
+    // Leave nothing half decoded behind for callers that fall back on failure.
+    if (reader.failed) meshes.clear();
+    return !reader.failed;
+}
+
+SharedMeshes::SharedMeshes(std::span<const MeshBuffers> meshes) {
+    // Procedural scenes share one material between many meshes; keep doing so.
+    std::map<std::tuple<bool, bool, float, float, float>, std::shared_ptr<Material>> materials;
+    parts_.reserve(meshes.size());
+
+    for (const MeshBuffers& buffers : meshes) {
+        auto geometry = BufferGeometry::create();
+        geometry->setAttribute("position", FloatBufferAttribute::create(buffers.positions, 3));
+        geometry->setAttribute("normal", FloatBufferAttribute::create(buffers.normals, 3));
+        if (!buffers.uvs.empty()) geometry->setAttribute("uv", FloatBufferAttribute::create(buffers.uvs, 2));
+        if (!buffers.indices.empty()) geometry->setIndex(buffers.indices);
+
+        auto& material = materials[{buffers.lambert, buffers.doubleSided, buffers.color[0], buffers.color[1], buffers.color[2]}];
+        if (!material) {
+            const Color color(buffers.color[0], buffers.color[1], buffers.color[2]);
+            if (buffers.lambert) {
+                auto lambert = MeshLambertMaterial::create();
+                lambert->color = color;
+                material = lambert;
+            } else {
+                auto phong = MeshPhongMaterial::create();
+                phong->color = color;
+                material = phong;
+            }
+            if (buffers.doubleSided) material->side = Side::Double;
+        }
+
+        Part& part = parts_.emplace_back();
+        part.geometry = std::move(geometry);
+        part.material = material;
+        part.position.set(buffers.position[0], buffers.position[1], buffers.position[2]);
+        part.quaternion.set(buffers.quaternion[0], buffers.quaternion[1], buffers.quaternion[2], buffers.quaternion[3]);
+        part.scale.set(buffers.scale[0], buffers.scale[1], buffers.scale[2]);
+        part.castShadow = buffers.castShadow;
+        part.receiveShadow = buffers.receiveShadow;
+        part.tag = buffers.tag;
+    }
+}
+
+std::shared_ptr<Group> SharedMeshes::instantiate(const MeshCallback& onMesh) const {
+    auto group = Group::create();
+    for (const Part& part : parts_) {
+        auto mesh = Mesh::create(part.geometry, part.material);
+        mesh->position.copy(part.position);
+        mesh->quaternion.copy(part.quaternion);
+        mesh->scale.copy(part.scale);
+        mesh->castShadow = part.castShadow;
+        mesh->receiveShadow = part.receiveShadow;
+        group->add(mesh);
+        if (onMesh) onMesh(mesh, part.tag);
+    }
+    return group;
+}
+
+std::shared_ptr<Group> buildMeshes(std::span<const MeshBuffers> meshes,
+                                   const std::function<void(const std::shared_ptr<Mesh>&, int32_t)>& onMesh) {
+    return SharedMeshes(meshes).instantiate(onMesh);
+}
+
+std::shared_ptr<Group> decodeMeshes(std::span<const uint8_t> data,
+                                    const std::function<void(const std::shared_ptr<Mesh>&, int32_t)>& onMesh) {
+    std::vector<MeshBuffers> meshes;
+    if (!decodeMeshBuffers(data, meshes)) return nullptr;
+    return buildMeshes(meshes, onMesh);
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "MeshBuffers.h"
+#include "VehicleFactory.h"
+#include "threepp/threepp.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Versioned, memory-mapped blob store for assets that are otherwise rebuilt
+// procedurally on every launch and reset: Jolt shapes and vehicle constraint
+// settings (Jolt binary state) and flattened mesh buffers of the scene.
+//
+// Layout: Header, Entry[entryCount], then 16-byte aligned blobs. Bump Version
+// when the layout changes. The header also holds contentHash(), so retuning the
+// archetype table or a vehicle builder invalidates the file; every entry carries
+// the revision of the builder that produced it, checked again by find().
+class StartupCache {
+public:
+    static constexpr uint32_t Version = 2;
+
+    class Builder {
+    public:
+        void add(std::string name, std::vector<uint8_t> data, uint32_t revision = 0);
+        bool write(const std::string& path) const;
+
+    private:
+        struct Blob {
+            std::string name;
+            std::vector<uint8_t> data;
+            uint32_t revision = 0;
+        };
+        std::vector<Blob> entries_;
+    };
+
+    ~StartupCache();
+
+    StartupCache(const StartupCache&) = delete;
+    StartupCache& operator=(const StartupCache&) = delete;
+
+    // File the simulation bakes and the viewer decodes from.
+    static constexpr const char* DefaultPath = "startup.cache";
+
+    // Maps `path`; returns null when it is missing, truncated, from another
+    // cache or Jolt version, or baked from different archetypes or builders.
+    static std::unique_ptr<StartupCache> open(const std::string& path);
+    // Opens `path`, or bakes the vehicle assets plus whatever `bakeExtra` adds,
+    // writes the file and opens that.
+    static std::shared_ptr<const StartupCache> openOrBake(const std::string& path,
+                                                          const std::function<void(Builder&)>& bakeExtra = {});
+    // Bakes and writes `path` unconditionally, e.g. when an extra entry is stale.
+    static std::shared_ptr<const StartupCache> bake(const std::string& path, const std::function<void(Builder&)>& bakeExtra = {});
+
+    // Empty span when the entry does not exist or was baked by another builder
+    // revision. Valid while the cache lives.
+    std::span<const uint8_t> find(std::string_view name, uint32_t revision = 0) const;
+    // Hash of the vehicleArchetypes table bytes and the vehicle model and
+    // blueprint builder revisions.
+    static uint64_t contentHash();
+    size_t size() const { return size_; }
+
+    // Cache consulted by VehicleFactory, PhysicsVehicle and scene setup. Null
+    // means everything is built procedurally.
+    static void setActive(std::shared_ptr<const StartupCache> cache);
+    static std::shared_ptr<const StartupCache> active();
+
+private:
+    StartupCache() = default;
+
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    bool mapped_ = false;
+    std::vector<uint8_t> fallback_;
+};
+
+// Adds the per-type vehicle models, chassis shapes and constraint settings.
+void bakeVehicleAssets(StartupCache::Builder& builder);
+std::string vehicleModelKey(VehicleType type);
+std::string vehicleBlueprintKey(VehicleType type);
+
+// Mesh lists are stored flattened: one record per direct child mesh of `root`
+// with its local transform, material colour and shadow flags plus position,
+// normal, uv and index buffers. `tagOf` lets callers keep extra per-mesh data,
+// e.g. which wheel a mesh is. Returns nothing, with a warning on stderr, when
+// `root` holds anything else: non-mesh children, nested meshes or materials other
+// than Phong and Lambert.
+std::vector<uint8_t> encodeMeshes(const threepp::Object3D& root, const std::function<int32_t(const threepp::Mesh&)>& tagOf = {});
+// Parses an encoded mesh list into plain buffers without touching threepp, so it
+// may run on worker threads. False when the data is truncated.
+bool decodeMeshBuffers(std::span<const uint8_t> data, std::vector<MeshBuffers>& meshes);
+// Geometry and materials created once from decoded buffers. instantiate() only
+// creates meshes and their group, so every copy shares the same GPU buffers.
+// threepp objects draw ids from shared counters, so use it on the main thread.
+class SharedMeshes {
+public:
+    using MeshCallback = std::function<void(const std::shared_ptr<threepp::Mesh>&, int32_t)>;
+
+    SharedMeshes() = default;
+    explicit SharedMeshes(std::span<const MeshBuffers> meshes);
+
+    bool empty() const { return parts_.empty(); }
+    // A new group of meshes; `onMesh` receives every mesh and its tag.
+    std::shared_ptr<threepp::Group> instantiate(const MeshCallback& onMesh = {}) const;
+
+private:
+    struct Part {
+        std::shared_ptr<threepp::BufferGeometry> geometry;
+        std::shared_ptr<threepp::Material> material;
+        threepp::Vector3 position;
+        threepp::Quaternion quaternion;
+        threepp::Vector3 scale;
+        bool castShadow = false;
+        bool receiveShadow = false;
+        int32_t tag = -1;
+    };
+
+    std::vector<Part> parts_;
+};
+
+// Creates the meshes under a new group; `onMesh` receives every mesh and its tag.
+// threepp objects draw ids from shared counters, so call this on the main thread.
+std::shared_ptr<threepp::Group> buildMeshes(std::span<const MeshBuffers> meshes,
+                                            const std::function<void(const std::shared_ptr<threepp::Mesh>&, int32_t)>& onMesh = {});
+// decodeMeshBuffers followed by buildMeshes; main thread only.
+std::shared_ptr<threepp::Group> decodeMeshes(std::span<const uint8_t> data,
+                                             const std::function<void(const std::shared_ptr<threepp::Mesh>&, int32_t)>& onMesh = {});
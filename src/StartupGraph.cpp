@@ -0,0 +1,71 @@
+#include "StartupGraph.h"
+
+#include <algorithm>
+#include <cstdio>
+
+StartupGraph::StartupGraph()
+    : start_(Clock::now()) {}
+
+StartupGraph::~StartupGraph() {
+    // Tasks capture caller state by reference; never let one outlive the graph.
+    for (auto& task : tasks_) {
+        if (task.valid()) task.wait();
+    }
+}
+
+StartupGraph::TaskId StartupGraph::add(std::string name, std::function<void()> work, std::vector<TaskId> after) {
+    std::vector<std::shared_future<void>> dependencies;
+    for (TaskId id : after) {
+        dependencies.push_back(tasks_[id]);
+    }
+    tasks_.push_back(std::async(std::launch::async, [this, name = std::move(name), work = std::move(work),
+                                                     dependencies = std::move(dependencies)]() {
+        for (const auto& dependency : dependencies) {
+            dependency.get();
+        }
+        timed(name, work);
+    }).share());
+    return tasks_.size() - 1;
+}
+
+void StartupGraph::runHere(std::string name, const std::function<void()>& work, const std::vector<TaskId>& after) {
+    for (TaskId id : after) {
+        wait(id);
+    }
+    timed(name, work);
+}
+
+void StartupGraph::wait(TaskId task) {
+    tasks_[task].get();
+}
+
+void StartupGraph::waitAll() {
+    for (auto& task : tasks_) {
+        task.get();
+    }
+}
+
+void StartupGraph::print(const char* title) const {
+    std::lock_guard lock(mutex_);
+    std::vector<Phase> phases = phases_;
+    std::sort(phases.begin(), phases.end(), [](const Phase& a, const Phase& b) { return a.beginMs < b.beginMs; });
+
+    double totalMs = 0.0;
+    std::printf("%s phases:\n", title);
+    for (const Phase& phase : phases) {
+        std::printf("  %-20s %8.1f -> %8.1f ms (%7.1f ms)\n", phase.name.c_str(), phase.beginMs, phase.endMs,
+                    phase.endMs - phase.beginMs);
+        totalMs = std::max(totalMs, phase.endMs);
+    }
+    std::printf("  %-20s %8.1f ms\n", "total", totalMs);
+}
+
+void StartupGraph::timed(const std::string& name, const std::function<void()>& work) {
+    const auto begin = Clock::now();
+    work();
+    const auto end = Clock::now();
+
+    std::lock_guard lock(mutex_);
+    phases_.push_back({name, std::chrono::duration<double, std::milli>(begin - start_).count(),
+                       std::chrono::duration<double, std::milli>(end - start_).count()});
+}
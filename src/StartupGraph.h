@@ -0,0 +1,48 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Startup work expressed as a small dependency graph. Each task gets its own
+// thread, waits for the tasks it depends on, then runs; tasks that must stay on
+// the calling thread (scene graph, windowing) use runHere. Every task records
+// its span so the phases can be printed once startup is done.
+class StartupGraph {
+public:
+    using TaskId = size_t;
+
+    StartupGraph();
+    ~StartupGraph();
+
+    StartupGraph(const StartupGraph&) = delete;
+    StartupGraph& operator=(const StartupGraph&) = delete;
+
+    TaskId add(std::string name, std::function<void()> work, std::vector<TaskId> after = {});
+    void runHere(std::string name, const std::function<void()>& work, const std::vector<TaskId>& after = {});
+    // Rethrows if the task failed.
+    void wait(TaskId task);
+    void waitAll();
+
+    // Phases in start order with start/end offsets from construction, then the total.
+    void print(const char* title) const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Phase {
+        std::string name;
+        double beginMs = 0.0;
+        double endMs = 0.0;
+    };
+
+    void timed(const std::string& name, const std::function<void()>& work);
+
+    Clock::time_point start_;
+    std::vector<std::shared_future<void>> tasks_;
+    mutable std::mutex mutex_;
+    std::vector<Phase> phases_;
+};
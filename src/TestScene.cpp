@@ -1,16 +1,25 @@
 #include "TestScene.h"
+#include "StartupCache.h"
+#include "StartupGraph.h"
+#include "TrackLayout.h"
+#include "VehicleArchetypes.h"
 
-#include <Jolt/Physics/Body/BodyCreationSettings.h>
 #include <Jolt/Physics/Body/BodyInterface.h>
-#include <Jolt/Physics/Collision/Shape/BoxShape.h>
 #include <imgui.h>
-#include "threepp/cameras/OrthographicCamera.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
 
 using namespace threepp;
 
 namespace {
 
-std::shared_ptr<Group> createGround() {
+constexpr const char* GroundCacheKey = "scene/ground";
+// Bump when buildGround() changes, so the cached ground is rebuilt.
+constexpr uint32_t GroundRevision = 1;
+
+std::shared_ptr<Group> buildGround() {
     auto group = Group::create();
 
     auto groundGeometry = PlaneGeometry::create(1400, 1400);
@@ -23,8 +32,8 @@ std::shared_ptr<Group> createGround() {
     ground->receiveShadow = true;
     group->add(ground);
 
-    const float trackInner = 120.f;
-    const float trackOuter = 170.f;
+    const float trackInner = Track::Inner;
+    const float trackOuter = Track::Outer;
 
     auto trackMaterial = MeshLambertMaterial::create();
     trackMaterial->color = Color(0x303030);
@@ -38,7 +47,7 @@ std::shared_ptr<Group> createGround() {
     auto lineMaterial = MeshLambertMaterial::create();
     lineMaterial->color = Color(0xf1f1f1);
     lineMaterial->side = Side::Double;
-    auto centerLine = Mesh::create(RingGeometry::create(144.0f, 146.0f, 128), lineMaterial);
+    auto centerLine = Mesh::create(RingGeometry::create(Track::CenterLine - 1.f, Track::CenterLine + 1.f, 128), lineMaterial);
     centerLine->position.y = 0.02f;
     centerLine->rotateX(math::degToRad(90));
     group->add(centerLine);
@@ -56,7 +65,7 @@ std::shared_ptr<Group> createGround() {
     group->add(curbOuter);
 
     auto startLine = Mesh::create(PlaneGeometry::create(12, 4.f), lineMaterial);
-    startLine->position.set(trackOuter - 4.f, 0.025f, 0);
+    startLine->position.set(Track::StartLineX, 0.025f, 0);
     startLine->rotateX(math::degToRad(90));
     group->add(startLine);
 
@@ -165,93 +174,176 @@ std::shared_ptr<Group> createGround() {
     return group;
 }
 
-void createGroundBody(PhysicsWorld& physics) {
-    JPH::BodyInterface& bodyInterface = physics.bodyInterface();
-    auto groundShape = new JPH::BoxShape(JPH::Vec3(300.f, 0.5f, 300.f));
-    JPH::BodyCreationSettings groundSettings(
-        groundShape,
-        JPH::RVec3(0, -0.5f, 0),
-        JPH::Quat::sIdentity(),
-        JPH::EMotionType::Static,
-        PhysicsLayers::Static);
-    bodyInterface.CreateAndAddBody(groundSettings, JPH::EActivation::DontActivate);
+} // namespace
+
+std::shared_ptr<Group> createGround() {
+    if (auto cache = StartupCache::active()) {
+        if (auto group = decodeMeshes(cache->find(GroundCacheKey, GroundRevision))) return group;
+    }
+    return buildGround();
+}
+
+namespace {
+
+// The five showcase vehicles in a row at the origin, then startup traffic along the lanes.
+std::vector<VehiclePlacement> planVehicles(TestScene& testScene) {
+    const VehicleType types[] = {VehicleType::Kart, VehicleType::Sedan, VehicleType::Truck, VehicleType::Tank, VehicleType::Motorcycle};
+    const float x[] = {-12, -6, 2, 10, 16};
+    std::vector<VehiclePlacement> spawns;
+    for (int i = 0; i < 5; ++i) {
+        spawns.push_back({types[i], JPH::RVec3(x[i], PhysicsVehicle::spawnHeight(types[i]), 0), JPH::Quat::sIdentity()});
+    }
+    testScene.spawnCursor = 0;
+    for (int i = 0; i < testScene.startupTraffic; ++i) {
+        const VehicleType type = types[i % 5];
+        spawns.push_back({type, testScene.nextLanePosition(type), JPH::Quat::sIdentity()});
+    }
+    return spawns;
+}
+
+// Cached vehicle meshes per type as plain buffers; empty where there is no cache.
+using VehicleMeshes = std::array<std::vector<MeshBuffers>, vehicleArchetypes.size()>;
+
+// Touches no threepp objects, so it can run as a startup task.
+void decodeVehicleModels(VehicleMeshes& meshes) {
+    for (const VehicleArchetypeParams& params : vehicleArchetypes) {
+        VehicleFactory::decodeVehicleMeshes(params.type, meshes[static_cast<size_t>(params.type)]);
+    }
 }
 
-void setupVehicles(TestScene& testScene) {
-    auto kart = VehicleFactory::create(VehicleType::Kart);
-    kart.group->position.set(-12, 0, 0);
-    testScene.scene->add(kart.group);
-
-    auto sedan = VehicleFactory::create(VehicleType::Sedan);
-    sedan.group->position.set(-6, 0, 0);
-    testScene.scene->add(sedan.group);
-
-    auto truck = VehicleFactory::create(VehicleType::Truck);
-    truck.group->position.set(2, 0, 0);
-    testScene.scene->add(truck.group);
-
-    auto tank = VehicleFactory::create(VehicleType::Tank);
-    tank.group->position.set(10, 0, 0);
-    testScene.scene->add(tank.group);
-
-    auto motorcycle = VehicleFactory::create(VehicleType::Motorcycle);
-    motorcycle.group->position.set(16, 0, 0);
-    testScene.scene->add(motorcycle.group);
-
-    testScene.vehicles = {kart, sedan, truck, tank, motorcycle};
-    testScene.physicsVehicles.emplace_back(std::make_unique<PhysicsVehicle>(*testScene.physics, testScene.vehicles[0], VehicleType::Kart, JPH::RVec3(-12, PhysicsVehicle::spawnHeight(VehicleType::Kart), 0)));
-    testScene.physicsVehicles.emplace_back(std::make_unique<PhysicsVehicle>(*testScene.physics, testScene.vehicles[1], VehicleType::Sedan, JPH::RVec3(-6, PhysicsVehicle::spawnHeight(VehicleType::Sedan), 0)));
-    testScene.physicsVehicles.emplace_back(std::make_unique<PhysicsVehicle>(*testScene.physics, testScene.vehicles[2], VehicleType::Truck, JPH::RVec3(2, PhysicsVehicle::spawnHeight(VehicleType::Truck), 0)));
-    testScene.physicsVehicles.emplace_back(std::make_unique<PhysicsVehicle>(*testScene.physics, testScene.vehicles[3], VehicleType::Tank, JPH::RVec3(10, PhysicsVehicle::spawnHeight(VehicleType::Tank), 0)));
-    testScene.physicsVehicles.emplace_back(std::make_unique<PhysicsVehicle>(*testScene.physics, testScene.vehicles[4], VehicleType::Motorcycle, JPH::RVec3(16, PhysicsVehicle::spawnHeight(VehicleType::Motorcycle), 0)));
+// threepp hands out object ids and UUIDs from shared state, so models are built
+// on the main thread from the decoded buffers. Geometry and materials are created
+// once per type; each vehicle only adds its own meshes and groups.
+void buildModels(const std::vector<VehiclePlacement>& spawns, const VehicleMeshes& meshes, std::vector<VehicleModel>& models) {
+    std::array<SharedMeshes, vehicleArchetypes.size()> shared;
+    std::array<bool, vehicleArchetypes.size()> built{};
+    models.clear();
+    models.reserve(spawns.size());
+    for (const VehiclePlacement& spawn : spawns) {
+        const auto type = static_cast<size_t>(spawn.type);
+        if (!built[type]) {
+            shared[type] = SharedMeshes(meshes[type]);
+            built[type] = true;
+        }
+        models.push_back(VehicleFactory::create(spawn.type, shared[type]));
+    }
+}
+
+// Model building, body insertion and scene attachment stay on the calling thread.
+void spawnPlanned(TestScene& testScene, const std::vector<VehiclePlacement>& spawns, const VehicleMeshes& meshes) {
+    std::vector<VehicleModel> models;
+    buildModels(spawns, meshes, models);
+    testScene.vehicles = std::make_unique<VehicleRegistry>(*testScene.physics);
+    testScene.spawnBatch(spawns, models);
     testScene.activeVehicle = 0;
 }
 
-void addLights(const std::shared_ptr<Scene>& scene) {
+// Sized for bulk-spawned fleets of a few thousand vehicles.
+PhysicsWorld::Config sceneWorldConfig() {
+    PhysicsWorld::Config config;
+    config.maxBodies = 8192;
+    config.maxBodyPairs = 16384;
+    config.maxContactConstraints = 8192;
+    config.tempAllocatorBytes = 32 * 1024 * 1024;
+    return config;
+}
+
+void createPhysics(TestScene& testScene) {
+    testScene.physics = std::make_unique<PhysicsWorld>(sceneWorldConfig());
+    Track::createGroundBody(*testScene.physics);
+    testScene.lidar = std::make_unique<LidarSensors>(*testScene.physics);
+    testScene.predictor = std::make_unique<TrajectoryPredictor>(*testScene.physics);
+    testScene.fleet = std::make_unique<FleetSpawner>(*testScene.physics);
+    testScene.ai = std::make_unique<AiDrivers>(*testScene.physics);
+}
+
+// Mapping is cheap; only the first launch bakes, which needs the Jolt runtime.
+void openStartupCache(TestScene& testScene) {
+    std::shared_ptr<const StartupCache> cache = StartupCache::open(StartupCache::DefaultPath);
+    // The header only covers the vehicle builders; the ground has its own revision.
+    if (!cache || cache->find(GroundCacheKey, GroundRevision).empty()) {
+        testScene.joltRuntime = JoltRuntime::acquire();
+        cache = StartupCache::bake(StartupCache::DefaultPath, [](StartupCache::Builder& builder) {
+            builder.add(GroundCacheKey, encodeMeshes(*buildGround()), GroundRevision);
+        });
+    }
+    const bool cached = cache != nullptr;
+    StartupCache::setActive(std::move(cache));
+    // Without a cache the blueprints come from procedural threepp models, which
+    // must not be built on the "vehicle shapes" task thread.
+    if (!cached) {
+        for (const VehicleArchetypeParams& params : vehicleArchetypes) {
+            PhysicsVehicle::sharedBlueprint(params.type);
+        }
+    }
+}
+
+void addLights(TestScene& testScene) {
     auto hemi = HemisphereLight::create(threepp::Color::white, threepp::Color::gray, 0.9f);
-    scene->add(hemi);
-
-    auto dir = DirectionalLight::create(threepp::Color::white, 1.0f);
-    dir->position.set(20, 25, 20);
-    dir->castShadow = true;
-    dir->shadow->mapSize.set(4096, 4096);
-    dir->shadow->camera->nearPlane = 1.f;
-    dir->shadow->camera->farPlane = 120.f;
-    if (auto* shadowCam = dynamic_cast<OrthographicCamera*>(dir->shadow->camera.get())) {
-        shadowCam->left = -60.f;
-        shadowCam->right = 60.f;
-        shadowCam->top = 60.f;
-        shadowCam->bottom = -60.f;
-        shadowCam->updateProjectionMatrix();
-    }
-    scene->add(dir);
+    testScene.scene->add(hemi);
+
+    testScene.shadows = std::make_unique<ShadowRig>(*testScene.scene, Vector3(20, 25, 20));
 }
 
 } // namespace
 
-TestScene createTestScene(Canvas& canvas) {
+TestScene createTestScene(Canvas& canvas, int trafficVehicles) {
     TestScene testScene;
-    testScene.scene = Scene::create();
-    testScene.camera = PerspectiveCamera::create(60, canvas.aspect(), 0.1f, 200);
-    testScene.camera->position.set(10, 8, 12);
+    testScene.startupTraffic = trafficVehicles;
+    StartupGraph graph;
 
-    testScene.controls = std::make_unique<OrbitControls>(*testScene.camera, canvas);
-    testScene.controls->target.set(0, 1, 0);
-    testScene.controls->update();
+    // Everything below builds from the mapped cache when it is valid.
+    graph.runHere("startup cache", [&]() { openStartupCache(testScene); });
 
-    addLights(testScene.scene);
+    const std::vector<VehiclePlacement> spawns = planVehicles(testScene);
+    VehicleMeshes vehicleMeshes;
+    std::vector<MeshBuffers> groundMeshes;
 
-    auto ground = createGround();
-    testScene.scene->add(ground);
+    const auto runtime = graph.add("jolt runtime", [&]() { testScene.joltRuntime = JoltRuntime::acquire(); });
+    const auto physics = graph.add("physics world", [&]() { createPhysics(testScene); }, {runtime});
+    const auto shapes = graph.add("vehicle shapes", []() {
+        for (const VehicleArchetypeParams& params : vehicleArchetypes) {
+            PhysicsVehicle::sharedBlueprint(params.type);
+        }
+    }, {runtime});
+    // Only plain buffers are decoded off the main thread; the threepp objects are
+    // built in the attach and spawn phases below.
+    const auto groundGeometry = graph.add("ground decode", [&]() {
+        if (auto cache = StartupCache::active()) decodeMeshBuffers(cache->find(GroundCacheKey, GroundRevision), groundMeshes);
+    });
+    const auto vehicleModels = graph.add("vehicle decode", [&]() { decodeVehicleModels(vehicleMeshes); });
 
-    testScene.physics = std::make_unique<PhysicsWorld>();
-    createGroundBody(*testScene.physics);
-    setupVehicles(testScene);
+    graph.runHere("scene setup", [&]() {
+        testScene.scene = Scene::create();
+        testScene.camera = PerspectiveCamera::create(60, canvas.aspect(), 0.1f, 200);
+        testScene.camera->position.set(10, 8, 12);
 
+        testScene.controls = std::make_unique<OrbitControls>(*testScene.camera, canvas);
+        testScene.controls->target.set(0, 1, 0);
+        testScene.controls->update();
+
+        addLights(testScene);
+        testScene.telemetry = std::make_unique<VehicleTelemetry>();
 #ifdef JPH_DEBUG_RENDERER
-    testScene.debugRenderer = std::make_unique<JoltDebugRenderer>();
-    testScene.scene->add(testScene.debugRenderer->group());
+        testScene.debugRenderer = std::make_unique<JoltDebugRenderer>();
+        testScene.scene->add(testScene.debugRenderer->group());
 #endif
+    });
+
+    graph.runHere("ground attach", [&]() {
+        testScene.ground = groundMeshes.empty() ? buildGround() : buildMeshes(groundMeshes);
+        testScene.scene->add(testScene.ground);
+        // The flat track rings span the whole world, so only index the props standing on it.
+        for (auto* child : testScene.ground->children) {
+            if (child->castShadow) {
+                testScene.culler.add(*child);
+            }
+        }
+    }, {groundGeometry});
+
+    graph.runHere("vehicle spawn", [&]() { spawnPlanned(testScene, spawns, vehicleMeshes); }, {physics, shapes, vehicleModels});
+    graph.waitAll();
+    graph.print("Startup");
 
     return testScene;
 }
@@ -260,7 +352,9 @@ void TestScene::update(float dt) {
     controller.update(dt);
 
     int switchTo = controller.consumeSwitchRequest();
-    if (switchTo >= 0 && switchTo < static_cast<int>(physicsVehicles.size())) {
+    if (switchTo >= 0 && switchTo < static_cast<int>(vehicles->size()) && switchTo != activeVehicle) {
+        // The rollback session binds players to vehicles when it starts.
+        stopRollback();
         activeVehicle = switchTo;
     }
     if (controller.consumeResetRequest()) {
@@ -271,23 +365,88 @@ void TestScene::update(float dt) {
         toggleCameraMode();
     }
 
+    if (floatingOrigin && activeVehicle < static_cast<int>(vehicles->size())) {
+        const JPH::RVec3 focus = (*vehicles)[activeVehicle].position();
+        const float x = static_cast<float>(focus.GetX());
+        const float z = static_cast<float>(focus.GetZ());
+        if (x * x + z * z > originRebaseDistance * originRebaseDistance) {
+            rebaseOrigin(JPH::Vec3(std::round(x), 0.f, std::round(z)));
+        }
+    }
+
     VehicleInput input = controller.input();
-    for (size_t i = 0; i < physicsVehicles.size(); ++i) {
-        if (static_cast<int>(i) == activeVehicle) {
-            physicsVehicles[i]->applyInput(input);
-        } else {
-            physicsVehicles[i]->applyInput({});
+    physics->contactEvents().setFilter(contactFilter);
+    const auto stepStart = std::chrono::steady_clock::now();
+    if (rollback) {
+        // Rollback runs at its own fixed tick; inputs are applied inside the session.
+        rollbackAccumulator += dt;
+        while (rollbackAccumulator >= rollback->dt()) {
+            rollbackAccumulator -= rollback->dt();
+            remotePeer->update(rollback->tick());
+            rollback->advance(input);
+            ++simTick;
+            simTime += rollback->dt();
+        }
+    } else {
+        frameInputs.assign(vehicles->size(), VehicleInput{});
+        if (aiEnabled) {
+            ai->update(*vehicles, frameInputs, static_cast<float>(-originOffsetX), static_cast<float>(-originOffsetZ));
         }
+        if (activeVehicle < static_cast<int>(frameInputs.size())) {
+            frameInputs[activeVehicle] = input;
+        }
+        vehicles->applyInputs(frameInputs);
+        physics->step(dt);
+        ++simTick;
+        simTime += dt;
     }
+    const auto stepEnd = std::chrono::steady_clock::now();
+    lidar->update(dt);
+    updatePrediction(input);
+    const auto& contacts = physics->contactEvents().batch();
+    contactEventCount = contacts.size();
+    for (const ContactEvent& contact : contacts) {
+        if (contact.type != ContactEventType::Added) continue;
+        peakImpulse = std::max(peakImpulse, contact.impulse);
+        if (recentImpacts.size() == 8) {
+            recentImpacts.erase(recentImpacts.begin());
+        }
+        recentImpacts.push_back(contact);
+    }
+    for (size_t i = 0; i < vehicles->size(); ++i) {
+        const VehicleHandle handle = vehicles->handleAt(i);
+        telemetry->record(simTick, simTime, static_cast<uint16_t>(handle.index), static_cast<uint16_t>(handle.generation),
+                          (*vehicles)[i]);
+    }
+    const auto telemetryEnd = std::chrono::steady_clock::now();
+    if (transformRing) {
+        transformRing->publish(*vehicles, simTick, simTime, originOffsetX, originOffsetZ, activeVehicle);
+    }
+    stepMs = std::chrono::duration<float, std::milli>(stepEnd - stepStart).count();
+    telemetryMs = std::chrono::duration<float, std::milli>(telemetryEnd - stepEnd).count();
+    publishMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - telemetryEnd).count();
 
-    physics->step(dt);
+    // Only casters inside the shadow frustum affect the map.
+    bool castersMoved = false;
+    for (size_t i = 0; i < vehicles->size(); ++i) {
+        auto& vehicle = (*vehicles)[i];
+        const auto& group = vehicle.model().group;
+        const Vector3 prevPosition = group->position;
+        const Quaternion prevRotation = group->quaternion;
+        vehicle.syncVisual();
+        const uint32_t slot = vehicles->handleAt(i).index;
+        culler.move(vehicleProxies[slot], group->position);
+        vehicleGrid.update(slot, JPH::Vec3(group->position.x, group->position.y, group->position.z));
 
-    for (auto& vehicle : physicsVehicles) {
-        vehicle->syncVisual();
+        const float eps = 1e-4f;
+        const bool moved = prevPosition.distanceToSquared(group->position) > eps * eps ||
+                           std::abs(prevRotation.x - group->quaternion.x) > eps || std::abs(prevRotation.y - group->quaternion.y) > eps ||
+                           std::abs(prevRotation.z - group->quaternion.z) > eps || std::abs(prevRotation.w - group->quaternion.w) > eps;
+        castersMoved = castersMoved || (moved && shadows->covers(group->position, ShadowRig::VehicleCasterRadius));
     }
 
-    if (cameraMode == CameraMode::ThirdPerson && !vehicles.empty()) {
-        const auto& target = vehicles[activeVehicle];
+    if (cameraMode == CameraMode::ThirdPerson && activeVehicle < static_cast<int>(vehicles->size())) {
+        const auto& target = (*vehicles)[activeVehicle].model();
         if (target.group) {
             Vector3 forward = Vector3(0, 0, 1);
             forward.applyQuaternion(target.group->quaternion);
@@ -301,6 +460,14 @@ void TestScene::update(float dt) {
         }
     }
 
+    for (auto& physicsVehicle : *vehicles) {
+        VehicleModel& vehicle = physicsVehicle->model();
+        const float distance = vehicle.group->position.distanceTo(camera->position);
+        const VehicleLod lod = VehicleFactory::selectLod(vehicle, distance);
+        castersMoved = castersMoved || (lod != vehicle.lod && shadows->covers(vehicle.group->position, ShadowRig::VehicleCasterRadius));
+        VehicleFactory::setLod(vehicle, lod, vehicleLods);
+    }
+
 #ifdef JPH_DEBUG_RENDERER
     if (showDebugDraw && debugRenderer) {
         debugRenderer->BeginFrame();
@@ -319,6 +486,21 @@ void TestScene::update(float dt) {
         debugRenderer->EndFrame();
     }
 #endif
+
+    // Shadows only need re-rendering when a caster in the frustum moved, when one
+    // appeared or disappeared, or when the frustum itself follows the active
+    // vehicle to a new texel. Moving casters are throttled by the rig.
+    if (activeVehicle < static_cast<int>(vehicles->size())) {
+        shadows->update((*vehicles)[activeVehicle].model().group->position);
+    }
+    // Casters inside the shadow frustum stay visible even when off screen.
+    culler.cull(*camera, &shadows->camera());
+    if (castersMoved) {
+        shadows->casterMoved();
+    }
+    if (culler.stats().toggled > 0) {
+        shadows->markDirty();
+    }
 }
 
 void TestScene::drawUi() {
@@ -328,13 +510,15 @@ void TestScene::drawUi() {
     ImGui::Text("Reset: R");
     ImGui::Text("Camera toggle: C");
 
-    if (!physicsVehicles.empty()) {
+    if (!vehicles->empty()) {
         ImGui::Separator();
-        ImGui::Text("Active vehicle: %d", activeVehicle + 1);
-        int maxIndex = static_cast<int>(physicsVehicles.size()) - 1;
-        ImGui::SliderInt("Active index", &activeVehicle, 0, maxIndex);
+        ImGui::Text("Active vehicle: %d of %zu", activeVehicle + 1, vehicles->size());
+        int maxIndex = static_cast<int>(vehicles->size()) - 1;
+        if (ImGui::SliderInt("Active index", &activeVehicle, 0, maxIndex)) {
+            stopRollback();
+        }
 
-        auto& vehicle = physicsVehicles[activeVehicle];
+        auto* vehicle = &(*vehicles)[activeVehicle];
         auto& settings = vehicle->settings();
         ImGui::SliderFloat("Engine force", &settings.engineForce, 2000.f, 20000.f);
         ImGui::SliderFloat("Max speed", &settings.maxSpeed, 5.f, 60.f);
@@ -346,6 +530,165 @@ void TestScene::drawUi() {
     }
     }
 
+    ImGui::Separator();
+    if (ImGui::CollapsingHeader("Physics step")) {
+        PhysicsWorld::SubstepSettings substeps = physics->substepSettings();
+        bool changed = ImGui::Checkbox("Adaptive collision steps", &substeps.adaptive);
+        changed |= ImGui::SliderInt("Max steps", &substeps.maxSteps, 1, 8);
+        changed |= ImGui::SliderFloat("Max travel per step (m)", &substeps.maxTravelPerStep, 0.05f, 1.f);
+        changed |= ImGui::Checkbox("LinearCast for fast bodies", &substeps.linearCastFastBodies);
+        changed |= ImGui::SliderFloat("LinearCast speed (m/s)", &substeps.linearCastSpeed, 5.f, 60.f);
+        if (changed) {
+            physics->setSubstepSettings(substeps);
+        }
+        const auto& stepStats = physics->stepStats();
+        ImGui::Text("Step %.3f ms, %d collision step(s)", stepMs, stepStats.collisionSteps);
+        ImGui::Text("Fastest body %.1f m/s, LinearCast bodies %d", stepStats.maxBodySpeed, stepStats.linearCastBodies);
+    }
+
+    ImGui::Separator();
+    const auto& capacity = physics->capacityStats();
+    const ImVec4 warning(1.f, 0.45f, 0.3f, 1.f);
+    if (capacity.errorSteps() > 0 || capacity.tempOverflows > 0) {
+        ImGui::TextColored(warning, "Physics capacity exceeded: contacts or pairs were dropped");
+    }
+    if (ImGui::CollapsingHeader("Capacity")) {
+        // Highlight anything above 80% of its limit.
+        auto usage = [&](const char* label, double used, double limit, const char* unit) {
+            const bool high = limit > 0.0 && used > 0.8 * limit;
+            if (high) {
+                ImGui::TextColored(warning, "%s: %.0f / %.0f %s", label, used, limit, unit);
+            } else {
+                ImGui::Text("%s: %.0f / %.0f %s", label, used, limit, unit);
+            }
+        };
+        usage("Bodies", capacity.bodies, capacity.maxBodies, "");
+        usage("Contact manifolds", capacity.contactManifolds, capacity.maxContactConstraints, "");
+        // Jolt does not expose the live body pair count, and the pair cache also holds
+        // AABB-overlap pairs without contacts, so only the full flag is reliable.
+        const bool pairsFull = (capacity.lastError & JPH::EPhysicsUpdateError::BodyPairCacheFull) != JPH::EPhysicsUpdateError::None;
+        if (pairsFull) {
+            ImGui::TextColored(warning, "Body pair cache full (%u pairs)", capacity.maxBodyPairs);
+        } else {
+            ImGui::Text("Body pair cache: %u pairs, not full", capacity.maxBodyPairs);
+        }
+        usage("Temp allocator peak", capacity.tempPeak / 1024.0, capacity.tempCapacity / 1024.0, "KiB");
+        ImGui::Text("Active bodies %u, islands %d, temp peak ever %.0f KiB", capacity.activeBodies, capacity.islands,
+                    capacity.tempPeakEver / 1024.0);
+        ImGui::Text("Full caches (steps): manifold %llu, body pair %llu, contact %llu",
+                    static_cast<unsigned long long>(capacity.manifoldCacheFullSteps),
+                    static_cast<unsigned long long>(capacity.bodyPairCacheFullSteps),
+                    static_cast<unsigned long long>(capacity.contactConstraintsFullSteps));
+        ImGui::Text("Temp allocator heap fallbacks: %llu", static_cast<unsigned long long>(capacity.tempOverflows));
+    }
+
+    ImGui::Separator();
+    if (ImGui::CollapsingHeader("Traffic")) {
+        const char* typeNames[] = {"Kart", "Sedan", "Truck", "Tank", "Motorcycle"};
+        ImGui::Combo("Type", &spawnType, typeNames, IM_ARRAYSIZE(typeNames));
+        ImGui::SliderInt("Count", &spawnCount, 1, 100);
+        if (ImGui::Button("Spawn")) {
+            spawnVehicles(static_cast<VehicleType>(spawnType), spawnCount);
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Despawn")) {
+            // Newest first, but never the vehicle being driven.
+            for (int i = 0; i < spawnCount && vehicles->size() > 1; ++i) {
+                size_t index = vehicles->size() - 1;
+                if (static_cast<int>(index) == activeVehicle) --index;
+                despawnVehicle(vehicles->handleAt(index));
+            }
+        }
+        ImGui::SliderInt("Fleet size", &fleetCount, 10, 5000);
+        ImGui::Checkbox("On track", &fleetOnTrack);
+        ImGui::SameLine();
+        if (ImGui::Button("Spawn fleet")) {
+            spawnFleet(fleetCount, fleetOnTrack);
+        }
+        const auto& fleetStats = fleet->stats();
+        ImGui::Text("Fleet: %d/%d placed, %d off ground, %d overlapping", fleetStats.placed, fleetStats.requested,
+                    fleetStats.noGround, fleetStats.overlapping);
+        ImGui::Text("Sample %.2f ms, query %.2f ms, models %.1f ms, insert %.1f ms", fleetStats.sampleMs, fleetStats.queryMs,
+                    fleetBuildMs - fleetStats.sampleMs - fleetStats.queryMs, fleetSpawnMs);
+        ImGui::Text("Vehicles: %zu (slots %zu)", vehicles->size(), vehicles->slotCount());
+        const auto& pool = vehicles->poolStats();
+        ImGui::Text("Pooled: %zu, hit rate %.0f%% (%llu/%llu), evicted %llu", vehicles->pooled(), pool.hitRate() * 100.0,
+                    static_cast<unsigned long long>(pool.hits), static_cast<unsigned long long>(pool.hits + pool.misses),
+                    static_cast<unsigned long long>(pool.evicted));
+        int capacity = static_cast<int>(vehicles->poolCapacity());
+        if (ImGui::SliderInt("Pool per type", &capacity, 0, 256)) {
+            vehicles->setPoolCapacity(static_cast<size_t>(capacity));
+        }
+
+        if (activeVehicle < static_cast<int>(vehicles->size())) {
+            nearbyVehicles.clear();
+            const auto& position = (*vehicles)[activeVehicle].model().group->position;
+            vehicleGrid.queryRadius(JPH::Vec3(position.x, position.y, position.z), neighborRadius, nearbyVehicles,
+                                    vehicles->handleAt(activeVehicle).index);
+            ImGui::SliderFloat("Neighbour radius", &neighborRadius, 5.f, 100.f, "%.0f m");
+            ImGui::Text("Vehicles near the active one: %zu (grid cells %zu)", nearbyVehicles.size(), vehicleGrid.cellCount());
+        }
+
+        ImGui::Checkbox("AI drivers", &aiEnabled);
+        AiDrivers::Config& aiConfig = ai->config();
+        ImGui::SliderFloat("AI speed", &aiConfig.targetSpeed, 5.f, 40.f, "%.0f m/s");
+        ImGui::SliderFloat("AI headway", &aiConfig.headway, 0.5f, 3.f, "%.1f s");
+        const auto& aiStats = ai->stats();
+        ImGui::Text("Drivers %zu, following %zu, gather %.3f ms, solve %.3f ms", aiStats.drivers, aiStats.following,
+                    aiStats.gatherMs, aiStats.solveMs);
+    }
+
+    ImGui::Separator();
+    if (ImGui::CollapsingHeader("Telemetry")) {
+        bool logging = telemetry->logging();
+        if (ImGui::Checkbox("Binary log (telemetry.vtel)", &logging)) {
+            if (logging) {
+                telemetry->startLogging("telemetry.vtel");
+            } else {
+                telemetry->stopLogging();
+            }
+        }
+        ImGui::Text("Step %.3f ms, sampling %.4f ms", stepMs, telemetryMs);
+        if (transformRing) {
+            ImGui::Text("Transform ring %s: %llu frames, publish %.3f ms", transformRing->name().c_str(),
+                        static_cast<unsigned long long>(transformRing->published()), publishMs);
+        }
+        ImGui::Text("Samples %llu, written %llu, dropped %llu",
+                    static_cast<unsigned long long>(telemetry->recorded()),
+                    static_cast<unsigned long long>(telemetry->written()),
+                    static_cast<unsigned long long>(telemetry->dropped()));
+
+        std::vector<const VehicleTelemetrySample*>& history = telemetryHistory;
+        std::vector<float>& values = telemetryValues;
+        history.clear();
+        if (activeVehicle < static_cast<int>(vehicles->size())) {
+            const VehicleHandle handle = vehicles->handleAt(activeVehicle);
+            telemetry->history(static_cast<uint16_t>(handle.index), static_cast<uint16_t>(handle.generation), 240, history);
+        }
+        auto plot = [&](const char* label, auto&& select) {
+            values.clear();
+            for (const auto* sample : history) {
+                values.push_back(select(*sample));
+            }
+            if (!values.empty()) {
+                ImGui::PlotLines(label, values.data(), static_cast<int>(values.size()), 0, nullptr, FLT_MAX, FLT_MAX, ImVec2(0, 50));
+            }
+        };
+        plot("Speed", [](const VehicleTelemetrySample& s) { return s.speed; });
+        plot("Engine RPM", [](const VehicleTelemetrySample& s) { return s.engineRpm; });
+        plot("Gear", [](const VehicleTelemetrySample& s) { return static_cast<float>(s.gear); });
+        plot("Wheel 0 slip", [](const VehicleTelemetrySample& s) { return s.wheels[0].longitudinalSlip; });
+        plot("Wheel 0 suspension", [](const VehicleTelemetrySample& s) { return s.wheels[0].suspensionLength; });
+        if (!history.empty()) {
+            const auto& latest = *history.back();
+            int contacts = 0;
+            for (int w = 0; w < latest.wheelCount; ++w) {
+                contacts += latest.wheels[w].contact ? 1 : 0;
+            }
+            ImGui::Text("Wheels in contact: %d / %d", contacts, latest.wheelCount);
+        }
+    }
+
     ImGui::Separator();
     const char* modeLabel = cameraMode == CameraMode::Orbit ? "Orbit" : "Third Person";
     ImGui::Text("Camera mode: %s", modeLabel);
@@ -358,6 +701,113 @@ void TestScene::drawUi() {
         ImGui::SliderFloat("TP Look Height", &thirdPersonLookAtHeight, 0.5f, 4.f);
     }
 
+    ImGui::Separator();
+    if (ImGui::CollapsingHeader("LiDAR")) {
+        bool enabled = lidarEnabled;
+        if (ImGui::Checkbox("LiDAR on every vehicle", &enabled)) {
+            setLidarEnabled(enabled);
+        }
+        bool changed = ImGui::SliderInt("Channels", &lidarConfig.channels, 1, 128);
+        changed |= ImGui::SliderInt("Horizontal samples", &lidarConfig.horizontalSamples, 64, 4096);
+        changed |= ImGui::SliderFloat("Range (m)", &lidarConfig.range, 10.f, 300.f);
+        changed |= ImGui::SliderFloat("Rate (Hz)", &lidarConfig.rateHz, 1.f, 30.f);
+        if (changed && lidarEnabled) {
+            setLidarEnabled(true);
+        }
+        const auto& stats = lidar->stats();
+        ImGui::Text("Sensors %zu, scanned %d, rays %d in %d jobs", lidar->sensorCount(), stats.sensorsScanned, stats.raysCast, stats.jobs);
+        ImGui::Text("Scan %.2f ms (%.1f Mrays/s)", stats.scanMs, stats.raysPerSecond / 1e6);
+
+        if (activeVehicle < static_cast<int>(vehicles->size())) {
+            const LidarSensors::SensorId sensor = vehicleLidars[vehicles->handleAt(activeVehicle).index];
+            if (sensor >= 0) {
+                // Channel closest to the horizon, read straight from the shared buffer.
+                const LidarConfig& config = lidar->config(sensor);
+                const float t = config.maxElevation != config.minElevation ? -config.minElevation / (config.maxElevation - config.minElevation) : 0.f;
+                const int channel = std::clamp(static_cast<int>(std::round(t * (config.channels - 1))), 0, config.channels - 1);
+                ImGui::PlotLines("Horizon ring", lidar->ranges(sensor) + static_cast<size_t>(channel) * config.horizontalSamples,
+                                 config.horizontalSamples, 0, nullptr, 0.f, config.range, ImVec2(0, 80));
+            }
+        }
+    }
+
+    ImGui::Separator();
+    if (ImGui::CollapsingHeader("Prediction")) {
+        ImGui::Checkbox("Predict active vehicle", &predictionEnabled);
+        ImGui::SliderInt("Candidates", &predictionCandidates, 1, 32);
+        ImGui::SliderInt("Steps", &predictionSteps, 10, 300);
+        TrajectoryPredictor::Config predictorConfig = predictor->config();
+        float stepHz = 1.f / predictorConfig.dt;
+        if (ImGui::SliderFloat("Step rate (Hz)", &stepHz, 10.f, 60.f, "%.0f")) {
+            predictorConfig.dt = 1.f / stepHz;
+            predictor->setConfig(predictorConfig);
+        }
+        const auto& stats = predictor->stats();
+        ImGui::Text("%d x %d steps (%.1f s) in %.2f ms", stats.candidates, stats.steps, stats.steps * predictorConfig.dt, stats.wallMs);
+        ImGui::Text("Static clones %d, pool hits %d, misses %d", stats.staticBodies, stats.poolHits, stats.poolMisses);
+    }
+
+    ImGui::Separator();
+    if (ImGui::CollapsingHeader("Contacts")) {
+        bool vehiclesOnly = contactFilter.layerMask == (1u << PhysicsLayers::Dynamic);
+        if (ImGui::Checkbox("Vehicle layer only", &vehiclesOnly)) {
+            contactFilter.layerMask = vehiclesOnly ? (1u << PhysicsLayers::Dynamic) : ~0u;
+        }
+        ImGui::SliderFloat("Min impulse (N s)", &contactFilter.minImpulse, 0.f, 5000.f);
+        ImGui::Checkbox("Persisted", &contactFilter.persisted);
+        ImGui::SameLine();
+        ImGui::Checkbox("Removed", &contactFilter.removed);
+        ImGui::Text("Events last step: %zu, dropped %llu", contactEventCount,
+                    static_cast<unsigned long long>(physics->contactEvents().dropped()));
+        ImGui::Text("Peak impulse: %.0f N s", peakImpulse);
+        for (auto it = recentImpacts.rbegin(); it != recentImpacts.rend(); ++it) {
+            ImGui::Text("  bodies %u/%u  %.0f N s", it->body1.GetIndex(), it->body2.GetIndex(), it->impulse);
+        }
+    }
+
+    ImGui::Separator();
+    if (ImGui::CollapsingHeader("Rollback netcode")) {
+        bool enabled = rollback != nullptr;
+        if (ImGui::Checkbox("Loopback remote player", &enabled)) {
+            enabled ? startRollback() : stopRollback();
+        }
+        bool linkChanged = ImGui::SliderFloat("Latency (ms)", &loopbackSettings.latencyMs, 0.f, 300.f);
+        linkChanged |= ImGui::SliderFloat("Jitter (ms)", &loopbackSettings.jitterMs, 0.f, 50.f);
+        linkChanged |= ImGui::SliderFloat("Packet loss", &loopbackSettings.lossRate, 0.f, 0.5f);
+        if (linkChanged && loopback) {
+            loopback->setSettings(loopbackSettings);
+        }
+        if (rollback) {
+            const auto& stats = rollback->stats();
+            ImGui::Text("Tick %u, remote drives vehicle %d", rollback->tick(), rollback->playerVehicle(1) + 1);
+            ImGui::Text("Rollback depth %d (max %d), %llu rollbacks", stats.lastRollbackDepth, stats.maxRollbackDepth,
+                        static_cast<unsigned long long>(stats.rollbacks));
+            ImGui::Text("Resim %.3f ms, %.0f ticks/s, save %.3f ms", stats.lastResimMs, stats.resimTicksPerSecond(), stats.lastSaveMs);
+            ImGui::Text("Inputs dropped: %llu late, %llu early", static_cast<unsigned long long>(stats.lateInputs),
+                        static_cast<unsigned long long>(stats.earlyInputs));
+        }
+    }
+
+    ImGui::Separator();
+    ImGui::Checkbox("Floating origin", &floatingOrigin);
+    ImGui::SliderFloat("Rebase distance", &originRebaseDistance, 50.f, 4096.f);
+    ImGui::Text("Origin offset: %.0f, %.0f (%d rebases)", originOffsetX, originOffsetZ, originRebases);
+
+    ImGui::Separator();
+    bool cullingEnabled = culler.enabled();
+    if (ImGui::Checkbox("Spatial culling", &cullingEnabled)) {
+        culler.setEnabled(cullingEnabled);
+    }
+    const auto& cullStats = culler.stats();
+    ImGui::Text("Visible: %d  Culled: %d", cullStats.visible, cullStats.culled);
+    ImGui::Text("Proxies: %d  Nodes tested: %d", cullStats.proxies, cullStats.nodesTested);
+    int lodCounts[3] = {0, 0, 0};
+    for (const auto& vehicle : *vehicles) {
+        ++lodCounts[static_cast<int>(vehicle->model().lod)];
+    }
+    ImGui::Text("LOD full/merged/proxy: %d/%d/%d", lodCounts[0], lodCounts[1], lodCounts[2]);
+    ImGui::Text("Shadow renders: %d  skipped: %d", shadows->renderedFrames(), shadows->skippedFrames());
+
 #ifdef JPH_DEBUG_RENDERER
     ImGui::Separator();
     ImGui::Checkbox("Jolt Debug Draw", &showDebugDraw);
@@ -366,18 +816,262 @@ void TestScene::drawUi() {
 }
 
 void TestScene::resetSimulation() {
-    for (auto& vehicle : vehicles) {
-        if (vehicle.group) {
-            scene->remove(*vehicle.group);
+    StartupGraph graph;
+    graph.runHere("teardown", [&]() {
+        stopRollback();
+        while (!vehicles->empty()) {
+            despawnVehicle(vehicles->handleAt(vehicles->size() - 1));
         }
-    }
-    physicsVehicles.clear();
-    vehicles.clear();
+        vehicles.reset();
+        lidar.reset();
+        predictor.reset();
+        fleet.reset();
+        ai.reset();
+    });
+    const PhysicsWorld::SubstepSettings substeps = physics->substepSettings();
     physics.reset();
 
-    physics = std::make_unique<PhysicsWorld>();
-    createGroundBody(*physics);
-    setupVehicles(*this);
+    // The rebuilt world starts at the original origin again.
+    const Vector3 offset(static_cast<float>(-originOffsetX), 0.f, static_cast<float>(-originOffsetZ));
+    ground->position.sub(offset);
+    culler.shiftOrigin(offset);
+    originOffsetX = 0.0;
+    originOffsetZ = 0.0;
+
+    const std::vector<VehiclePlacement> spawns = planVehicles(*this);
+    VehicleMeshes vehicleMeshes;
+    const auto world = graph.add("physics world", [&]() {
+        createPhysics(*this);
+        physics->setSubstepSettings(substeps);
+    });
+    const auto vehicleModels = graph.add("vehicle decode", [&]() { decodeVehicleModels(vehicleMeshes); });
+    graph.runHere("vehicle spawn", [&]() { spawnPlanned(*this, spawns, vehicleMeshes); }, {world, vehicleModels});
+    graph.waitAll();
+    graph.print("Reset");
+    shadows->markDirty();
+}
+
+void TestScene::rebaseOrigin(const JPH::Vec3& shift) {
+    physics->shiftOrigin(shift);
+
+    const Vector3 offset(shift.GetX(), shift.GetY(), shift.GetZ());
+    ground->position.sub(offset);
+    for (auto& vehicle : *vehicles) {
+        vehicle->model().group->position.sub(offset);
+    }
+    culler.shiftOrigin(offset);
+    camera->position.sub(offset);
+    if (controls) {
+        controls->target.sub(offset);
+        controls->update();
+    }
+    // The debug renderer redraws from body positions every frame, so it follows
+    // the rebased bodies without any state of its own to shift.
+    shadows->markDirty();
+
+    originOffsetX += shift.GetX();
+    originOffsetZ += shift.GetZ();
+    ++originRebases;
+
+    // Snapshots hold pre-shift positions; restoring one would undo the rebase.
+    if (rollback) {
+        rollback->resetHistory();
+    }
+}
+
+VehicleHandle TestScene::spawnVehicle(VehicleType type, const JPH::RVec3& position) {
+    // The rollback session holds raw vehicle pointers.
+    stopRollback();
+
+    // Pooled vehicles come back with their visuals; only new ones build a model.
+    const VehicleHandle handle = vehicles->spawn(type, position);
+    attachVehicle(handle);
+    return handle;
+}
+
+VehicleHandle TestScene::spawnVehicle(VehicleModel model, VehicleType type, const JPH::RVec3& position) {
+    stopRollback();
+
+    const VehicleHandle handle = vehicles->spawn(std::move(model), type, position);
+    attachVehicle(handle);
+    return handle;
+}
+
+void TestScene::attachVehicle(VehicleHandle handle) {
+    PhysicsVehicle& vehicle = *vehicles->get(handle);
+    vehicle.syncVisual();
+    VehicleModel& model = vehicle.model();
+    scene->add(model.group);
+    model.group->updateMatrixWorld(true);
+
+    if (vehicleProxies.size() < vehicles->slotCount()) {
+        vehicleProxies.resize(vehicles->slotCount(), SceneCuller::NullProxy);
+    }
+    vehicleProxies[handle.index] = culler.add(*model.group);
+    vehicleGrid.update(handle.index, JPH::Vec3(model.group->position.x, model.group->position.y, model.group->position.z));
+    vehicleLidars.resize(vehicleProxies.size(), -1);
+    if (lidarEnabled) {
+        vehicleLidars[handle.index] = lidar->attach(vehicle.bodyId(), lidarConfig);
+    }
+    shadows->markDirty();
+}
+
+void TestScene::despawnVehicle(VehicleHandle handle) {
+    PhysicsVehicle* vehicle = vehicles->get(handle);
+    if (!vehicle) return;
+    stopRollback();
+
+    const VehicleHandle active = activeVehicle < static_cast<int>(vehicles->size()) ? vehicles->handleAt(activeVehicle) : VehicleHandle{};
+    culler.remove(vehicleProxies[handle.index]);
+    vehicleGrid.remove(handle.index);
+    vehicleProxies[handle.index] = SceneCuller::NullProxy;
+    lidar->detach(vehicleLidars[handle.index]);
+    vehicleLidars[handle.index] = -1;
+    scene->remove(*vehicle->model().group);
+    vehicles->despawn(handle);
+
+    // Despawn moves the last vehicle into the freed spot; keep following the same one.
+    activeVehicle = std::max(vehicles->indexOf(active), 0);
+    shadows->markDirty();
+}
+
+void TestScene::spawnBatch(std::span<const VehiclePlacement> placements, std::span<VehicleModel> models) {
+    stopRollback();
+
+    std::vector<VehicleHandle> handles;
+    vehicles->spawnBatch(placements, models, handles);
+    for (const VehicleHandle& handle : handles) {
+        attachVehicle(handle);
+    }
+}
+
+void TestScene::spawnFleet(int count, bool onTrack) {
+    FleetSpawner::Region region = onTrack ? FleetSpawner::Region::track() : FleetSpawner::Region{};
+    if (!onTrack) {
+        // The whole ground slab, less a margin for the largest footprint.
+        region.halfExtentX = 290.f;
+        region.halfExtentZ = 290.f;
+    }
+    region.centerX -= static_cast<float>(originOffsetX);
+    region.centerZ -= static_cast<float>(originOffsetZ);
+    region.ringCenterX = region.centerX;
+    region.ringCenterZ = region.centerZ;
+    // A new layout every press; the overlap query keeps it clear of earlier fleets.
+    fleet->config().seed = ++fleetSeed;
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<VehiclePlacement> placements;
+    fleet->plan(region, count, placements);
+    VehicleMeshes meshes;
+    decodeVehicleModels(meshes);
+    std::vector<VehicleModel> models;
+    buildModels(placements, meshes, models);
+    const auto built = std::chrono::steady_clock::now();
+    spawnBatch(placements, models);
+    const auto end = std::chrono::steady_clock::now();
+    fleetBuildMs = std::chrono::duration<float, std::milli>(built - start).count();
+    fleetSpawnMs = std::chrono::duration<float, std::milli>(end - built).count();
+}
+
+void TestScene::spawnVehicles(VehicleType type, int count) {
+    for (int i = 0; i < count; ++i) {
+        spawnVehicle(type, nextLanePosition(type));
+    }
+}
+
+JPH::RVec3 TestScene::nextLanePosition(VehicleType type) {
+    const float spacing = 14.f;
+    const float lanes[] = {Track::CenterLine - 8.f, Track::CenterLine, Track::CenterLine + 8.f};
+    const float radius = lanes[spawnCursor % 3];
+    const float angle = (spawnCursor / 3) * spacing / Track::CenterLine;
+    ++spawnCursor;
+    const double x = radius * std::cos(angle) - originOffsetX;
+    const double z = radius * std::sin(angle) - originOffsetZ;
+    return JPH::RVec3(static_cast<JPH::Real>(x), PhysicsVehicle::spawnHeight(type), static_cast<JPH::Real>(z));
+}
+
+void TestScene::setLidarEnabled(bool enabled) {
+    lidarEnabled = enabled;
+    lidar->clear();
+    std::fill(vehicleLidars.begin(), vehicleLidars.end(), -1);
+    if (!enabled) return;
+
+    for (size_t i = 0; i < vehicles->size(); ++i) {
+        vehicleLidars[vehicles->handleAt(i).index] = lidar->attach((*vehicles)[i].bodyId(), lidarConfig);
+    }
+}
+
+void TestScene::updatePrediction(const VehicleInput& input) {
+    const bool active = predictionEnabled && activeVehicle < static_cast<int>(vehicles->size());
+    if (predictionLines) {
+        predictionLines->visible = active;
+    }
+    if (!active) return;
+
+    // Steering fan from full left to full right at the driver's current throttle.
+    const int candidates = std::max(predictionCandidates, 1);
+    predictionInputs.resize(candidates);
+    for (int i = 0; i < candidates; ++i) {
+        VehicleInput candidate = input;
+        candidate.steer = candidates > 1 ? -1.f + 2.f * static_cast<float>(i) / static_cast<float>(candidates - 1) : input.steer;
+        predictionInputs[i].assign(1, candidate);
+    }
+    const auto& trajectories = predictor->predict((*vehicles)[activeVehicle], predictionInputs, predictionSteps);
+
+    size_t vertexCount = 0;
+    for (const auto& trajectory : trajectories) {
+        vertexCount += trajectory.positions.size() > 1 ? (trajectory.positions.size() - 1) * 2 : 0;
+    }
+    if (!predictionLines) {
+        auto material = LineBasicMaterial::create();
+        material->color = threepp::Color(0xffaa33);
+        predictionLines = LineSegments::create(BufferGeometry::create(), material);
+        predictionLines->frustumCulled = false;
+        scene->add(predictionLines);
+    }
+    auto& geometry = *predictionLines->geometry();
+    auto* positions = geometry.hasAttribute("position") ? geometry.getAttribute<float>("position") : nullptr;
+    if (!positions || positions->array().size() < vertexCount * 3) {
+        auto attribute = FloatBufferAttribute::create(std::vector<float>(std::max<size_t>(vertexCount, 1024) * 3, 0.f), 3);
+        attribute->setUsage(DrawUsage::Dynamic);
+        geometry.setAttribute("position", attribute);
+        positions = attribute.get();
+    }
+
+    auto& array = positions->array();
+    size_t offset = 0;
+    for (const auto& trajectory : trajectories) {
+        for (size_t i = 1; i < trajectory.positions.size(); ++i) {
+            for (const JPH::RVec3& point : {trajectory.positions[i - 1], trajectory.positions[i]}) {
+                array[offset++] = static_cast<float>(point.GetX());
+                array[offset++] = static_cast<float>(point.GetY()) + 0.3f;
+                array[offset++] = static_cast<float>(point.GetZ());
+            }
+        }
+    }
+    positions->needsUpdate();
+    geometry.setDrawRange(0, static_cast<int>(vertexCount));
+}
+
+void TestScene::startRollback() {
+    if (rollback || vehicles->size() < 2) return;
+
+    std::vector<PhysicsVehicle*> all;
+    for (auto& vehicle : *vehicles) {
+        all.push_back(vehicle.get());
+    }
+    const int remoteVehicle = (activeVehicle + 1) % static_cast<int>(vehicles->size());
+
+    loopback = std::make_unique<LoopbackLink>(loopbackSettings);
+    rollback = std::make_unique<RollbackSession>(*physics, std::move(all), std::vector<int>{activeVehicle, remoteVehicle}, 0, loopback->endpointA());
+    remotePeer = std::make_unique<ScriptedRemotePeer>(loopback->endpointB(), 1);
+    rollbackAccumulator = 0.f;
+}
+
+void TestScene::stopRollback() {
+    rollback.reset();
+    remotePeer.reset();
+    loopback.reset();
 }
 
 void TestScene::toggleCameraMode() {
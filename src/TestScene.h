@@ -1,22 +1,112 @@
 #pragma once
 
 #include "threepp/threepp.hpp"
+#include "AiDrivers.h"
+#include "FleetSpawner.h"
 #include "PhysicsVehicle.h"
 #include "VehicleController.h"
 #include "VehicleFactory.h"
 #include "JoltDebugRenderer.h"
+#include "LidarSensors.h"
+#include "SceneCuller.h"
+#include "RollbackSession.h"
+#include "ShadowRig.h"
+#include "SpatialHash.h"
+#include "TrajectoryPredictor.h"
+#include "TransformRing.h"
+#include "VehicleRegistry.h"
+#include "VehicleTelemetry.h"
 #include <memory>
+#include <span>
 #include <vector>
 
 struct TestScene {
     std::shared_ptr<threepp::Scene> scene;
     std::shared_ptr<threepp::PerspectiveCamera> camera;
     std::unique_ptr<threepp::OrbitControls> controls;
-    std::vector<VehicleModel> vehicles;
+    // Keeps the Jolt runtime and its thread pool alive across world rebuilds on reset.
+    std::shared_ptr<JoltRuntime> joltRuntime;
     std::unique_ptr<PhysicsWorld> physics;
-    std::vector<std::unique_ptr<PhysicsVehicle>> physicsVehicles;
+    std::unique_ptr<VehicleRegistry> vehicles;
     VehicleController controller;
+    // Dense registry index of the driven vehicle.
     int activeVehicle = 0;
+    SceneCuller culler;
+    // Indexed by registry slot.
+    std::vector<SceneCuller::ProxyId> vehicleProxies;
+    // Per-type merged and proxy LOD meshes shared by every vehicle.
+    VehicleLodAssets vehicleLods;
+    // Vehicle positions keyed by registry slot, refreshed after every step.
+    SpatialHash vehicleGrid;
+    float neighborRadius = 30.f;
+    std::vector<SpatialHash::Neighbor> nearbyVehicles;
+    // Per-frame inputs by dense registry index.
+    std::vector<VehicleInput> frameInputs;
+    // Extra vehicles placed along the lanes on startup and reset.
+    int startupTraffic = 0;
+    int spawnCount = 10;
+    int spawnType = 0;
+    int spawnCursor = 0;
+    // Bulk spawning over the track ring or the whole ground.
+    std::unique_ptr<FleetSpawner> fleet;
+    int fleetCount = 500;
+    bool fleetOnTrack = true;
+    uint32_t fleetSeed = 0;
+    float fleetBuildMs = 0.f;
+    float fleetSpawnMs = 0.f;
+    std::unique_ptr<ShadowRig> shadows;
+    std::unique_ptr<VehicleTelemetry> telemetry;
+    // Scratch for the telemetry plots in drawUi.
+    std::vector<const VehicleTelemetrySample*> telemetryHistory;
+    std::vector<float> telemetryValues;
+    uint32_t simTick = 0;
+    float simTime = 0.f;
+    float stepMs = 0.f;
+    float telemetryMs = 0.f;
+    // Transforms of every step for viewer processes; null unless publishing.
+    std::unique_ptr<TransformRing> transformRing;
+    float publishMs = 0.f;
+    std::shared_ptr<threepp::Group> ground;
+
+    // Drive every vehicle except the active one.
+    std::unique_ptr<AiDrivers> ai;
+    bool aiEnabled = true;
+
+    // Rollouts of the active vehicle under a fan of steering inputs, drawn as lines.
+    std::unique_ptr<TrajectoryPredictor> predictor;
+    bool predictionEnabled = false;
+    int predictionCandidates = 9;
+    int predictionSteps = 90;
+    std::vector<std::vector<VehicleInput>> predictionInputs;
+    std::shared_ptr<threepp::LineSegments> predictionLines;
+
+    std::unique_ptr<LidarSensors> lidar;
+    LidarConfig lidarConfig;
+    bool lidarEnabled = false;
+    // Indexed by registry slot, -1 without a sensor.
+    std::vector<LidarSensors::SensorId> vehicleLidars;
+
+    // Contact events from the last step; impacts are kept for the debug panel.
+    ContactEvents::Filter contactFilter{1u << PhysicsLayers::Dynamic, 200.f};
+    size_t contactEventCount = 0;
+    float peakImpulse = 0.f;
+    std::vector<ContactEvent> recentImpacts;
+
+    // Floating origin: once the active vehicle is this far from the origin the
+    // whole world is shifted back by a whole-metre offset.
+    bool floatingOrigin = true;
+    float originRebaseDistance = 1024.f;
+    double originOffsetX = 0.0;
+    double originOffsetZ = 0.0;
+    int originRebases = 0;
+
+    // Rollback netcode test: the active vehicle is driven locally while a scripted
+    // remote peer drives the next one over a simulated lossy link.
+    std::unique_ptr<LoopbackLink> loopback;
+    std::unique_ptr<RollbackSession> rollback;
+    std::unique_ptr<ScriptedRemotePeer> remotePeer;
+    LoopbackLink::Settings loopbackSettings;
+    float rollbackAccumulator = 0.f;
 
     enum class CameraMode {
         Orbit,
@@ -36,6 +126,29 @@ struct TestScene {
     void onResize(threepp::WindowSize size, threepp::GLRenderer& renderer);
     void resetSimulation();
     void toggleCameraMode();
+    void rebaseOrigin(const JPH::Vec3& shift);
+    VehicleHandle spawnVehicle(VehicleType type, const JPH::RVec3& position);
+    // Spawns around an already built model, bypassing the pool.
+    VehicleHandle spawnVehicle(VehicleModel model, VehicleType type, const JPH::RVec3& position);
+    // Adds a freshly spawned vehicle to the scene, culler and LiDAR.
+    void attachVehicle(VehicleHandle handle);
+    void despawnVehicle(VehicleHandle handle);
+    // Spawns prebuilt models, one per placement, in a single broadphase batch.
+    void spawnBatch(std::span<const VehiclePlacement> placements, std::span<VehicleModel> models);
+    void spawnFleet(int count, bool onTrack);
+    // Places vehicles one after another along the track lanes.
+    void spawnVehicles(VehicleType type, int count);
+    JPH::RVec3 nextLanePosition(VehicleType type);
+    // Attaches a LiDAR with lidarConfig to every vehicle, or removes them all.
+    void setLidarEnabled(bool enabled);
+    // Predicts the active vehicle and refreshes the prediction lines.
+    void updatePrediction(const VehicleInput& input);
+    void startRollback();
+    void stopRollback();
 };
 
-TestScene createTestScene(threepp::Canvas& canvas);
+// Ground, track and props; decoded from the active StartupCache when it has them.
+std::shared_ptr<threepp::Group> createGround();
+
+// Builds the scene with a StartupGraph and prints its phase timings.
+TestScene createTestScene(threepp::Canvas& canvas, int trafficVehicles = 0);
@@ -0,0 +1,57 @@
+#include "TrackLayout.h"
+
+#include <Jolt/Physics/Body/BodyCreationSettings.h>
+#include <Jolt/Physics/Body/BodyInterface.h>
+#include <Jolt/Physics/Collision/Shape/BoxShape.h>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace JPH;
+
+void Track::createGroundBody(PhysicsWorld& physics) {
+    BodyInterface& bodyInterface = physics.bodyInterface();
+    auto groundShape = new BoxShape(Vec3(300.f, 0.5f, 300.f));
+    BodyCreationSettings groundSettings(
+        groundShape,
+        RVec3(0, -0.5f, 0),
+        Quat::sIdentity(),
+        EMotionType::Static,
+        PhysicsLayers::Static);
+    bodyInterface.CreateAndAddBody(groundSettings, EActivation::DontActivate);
+}
+
+bool Track::crossesStartLine(const RVec3& from, const RVec3& to) {
+    if (!(from.GetZ() < 0.0 && to.GetZ() >= 0.0)) return false;
+    const auto x = 0.5 * (from.GetX() + to.GetX());
+    return x >= Inner && x <= Outer;
+}
+
+VehicleInput Track::followRacingLine(const RVec3& position, const Quat& rotation, const Vec3& velocity, float targetSpeed, float radius) {
+    const float x = static_cast<float>(position.GetX());
+    const float z = static_cast<float>(position.GetZ());
+    const Vec3 forward = rotation * Vec3::sAxisZ();
+    // Facing +Z with +Y up, the vehicle's right-hand side is -X.
+    const Vec3 right = rotation * -Vec3::sAxisX();
+    const float forwardSpeed = velocity.Dot(forward);
+
+    const float lookAhead = std::max(8.f, std::abs(forwardSpeed) * 1.2f);
+    const float angle = std::atan2(z, x) + lookAhead / radius;
+    const Vec3 toTarget(radius * std::cos(angle) - x, 0.f, radius * std::sin(angle) - z);
+
+    const float localRight = toTarget.Dot(right);
+    const float localForward = toTarget.Dot(forward);
+    const float heading = std::atan2(localRight, localForward);
+
+    VehicleInput input;
+    input.steer = std::clamp(heading * 2.f, -1.f, 1.f);
+
+    // Ease off in tight corrections so the vehicle does not understeer off the line.
+    const float cornerSpeed = targetSpeed * (1.f - 0.5f * std::min(1.f, std::abs(heading)));
+    if (forwardSpeed < cornerSpeed) {
+        input.throttle = 1.f;
+    } else if (forwardSpeed > cornerSpeed + 2.f) {
+        input.brake = true;
+    }
+    return input;
+}
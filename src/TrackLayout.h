@@ -0,0 +1,26 @@
+#pragma once
+
+#include "PhysicsVehicle.h"
+#include "PhysicsWorld.h"
+
+// Dimensions of the ring track drawn by createGround, shared with headless runs
+// so scripted drivers and lap timing follow the same layout.
+namespace Track {
+    constexpr float Inner = 120.f;
+    constexpr float Outer = 170.f;
+    constexpr float CenterLine = 0.5f * (Inner + Outer);
+    // The start line crosses the track on the +X axis; laps are run with
+    // increasing angle around Y, i.e. heading +Z when crossing it.
+    constexpr float StartLineX = Outer - 4.f;
+
+    void createGroundBody(PhysicsWorld& physics);
+
+    // Returns true when the segment from `from` to `to` crosses the start line in
+    // the direction of travel.
+    bool crossesStartLine(const JPH::RVec3& from, const JPH::RVec3& to);
+
+    // Pure-pursuit driver that follows a circle of the given radius around the
+    // track centre at up to `targetSpeed`.
+    VehicleInput followRacingLine(const JPH::RVec3& position, const JPH::Quat& rotation, const JPH::Vec3& velocity,
+                                  float targetSpeed, float radius = CenterLine);
+}
@@ -0,0 +1,240 @@
+#include "TrajectoryPredictor.h"
+
+#include <Jolt/Core/Color.h>
+#include <Jolt/Core/JobSystem.h>
+#include <Jolt/Geometry/AABox.h>
+#include <Jolt/Physics/Body/BodyCreationSettings.h>
+#include <Jolt/Physics/Body/BodyInterface.h>
+#include <Jolt/Physics/Body/BodyLock.h>
+#include <Jolt/Physics/Collision/BroadPhase/BroadPhaseQuery.h>
+#include <Jolt/Physics/Collision/CollisionCollectorImpl.h>
+#include <Jolt/Physics/Collision/ObjectLayer.h>
+
+#include <algorithm>
+#include <chrono>
+
+using namespace JPH;
+
+namespace {
+
+// Only the chassis and the cloned statics live in a scratch world.
+PhysicsWorld::Config scratchWorldConfig() {
+    PhysicsWorld::Config config;
+    config.maxBodies = 256;
+    config.maxBodyPairs = 256;
+    config.maxContactConstraints = 256;
+    config.tempAllocatorBytes = 2 * 1024 * 1024;
+    config.singleThreaded = true;
+    // Rollouts only read the chassis pose.
+    config.contactEventsPerThread = 0;
+    return config;
+}
+
+bool sameBuild(const VehicleSettings& a, const VehicleSettings& b) {
+    return a.mass == b.mass && a.brakeForce == b.brakeForce && a.linearDamping == b.linearDamping
+           && a.angularDamping == b.angularDamping;
+}
+
+} // namespace
+
+struct TrajectoryPredictor::Scratch {
+    std::unique_ptr<PhysicsWorld> world;
+    // Declared after the world so it is destroyed first.
+    std::unique_ptr<PhysicsVehicle> vehicle;
+    std::vector<BodyID> statics;
+    uint64_t staticsVersion = 0;
+};
+
+TrajectoryPredictor::TrajectoryPredictor(PhysicsWorld& world)
+    : TrajectoryPredictor(world, Config()) {}
+
+TrajectoryPredictor::TrajectoryPredictor(PhysicsWorld& world, const Config& config)
+    : world_(world), config_(config) {}
+
+TrajectoryPredictor::~TrajectoryPredictor() = default;
+
+void TrajectoryPredictor::clear() {
+    pool_.clear();
+    statics_.clear();
+    ++staticsVersion_;
+}
+
+void TrajectoryPredictor::gatherStatics(const RVec3& center) {
+    const float r = config_.staticRadius;
+    const Vec3 c(center);
+    const AABox box(c - Vec3(r, r, r), c + Vec3(r, r, r));
+
+    AllHitCollisionCollector<CollideShapeBodyCollector> collector;
+    world_.system().GetBroadPhaseQuery().CollideAABox(box, collector, {}, SpecifiedObjectLayerFilter(PhysicsLayers::Static));
+    std::sort(collector.mHits.begin(), collector.mHits.end());
+
+    // Re-read every body even when the id set is unchanged: a floating-origin
+    // shift moves statics without changing their ids.
+    bool changed = collector.mHits.size() != statics_.size();
+    statics_.resize(collector.mHits.size());
+    const BodyLockInterfaceNoLock& locks = world_.system().GetBodyLockInterfaceNoLock();
+    size_t count = 0;
+    for (const BodyID& id : collector.mHits) {
+        BodyLockRead lock(locks, id);
+        if (!lock.Succeeded()) continue;
+        const Body& body = lock.GetBody();
+        StaticBody& entry = statics_[count++];
+        const RVec3 position = body.GetPosition();
+        const Quat rotation = body.GetRotation();
+        if (entry.source != id || entry.shape != body.GetShape() || entry.position != position || entry.rotation != rotation) {
+            changed = true;
+        }
+        entry.source = id;
+        entry.shape = body.GetShape();
+        entry.position = position;
+        entry.rotation = rotation;
+        entry.friction = body.GetFriction();
+        entry.restitution = body.GetRestitution();
+    }
+    if (count != statics_.size()) {
+        statics_.resize(count);
+        changed = true;
+    }
+    if (changed) ++staticsVersion_;
+}
+
+std::unique_ptr<TrajectoryPredictor::Scratch> TrajectoryPredictor::acquire(const PhysicsVehicle& vehicle) {
+    const auto matches = [&vehicle](const std::unique_ptr<Scratch>& scratch) {
+        return scratch->vehicle && scratch->vehicle->type() == vehicle.type()
+               && sameBuild(scratch->vehicle->buildSettings(), vehicle.buildSettings());
+    };
+
+    auto it = std::find_if(pool_.begin(), pool_.end(), matches);
+    if (it != pool_.end()) {
+        ++stats_.poolHits;
+    } else {
+        ++stats_.poolMisses;
+        // Any pooled world can host a different vehicle; only the vehicle is rebuilt.
+        it = pool_.empty() ? pool_.end() : pool_.end() - 1;
+    }
+
+    std::unique_ptr<Scratch> scratch;
+    if (it != pool_.end()) {
+        scratch = std::move(*it);
+        pool_.erase(it);
+    } else {
+        scratch = std::make_unique<Scratch>();
+        scratch->world = std::make_unique<PhysicsWorld>(scratchWorldConfig());
+        // Rollouts are short and slow-moving enough for one collision step.
+        PhysicsWorld::SubstepSettings substeps;
+        substeps.adaptive = false;
+        substeps.minSteps = 1;
+        substeps.linearCastFastBodies = false;
+        scratch->world->setSubstepSettings(substeps);
+    }
+
+    if (!matches(scratch)) {
+        scratch->vehicle.reset();
+        const VehicleSettings build = vehicle.buildSettings();
+        // The model is never synced, so an empty one is enough.
+        scratch->vehicle = std::make_unique<PhysicsVehicle>(*scratch->world, VehicleModel{}, vehicle.type(),
+                                                            vehicle.position(), &build);
+    }
+    scratch->vehicle->settings() = vehicle.settings();
+    syncStatics(*scratch);
+    return scratch;
+}
+
+void TrajectoryPredictor::syncStatics(Scratch& scratch) {
+    if (scratch.staticsVersion == staticsVersion_ && scratch.statics.size() == statics_.size()) return;
+
+    BodyInterface& bodyInterface = scratch.world->bodyInterface();
+    if (!scratch.statics.empty()) {
+        bodyInterface.RemoveBodies(scratch.statics.data(), static_cast<int>(scratch.statics.size()));
+        bodyInterface.DestroyBodies(scratch.statics.data(), static_cast<int>(scratch.statics.size()));
+        scratch.statics.clear();
+    }
+
+    // Leave room for the chassis.
+    const size_t capacity = scratch.world->config().maxBodies - 1;
+    for (const StaticBody& source : statics_) {
+        if (scratch.statics.size() >= capacity) break;
+        // Shapes are immutable, so the clone shares the live world's shape.
+        BodyCreationSettings settings(source.shape.GetPtr(), source.position, source.rotation, EMotionType::Static,
+                                      PhysicsLayers::Static);
+        settings.mFriction = source.friction;
+        settings.mRestitution = source.restitution;
+        const BodyID id = bodyInterface.CreateAndAddBody(settings, EActivation::DontActivate);
+        if (id.IsInvalid()) break;
+        scratch.statics.push_back(id);
+    }
+    scratch.world->system().OptimizeBroadPhase();
+    scratch.staticsVersion = staticsVersion_;
+}
+
+const std::vector<TrajectoryPredictor::Trajectory>& TrajectoryPredictor::predict(
+    const PhysicsVehicle& vehicle, std::span<const std::vector<VehicleInput>> candidates, int steps) {
+    const auto start = std::chrono::steady_clock::now();
+    stats_.candidates = static_cast<int>(candidates.size());
+    stats_.steps = std::max(steps, 0);
+    stats_.poolHits = 0;
+    stats_.poolMisses = 0;
+
+    trajectories_.resize(candidates.size());
+    for (Trajectory& trajectory : trajectories_) {
+        trajectory.positions.resize(stats_.steps);
+        trajectory.rotations.resize(stats_.steps);
+        trajectory.speeds.resize(stats_.steps);
+    }
+    if (candidates.empty() || steps <= 0) {
+        stats_.wallMs = 0.f;
+        return trajectories_;
+    }
+
+    vehicle.captureState(state_);
+    gatherStatics(state_.position);
+    stats_.staticBodies = static_cast<int>(statics_.size());
+
+    // Scratch worlds are built and filled here; only the rollouts run as jobs.
+    const size_t workers = std::min(candidates.size(), static_cast<size_t>(std::max(config_.maxPooledWorlds, 1)));
+    busy_.clear();
+    for (size_t i = 0; i < workers; ++i) {
+        busy_.push_back(acquire(vehicle));
+    }
+
+    const float dt = config_.dt;
+    auto rollout = [&](Scratch& scratch, size_t candidate) {
+        const std::vector<VehicleInput>& inputs = candidates[candidate];
+        Trajectory& trajectory = trajectories_[candidate];
+        PhysicsVehicle& scratchVehicle = *scratch.vehicle;
+        scratchVehicle.restoreState(state_);
+        for (int step = 0; step < steps; ++step) {
+            const VehicleInput input = inputs.empty() ? VehicleInput{}
+                                                      : inputs[std::min(static_cast<size_t>(step), inputs.size() - 1)];
+            scratchVehicle.applyInput(input);
+            scratch.world->step(dt);
+            trajectory.positions[step] = scratchVehicle.position();
+            trajectory.rotations[step] = scratchVehicle.rotation();
+            trajectory.speeds[step] = scratchVehicle.speed();
+        }
+    };
+
+    JobSystem& jobSystem = world_.jobSystem();
+    JobSystem::Barrier* barrier = jobSystem.CreateBarrier();
+    for (size_t worker = 0; worker < workers; ++worker) {
+        barrier->AddJob(jobSystem.CreateJob("TrajectoryRollout", Color::sOrange, [&, worker] {
+            for (size_t candidate = worker; candidate < candidates.size(); candidate += workers) {
+                rollout(*busy_[worker], candidate);
+            }
+        }));
+    }
+    jobSystem.WaitForJobs(barrier);
+    jobSystem.DestroyBarrier(barrier);
+
+    for (auto& scratch : busy_) {
+        pool_.push_back(std::move(scratch));
+    }
+    busy_.clear();
+    // Shrink after the config lowered the pool size.
+    while (static_cast<int>(pool_.size()) > std::max(config_.maxPooledWorlds, 1)) {
+        pool_.pop_back();
+    }
+
+    stats_.wallMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return trajectories_;
+}
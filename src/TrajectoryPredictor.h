@@ -0,0 +1,84 @@
+#pragma once
+
+#include "PhysicsVehicle.h"
+#include "PhysicsWorld.h"
+
+#include <memory>
+#include <span>
+#include <vector>
+
+// Forward rollouts of one vehicle under several candidate input sequences. The
+// vehicle and the static bodies around it are cloned into small scratch worlds
+// that are kept in a pool, and each candidate is stepped on its own scratch world
+// as one job on the live world's job system. Nothing in the live world moves.
+class TrajectoryPredictor {
+public:
+    struct Config {
+        // Coarser than the live step: predictions trade accuracy for horizon.
+        float dt = 1.f / 30.f;
+        int maxPooledWorlds = 16;
+        // Half extent of the XZ box around the vehicle whose static bodies are cloned.
+        float staticRadius = 60.f;
+    };
+
+    // One sample per step, taken after the step.
+    struct Trajectory {
+        std::vector<JPH::RVec3> positions;
+        std::vector<JPH::Quat> rotations;
+        std::vector<float> speeds;
+    };
+
+    struct Stats {
+        int candidates = 0;
+        int steps = 0;
+        int staticBodies = 0;
+        int poolHits = 0;
+        int poolMisses = 0;
+        float wallMs = 0.f;
+    };
+
+    explicit TrajectoryPredictor(PhysicsWorld& world);
+    TrajectoryPredictor(PhysicsWorld& world, const Config& config);
+    ~TrajectoryPredictor();
+
+    // Rolls `vehicle` forward `steps` times per candidate. A sequence shorter than
+    // `steps` holds its last input; an empty one coasts. Must not overlap a
+    // physics step of the live world. The result is valid until the next call.
+    const std::vector<Trajectory>& predict(const PhysicsVehicle& vehicle,
+                                           std::span<const std::vector<VehicleInput>> candidates, int steps);
+
+    // Drops every pooled scratch world, e.g. after the live world is rebuilt.
+    void clear();
+
+    void setConfig(const Config& config) { config_ = config; }
+    const Config& config() const { return config_; }
+    const Stats& stats() const { return stats_; }
+
+private:
+    struct StaticBody {
+        JPH::BodyID source;
+        JPH::RefConst<JPH::Shape> shape;
+        JPH::RVec3 position;
+        JPH::Quat rotation;
+        float friction = 0.f;
+        float restitution = 0.f;
+    };
+
+    struct Scratch;
+
+    void gatherStatics(const JPH::RVec3& center);
+    std::unique_ptr<Scratch> acquire(const PhysicsVehicle& vehicle);
+    void syncStatics(Scratch& scratch);
+
+    PhysicsWorld& world_;
+    Config config_;
+    std::vector<StaticBody> statics_;
+    // Bumped whenever the gathered static set changes, so scratch worlds only
+    // rebuild their clones when they are stale.
+    uint64_t staticsVersion_ = 0;
+    std::vector<std::unique_ptr<Scratch>> pool_;
+    std::vector<std::unique_ptr<Scratch>> busy_;
+    std::vector<Trajectory> trajectories_;
+    VehicleState state_;
+    Stats stats_;
+};
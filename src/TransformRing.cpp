@@ -0,0 +1,230 @@
+#include "TransformRing.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <new>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace JPH;
+
+namespace {
+
+constexpr char Magic[8] = {'V', 'D', 'R', 'I', 'N', 'G', '\0', '\0'};
+constexpr size_t SlotAlignment = 64;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "the seqlock is shared between processes");
+
+struct alignas(SlotAlignment) Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t slots;
+    uint32_t maxVehicles;
+    uint32_t vehicleBytes;
+    uint64_t slotBytes;
+    std::atomic<uint64_t> published;
+};
+
+size_t slotBytes(uint32_t maxVehicles) {
+    const size_t bytes = sizeof(TransformRing::Frame) + size_t(maxVehicles) * sizeof(TransformRing::Vehicle);
+    return (bytes + SlotAlignment - 1) / SlotAlignment * SlotAlignment;
+}
+
+// shm_open wants a single leading slash.
+std::string shmName(const std::string& name) {
+    return name.empty() || name[0] != '/' ? "/" + name : name;
+}
+
+void store(TransformRing::Transform& out, const Vec3& position, const Quat& rotation) {
+    out.position[0] = position.GetX();
+    out.position[1] = position.GetY();
+    out.position[2] = position.GetZ();
+    out.rotation[0] = rotation.GetX();
+    out.rotation[1] = rotation.GetY();
+    out.rotation[2] = rotation.GetZ();
+    out.rotation[3] = rotation.GetW();
+}
+
+} // namespace
+
+#ifdef _WIN32
+
+std::unique_ptr<TransformRing> TransformRing::create(const std::string&, const Config&) {
+    std::fprintf(stderr, "error: transform rings need POSIX shared memory and are not available on this platform\n");
+    return nullptr;
+}
+
+std::unique_ptr<TransformRing> TransformRing::attach(const std::string& name) {
+    return create(name, Config{});
+}
+
+TransformRing::~TransformRing() = default;
+
+#else
+
+std::unique_ptr<TransformRing> TransformRing::create(const std::string& name, const Config& config) {
+    const std::string path = shmName(name);
+    const uint32_t slots = std::max(config.slots, 2u);
+    const size_t bytesPerSlot = slotBytes(config.maxVehicles);
+    const size_t size = sizeof(Header) + slots * bytesPerSlot;
+
+    // Never take over an existing ring: another simulation may still be publishing
+    // into it, and its readers would see it truncated under them.
+    const int fd = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        if (errno == EEXIST) {
+            std::fprintf(stderr, "error: transform ring '%s' already exists; stop its writer or remove /dev/shm%s\n",
+                         path.c_str(), path.c_str());
+        } else {
+            std::fprintf(stderr, "error: could not create transform ring '%s': %s\n", path.c_str(), std::strerror(errno));
+        }
+        return nullptr;
+    }
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        ::close(fd);
+        shm_unlink(path.c_str());
+        return nullptr;
+    }
+    void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        shm_unlink(path.c_str());
+        return nullptr;
+    }
+
+    // New shared memory is zeroed, so every slot starts at an even sequence.
+    auto* header = new (mapping) Header{};
+    std::memcpy(header->magic, Magic, sizeof(Magic));
+    header->version = Version;
+    header->slots = slots;
+    header->maxVehicles = config.maxVehicles;
+    header->vehicleBytes = sizeof(Vehicle);
+    header->slotBytes = bytesPerSlot;
+
+    std::unique_ptr<TransformRing> ring(new TransformRing());
+    ring->name_ = path;
+    ring->data_ = static_cast<uint8_t*>(mapping);
+    ring->size_ = size;
+    ring->slotBytes_ = bytesPerSlot;
+    ring->slots_ = slots;
+    ring->maxVehicles_ = config.maxVehicles;
+    ring->writable_ = true;
+    return ring;
+}
+
+std::unique_ptr<TransformRing> TransformRing::attach(const std::string& name) {
+    const std::string path = shmName(name);
+    const int fd = shm_open(path.c_str(), O_RDONLY, 0);
+    if (fd < 0) return nullptr;
+    struct stat info {};
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(Header))) {
+        ::close(fd);
+        return nullptr;
+    }
+    const auto size = static_cast<size_t>(info.st_size);
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) return nullptr;
+
+    std::unique_ptr<TransformRing> ring(new TransformRing());
+    ring->name_ = path;
+    ring->data_ = static_cast<uint8_t*>(mapping);
+    ring->size_ = size;
+
+    // Reject rings from another build before trusting the layout.
+    const auto* header = reinterpret_cast<const Header*>(ring->data_);
+    if (std::memcmp(header->magic, Magic, sizeof(Magic)) != 0 || header->version != Version ||
+        header->vehicleBytes != sizeof(Vehicle) || header->slots == 0 || header->slotBytes != slotBytes(header->maxVehicles) ||
+        sizeof(Header) + header->slots * header->slotBytes > size) {
+        return nullptr;
+    }
+    ring->slotBytes_ = header->slotBytes;
+    ring->slots_ = header->slots;
+    ring->maxVehicles_ = header->maxVehicles;
+    return ring;
+}
+
+TransformRing::~TransformRing() {
+    if (!data_) return;
+    munmap(data_, size_);
+    if (writable_) {
+        shm_unlink(name_.c_str());
+    }
+}
+
+#endif
+
+TransformRing::Frame& TransformRing::slot(uint64_t frame) const {
+    return *reinterpret_cast<Frame*>(data_ + sizeof(Header) + (frame % slots_) * slotBytes_);
+}
+
+uint64_t TransformRing::published() const {
+    return reinterpret_cast<const Header*>(data_)->published.load(std::memory_order_acquire);
+}
+
+void TransformRing::publish(const VehicleRegistry& vehicles, uint64_t tick, double simTime, double originX, double originZ,
+                            int activeVehicle) {
+    if (!writable_) return;
+    auto* header = reinterpret_cast<Header*>(data_);
+    const uint64_t index = header->published.load(std::memory_order_relaxed);
+    Frame& frame = slot(index);
+
+    const uint64_t sequence = frame.sequence.load(std::memory_order_relaxed);
+    frame.sequence.store(sequence + 1, std::memory_order_relaxed);
+    // Keeps the record writes below from becoming visible before the odd sequence.
+    std::atomic_thread_fence(std::memory_order_release);
+
+    frame.index = index;
+    frame.tick = tick;
+    frame.simTime = simTime;
+    frame.originX = originX;
+    frame.originZ = originZ;
+    frame.activeSlot = activeVehicle >= 0 && activeVehicle < static_cast<int>(vehicles.size())
+                           ? vehicles.handleAt(static_cast<size_t>(activeVehicle)).index
+                           : UINT32_MAX;
+
+    Vehicle* records = frame.vehicles();
+    uint32_t count = 0;
+    for (size_t i = 0; i < vehicles.size(); ++i) {
+        const VehicleHandle handle = vehicles.handleAt(i);
+        if (handle.index >= maxVehicles_) continue;
+        const PhysicsVehicle& vehicle = vehicles[i];
+        Vehicle& record = records[count++];
+        record.slot = handle.index;
+        record.generation = handle.generation;
+        record.type = static_cast<uint8_t>(vehicle.type());
+        store(record.body, Vec3(vehicle.position()), vehicle.rotation());
+        const size_t wheels = std::min<size_t>(vehicle.wheelCount(), MaxWheels);
+        record.wheelCount = static_cast<uint8_t>(wheels);
+        for (size_t w = 0; w < wheels; ++w) {
+            const Mat44 transform = vehicle.wheelLocalTransform(w);
+            store(record.wheels[w], transform.GetTranslation(), transform.GetQuaternion());
+        }
+    }
+    frame.vehicleCount = count;
+
+    frame.sequence.store(sequence + 2, std::memory_order_release);
+    header->published.store(index + 1, std::memory_order_release);
+}
+
+const TransformRing::Frame* TransformRing::latest(uint64_t& sequence) const {
+    const uint64_t published = this->published();
+    if (published == 0) return nullptr;
+    const Frame& frame = slot(published - 1);
+    sequence = frame.sequence.load(std::memory_order_acquire);
+    if (sequence & 1) return nullptr;
+    return &frame;
+}
+
+bool TransformRing::validate(const Frame& frame, uint64_t sequence) const {
+    // Orders the record reads before the second sequence load.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return frame.sequence.load(std::memory_order_relaxed) == sequence;
+}
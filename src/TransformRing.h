@@ -0,0 +1,101 @@
+#pragma once
+
+#include "VehicleRegistry.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Per-step vehicle transforms in a named shared-memory ring, so viewer and
+// analysis processes can follow the simulation at their own rate. Records hold
+// what syncVisual applies to a model: the body pose plus wheel poses relative
+// to the body.
+//
+// The writer fills slots round-robin and guards each with a seqlock: the slot's
+// sequence is odd while it is written. Readers map the ring read-only, copy the
+// newest slot out and check the sequence afterwards before using the copy; the
+// writer never waits for them. POSIX only; create() and attach() return null elsewhere.
+class TransformRing {
+public:
+    static constexpr uint32_t Version = 1;
+    static constexpr int MaxWheels = 18;
+
+    struct Config {
+        uint32_t slots = 4;
+        uint32_t maxVehicles = 8192;
+    };
+
+    struct Transform {
+        float position[3];
+        float rotation[4];
+    };
+
+    struct Vehicle {
+        // Registry slot and generation; a new generation is a different vehicle.
+        uint32_t slot;
+        uint32_t generation;
+        uint8_t type;
+        uint8_t wheelCount;
+        Transform body;
+        Transform wheels[MaxWheels];
+    };
+
+    struct Frame {
+        std::atomic<uint64_t> sequence;
+        // Position in the stream of published frames, from 0.
+        uint64_t index;
+        uint64_t tick;
+        double simTime;
+        // Floating-origin offset; positions are relative to it.
+        double originX;
+        double originZ;
+        uint32_t vehicleCount;
+        // Registry slot of the driven vehicle, or UINT32_MAX.
+        uint32_t activeSlot;
+
+        // Records follow the frame header directly.
+        const Vehicle* vehicles() const { return reinterpret_cast<const Vehicle*>(this + 1); }
+        Vehicle* vehicles() { return reinterpret_cast<Vehicle*>(this + 1); }
+    };
+
+    // Creates the ring for writing. Fails with an error when a ring of that name
+    // already exists, e.g. left behind by a simulation that crashed.
+    static std::unique_ptr<TransformRing> create(const std::string& name, const Config& config = Config{});
+    // Maps an existing ring read-only.
+    static std::unique_ptr<TransformRing> attach(const std::string& name);
+    // The writer also removes the name.
+    ~TransformRing();
+
+    TransformRing(const TransformRing&) = delete;
+    TransformRing& operator=(const TransformRing&) = delete;
+
+    // Writes the registry's current transforms as the next frame. Vehicles in
+    // registry slots beyond maxVehicles() are left out.
+    void publish(const VehicleRegistry& vehicles, uint64_t tick, double simTime, double originX, double originZ,
+                 int activeVehicle);
+
+    // Newest completed frame, or null before the first publish or when the writer
+    // has lapped the ring onto it. Its contents are only consistent if validate()
+    // still returns true after they were read.
+    const Frame* latest(uint64_t& sequence) const;
+    bool validate(const Frame& frame, uint64_t sequence) const;
+
+    // Frames published so far.
+    uint64_t published() const;
+    uint32_t maxVehicles() const { return maxVehicles_; }
+    const std::string& name() const { return name_; }
+    bool writable() const { return writable_; }
+
+private:
+    TransformRing() = default;
+    Frame& slot(uint64_t frame) const;
+
+    std::string name_;
+    uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    size_t slotBytes_ = 0;
+    uint32_t slots_ = 0;
+    uint32_t maxVehicles_ = 0;
+    bool writable_ = false;
+};
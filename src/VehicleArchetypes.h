@@ -0,0 +1,75 @@
+#pragma once
+
+#include "VehicleFactory.h"
+
+#include <array>
+#include <cstddef>
+
+enum class Drivetrain {
+    Wheeled,
+    Tracked,
+    Motorcycle
+};
+
+// Per-type constants shared by body construction, spawn placement and default
+// tuning. Chassis extents match the visual bodies built by VehicleFactory.
+struct VehicleArchetypeParams {
+    VehicleType type;
+    Drivetrain drivetrain;
+    float halfX, halfY, halfZ;
+    float wheelRadius;
+    float wheelWidth;
+    // Default VehicleSettings tuning.
+    float mass;
+    float engineForce;
+    float maxSpeed;
+    float steerTorque;
+
+    // Wheel attachment height relative to the centre of mass.
+    constexpr float wheelBaseY() const { return -0.9f * halfY; }
+    // Matches the Jolt demo: the motorcycle sits its COM at the bottom of the box.
+    constexpr float comOffset() const { return drivetrain == Drivetrain::Motorcycle ? -halfY : wheelBaseY(); }
+    // Body height that leaves the suspension near rest on flat ground.
+    constexpr float spawnHeight() const { return wheelRadius - wheelBaseY() + 0.4f; }
+};
+
+inline constexpr std::array<VehicleArchetypeParams, 5> vehicleArchetypes{{
+    {VehicleType::Kart, Drivetrain::Wheeled, 0.6f, 0.2f, 1.1f, 0.35f, 0.25f, 450.f, 4500.f, 22.f, 1200.f},
+    {VehicleType::Sedan, Drivetrain::Wheeled, 0.8f, 0.3f, 1.8f, 0.45f, 0.3f, 1100.f, 8000.f, 26.f, 1800.f},
+    {VehicleType::Truck, Drivetrain::Wheeled, 1.0f, 0.4f, 2.6f, 0.55f, 0.35f, 2600.f, 12000.f, 18.f, 1400.f},
+    {VehicleType::Tank, Drivetrain::Tracked, 1.7f, 0.5f, 3.2f, 0.3f, 0.1f, 4000.f, 15000.f, 14.f, 0.f},
+    {VehicleType::Motorcycle, Drivetrain::Motorcycle, 0.25f, 0.3f, 0.8f, 0.31f, 0.05f, 240.f, 3500.f, 28.f, 1000.f},
+}};
+
+constexpr const VehicleArchetypeParams& archetypeParams(VehicleType type) {
+    return vehicleArchetypes[static_cast<size_t>(type)];
+}
+
+static_assert([] {
+    for (size_t i = 0; i < vehicleArchetypes.size(); ++i) {
+        if (static_cast<size_t>(vehicleArchetypes[i].type) != i) return false;
+    }
+    return true;
+}(), "vehicleArchetypes must be ordered like VehicleType");
+
+// Compile-time handle for one vehicle type, used to instantiate type-specialized kernels.
+template<VehicleType T>
+struct VehicleArchetype {
+    static constexpr VehicleType type = T;
+    static constexpr const VehicleArchetypeParams& params = vehicleArchetypes[static_cast<size_t>(T)];
+    static constexpr Drivetrain drivetrain = params.drivetrain;
+};
+
+// Calls `f(VehicleArchetype<T>{})` for the runtime type. Hot paths call this once
+// per batch of same-type vehicles so the per-vehicle loop has no type branches.
+template<typename F>
+decltype(auto) withArchetype(VehicleType type, F&& f) {
+    switch (type) {
+        case VehicleType::Sedan: return f(VehicleArchetype<VehicleType::Sedan>{});
+        case VehicleType::Truck: return f(VehicleArchetype<VehicleType::Truck>{});
+        case VehicleType::Tank: return f(VehicleArchetype<VehicleType::Tank>{});
+        case VehicleType::Motorcycle: return f(VehicleArchetype<VehicleType::Motorcycle>{});
+        case VehicleType::Kart:
+        default: return f(VehicleArchetype<VehicleType::Kart>{});
+    }
+}
@@ -1,4 +1,7 @@
 #include "VehicleFactory.h"
+#include "StartupCache.h"
+
+#include <algorithm>
 
 using namespace threepp;
 
@@ -214,23 +217,161 @@ VehicleModel buildMotorcycle() {
     return {group, wheels, steeringWheels};
 }
 
+// Bakes every part of a full-detail model into one vertex-coloured mesh using the
+// parts' local transforms.
+void buildLodAssets(VehicleLodAssets::Set& assets, const VehicleModel& model) {
+    std::vector<float> positions;
+    std::vector<float> normals;
+    std::vector<float> colors;
+    std::vector<unsigned int> indices;
+    Color proxyColor = Color::gray;
+    bool proxyColorSet = false;
+
+    for (auto* child : model.detail->children) {
+        auto* mesh = dynamic_cast<Mesh*>(child);
+        if (!mesh) continue;
+
+        auto geometry = mesh->geometry()->clone();
+        Matrix4 transform;
+        transform.compose(mesh->position, mesh->quaternion, mesh->scale);
+        geometry->applyMatrix4(transform);
+
+        Color color = Color::gray;
+        if (auto* withColor = dynamic_cast<MaterialWithColor*>(mesh->material().get())) {
+            color = withColor->color;
+        }
+        if (!proxyColorSet) {
+            proxyColor = color;
+            proxyColorSet = true;
+        }
+
+        const auto& partPositions = geometry->getAttribute<float>("position")->array();
+        const auto& partNormals = geometry->getAttribute<float>("normal")->array();
+        const auto baseVertex = static_cast<unsigned int>(positions.size() / 3);
+        positions.insert(positions.end(), partPositions.begin(), partPositions.end());
+        normals.insert(normals.end(), partNormals.begin(), partNormals.end());
+        for (size_t i = 0; i < partPositions.size() / 3; ++i) {
+            colors.insert(colors.end(), {color.r, color.g, color.b});
+        }
+
+        if (auto* index = geometry->getIndex()) {
+            for (auto i : index->array()) {
+                indices.push_back(baseVertex + i);
+            }
+        } else {
+            for (unsigned int i = 0; i < partPositions.size() / 3; ++i) {
+                indices.push_back(baseVertex + i);
+            }
+        }
+    }
+
+    assets.mergedGeometry = BufferGeometry::create();
+    assets.mergedGeometry->setAttribute("position", FloatBufferAttribute::create(positions, 3));
+    assets.mergedGeometry->setAttribute("normal", FloatBufferAttribute::create(normals, 3));
+    assets.mergedGeometry->setAttribute("color", FloatBufferAttribute::create(colors, 3));
+    assets.mergedGeometry->setIndex(indices);
+    assets.mergedGeometry->computeBoundingSphere();
+    assets.mergedGeometry->computeBoundingBox();
+    assets.mergedMaterial = MeshPhongMaterial::create();
+    assets.mergedMaterial->vertexColors = true;
+
+    const Box3& bounds = *assets.mergedGeometry->boundingBox;
+    Vector3 size;
+    bounds.getSize(size);
+    bounds.getCenter(assets.proxyCenter);
+    assets.proxyGeometry = BoxGeometry::create(size.x, size.y, size.z);
+    assets.proxyMaterial = MeshLambertMaterial::create();
+    assets.proxyMaterial->color = proxyColor;
+}
+
+// Wrap the parts so a whole LOD level can be toggled with one visibility flag.
+void wrapDetail(VehicleModel& model, VehicleType type) {
+    model.detail = model.group;
+    model.group = Group::create();
+    model.group->add(model.detail);
+    model.type = type;
+}
+
+// Wheel meshes carry their index in the tag, with bit 8 set on steering wheels.
+void collectWheels(std::vector<std::pair<int32_t, std::shared_ptr<Mesh>>>& wheels, VehicleModel& model) {
+    std::sort(wheels.begin(), wheels.end(), [](const auto& a, const auto& b) { return (a.first & 0xff) < (b.first & 0xff); });
+    for (const auto& [tag, mesh] : wheels) {
+        model.wheels.push_back(mesh);
+        if (tag & 0x100) model.steeringWheels.push_back(mesh);
+    }
+}
+
+bool decodeModel(const StartupCache& cache, VehicleType type, VehicleModel& model) {
+    const auto data = cache.find(vehicleModelKey(type), VehicleFactory::ModelRevision);
+    if (data.empty()) return false;
+
+    std::vector<std::pair<int32_t, std::shared_ptr<Mesh>>> wheels;
+    auto detail = decodeMeshes(data, [&](const std::shared_ptr<Mesh>& mesh, int32_t tag) {
+        if (tag >= 0) wheels.emplace_back(tag, mesh);
+    });
+    if (!detail) return false;
+
+    collectWheels(wheels, model);
+    model.group = detail;
+    return true;
+}
+
 } // namespace
 
 VehicleModel VehicleFactory::create(VehicleType type) {
+    if (auto cache = StartupCache::active()) {
+        VehicleModel model;
+        if (decodeModel(*cache, type, model)) {
+            wrapDetail(model, type);
+            return model;
+        }
+    }
+    return createProcedural(type);
+}
+
+bool VehicleFactory::decodeVehicleMeshes(VehicleType type, std::vector<MeshBuffers>& meshes) {
+    const auto cache = StartupCache::active();
+    return cache && decodeMeshBuffers(cache->find(vehicleModelKey(type), ModelRevision), meshes) && !meshes.empty();
+}
+
+VehicleModel VehicleFactory::create(VehicleType type, const SharedMeshes& meshes) {
+    if (meshes.empty()) return create(type);
+
+    VehicleModel model;
+    std::vector<std::pair<int32_t, std::shared_ptr<Mesh>>> wheels;
+    model.group = meshes.instantiate([&](const std::shared_ptr<Mesh>& mesh, int32_t tag) {
+        if (tag >= 0) wheels.emplace_back(tag, mesh);
+    });
+    collectWheels(wheels, model);
+    wrapDetail(model, type);
+    return model;
+}
+
+VehicleModel VehicleFactory::createProcedural(VehicleType type) {
+    VehicleModel model;
     switch (type) {
         case VehicleType::Kart:
-            return createKart();
+            model = createKart();
+            break;
         case VehicleType::Sedan:
-            return createSedan();
+            model = createSedan();
+            break;
         case VehicleType::Truck:
-            return createTruck();
+            model = createTruck();
+            break;
         case VehicleType::Tank:
-            return createTank();
+            model = createTank();
+            break;
         case VehicleType::Motorcycle:
-            return createMotorcycle();
+            model = createMotorcycle();
+            break;
         default:
-            return createKart();
+            model = createKart();
+            break;
     }
+
+    wrapDetail(model, type);
+    return model;
 }
 
 VehicleModel VehicleFactory::createKart() {
@@ -252,3 +393,77 @@ VehicleModel VehicleFactory::createTank() {
 VehicleModel VehicleFactory::createMotorcycle() {
     return buildMotorcycle();
 }
+
+const VehicleLodAssets::Set& VehicleLodAssets::get(VehicleType type) {
+    Set& set = sets_[static_cast<size_t>(type)];
+    if (!set.mergedGeometry) {
+        // The procedural model has its wheels at their rest positions, unlike a
+        // live model whose wheels follow the suspension.
+        buildLodAssets(set, VehicleFactory::createProcedural(type));
+    }
+    return set;
+}
+
+VehicleLodDistances VehicleFactory::lodDistances(VehicleType type) {
+    switch (type) {
+        case VehicleType::Kart:
+            return {40.f, 90.f};
+        case VehicleType::Sedan:
+            return {50.f, 110.f};
+        case VehicleType::Truck:
+            return {70.f, 150.f};
+        case VehicleType::Tank:
+            return {80.f, 170.f};
+        case VehicleType::Motorcycle:
+            return {35.f, 80.f};
+        default:
+            return {50.f, 110.f};
+    }
+}
+
+VehicleLod VehicleFactory::selectLod(const VehicleModel& model, float distance) {
+    // Switch back only once the camera is clearly inside the nearer band, so a
+    // vehicle sitting on a threshold does not flicker between levels.
+    const float hysteresis = 0.9f;
+    const VehicleLodDistances d = lodDistances(model.type);
+    switch (model.lod) {
+        case VehicleLod::Full:
+            if (distance > d.proxy) return VehicleLod::Proxy;
+            if (distance > d.merged) return VehicleLod::Merged;
+            return VehicleLod::Full;
+        case VehicleLod::Merged:
+            if (distance > d.proxy) return VehicleLod::Proxy;
+            if (distance < d.merged * hysteresis) return VehicleLod::Full;
+            return VehicleLod::Merged;
+        case VehicleLod::Proxy:
+        default:
+            if (distance < d.merged * hysteresis) return VehicleLod::Full;
+            if (distance < d.proxy * hysteresis) return VehicleLod::Merged;
+            return VehicleLod::Proxy;
+    }
+}
+
+void VehicleFactory::setLod(VehicleModel& model, VehicleLod lod, VehicleLodAssets& assets) {
+    if (model.lod == lod || !model.detail) return;
+
+    if (lod != VehicleLod::Full && !model.merged) {
+        const VehicleLodAssets::Set& set = assets.get(model.type);
+        model.merged = Mesh::create(set.mergedGeometry, set.mergedMaterial);
+        model.merged->castShadow = true;
+        model.merged->receiveShadow = true;
+        model.group->add(model.merged);
+
+        // Far away vehicles only need a silhouette; dropping them from the shadow
+        // pass is where most of the saving comes from.
+        model.proxy = Mesh::create(set.proxyGeometry, set.proxyMaterial);
+        model.proxy->position.copy(set.proxyCenter);
+        model.proxy->castShadow = false;
+        model.proxy->receiveShadow = false;
+        model.group->add(model.proxy);
+    }
+
+    model.detail->visible = lod == VehicleLod::Full;
+    if (model.merged) model.merged->visible = lod == VehicleLod::Merged;
+    if (model.proxy) model.proxy->visible = lod == VehicleLod::Proxy;
+    model.lod = lod;
+}
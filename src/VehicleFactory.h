@@ -1,8 +1,13 @@
 #pragma once
 
+#include "MeshBuffers.h"
 #include "threepp/threepp.hpp"
+#include <array>
+#include <cstdint>
 #include <vector>
 
+class SharedMeshes;
+
 enum class VehicleType {
     Kart,
     Sedan,
@@ -11,18 +16,71 @@ enum class VehicleType {
     Motorcycle
 };
 
+enum class VehicleLod {
+    Full,
+    Merged,
+    Proxy
+};
+
+struct VehicleLodDistances {
+    float merged;
+    float proxy;
+};
+
 struct VehicleModel {
     std::shared_ptr<threepp::Group> group;
     std::vector<std::shared_ptr<threepp::Mesh>> wheels;
     std::vector<std::shared_ptr<threepp::Mesh>> steeringWheels;
+    // Full-detail parts live under `detail`; the merged mesh and box proxy are
+    // created on first use and share per-type geometry from VehicleLodAssets.
+    std::shared_ptr<threepp::Group> detail;
+    std::shared_ptr<threepp::Mesh> merged;
+    std::shared_ptr<threepp::Mesh> proxy;
+    VehicleType type = VehicleType::Kart;
+    VehicleLod lod = VehicleLod::Full;
+};
+
+// Merged meshes and box proxies shared by every vehicle of a type. Each type is
+// baked once from its procedural model at rest, so the result does not depend on
+// which live vehicle first needed it. Owned by the scene, so the geometry is
+// released while the renderer still exists.
+class VehicleLodAssets {
+public:
+    struct Set {
+        std::shared_ptr<threepp::BufferGeometry> mergedGeometry;
+        std::shared_ptr<threepp::MeshPhongMaterial> mergedMaterial;
+        std::shared_ptr<threepp::BufferGeometry> proxyGeometry;
+        std::shared_ptr<threepp::MeshLambertMaterial> proxyMaterial;
+        threepp::Vector3 proxyCenter;
+    };
+
+    const Set& get(VehicleType type);
+
+private:
+    std::array<Set, 5> sets_;
 };
 
 class VehicleFactory {
 public:
+    // Bump when the procedural models change, so baked startup caches are rebuilt.
+    static constexpr uint32_t ModelRevision = 1;
+
+    // Decodes the model from the active StartupCache when there is one.
     static VehicleModel create(VehicleType type);
+    // Builds the model around geometry shared with every other model created from
+    // the same `meshes`; falls back to create(type) when `meshes` is empty.
+    static VehicleModel create(VehicleType type, const SharedMeshes& meshes);
+    // Decodes the cached model of `type` into plain buffers. Touches no threepp
+    // objects, so it is safe on worker threads. False without an active cache.
+    static bool decodeVehicleMeshes(VehicleType type, std::vector<MeshBuffers>& meshes);
+    static VehicleModel createProcedural(VehicleType type);
     static VehicleModel createKart();
     static VehicleModel createSedan();
     static VehicleModel createTruck();
     static VehicleModel createTank();
     static VehicleModel createMotorcycle();
+
+    static VehicleLodDistances lodDistances(VehicleType type);
+    static VehicleLod selectLod(const VehicleModel& model, float distance);
+    static void setLod(VehicleModel& model, VehicleLod lod, VehicleLodAssets& assets);
 };
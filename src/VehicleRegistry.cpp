@@ -0,0 +1,209 @@
+#include "VehicleRegistry.h"
+
+#include <algorithm>
+
+using namespace JPH;
+
+namespace {
+
+// Settings that are baked into the body and wheels at construction.
+bool sameBuild(const VehicleSettings& a, const VehicleSettings& b) {
+    return a.mass == b.mass && a.brakeForce == b.brakeForce && a.linearDamping == b.linearDamping &&
+           a.angularDamping == b.angularDamping;
+}
+
+} // namespace
+
+VehicleRegistry::VehicleRegistry(PhysicsWorld& world)
+    : world_(world) {}
+
+VehicleRegistry::~VehicleRegistry() {
+    clear();
+    clearPool();
+}
+
+VehicleHandle VehicleRegistry::spawn(VehicleType type, const RVec3& position, const VehicleSettings* overrides) {
+    const VehicleSettings settings = overrides ? *overrides : PhysicsVehicle::defaultSettings(type);
+    auto& pool = pools_[static_cast<int>(type)];
+    auto it = std::find_if(pool.rbegin(), pool.rend(), [&](const auto& vehicle) { return sameBuild(vehicle->buildSettings(), settings); });
+    if (it == pool.rend()) {
+        ++poolStats_.misses;
+        return spawn(VehicleFactory::create(type), type, position, &settings);
+    }
+
+    ++poolStats_.hits;
+    std::unique_ptr<PhysicsVehicle> vehicle = std::move(*it);
+    pool.erase(std::next(it).base());
+    vehicle->settings() = settings;
+    vehicle->addToWorld(position);
+    return insert(std::move(vehicle));
+}
+
+VehicleHandle VehicleRegistry::spawn(VehicleModel model, VehicleType type, const RVec3& position, const VehicleSettings* overrides) {
+    return insert(std::make_unique<PhysicsVehicle>(world_, std::move(model), type, position, overrides));
+}
+
+void VehicleRegistry::spawnBatch(std::span<const VehiclePlacement> placements, std::span<VehicleModel> models,
+                                 std::vector<VehicleHandle>& handles) {
+    handles.clear();
+    handles.reserve(placements.size());
+    std::vector<PhysicsVehicle*> batch;
+    std::vector<RVec3> positions;
+    std::vector<Quat> rotations;
+    batch.reserve(placements.size());
+    positions.reserve(placements.size());
+    rotations.reserve(placements.size());
+
+    for (size_t i = 0; i < placements.size(); ++i) {
+        const VehiclePlacement& placement = placements[i];
+        std::unique_ptr<PhysicsVehicle> vehicle;
+        if (models.empty()) {
+            const VehicleSettings settings = PhysicsVehicle::defaultSettings(placement.type);
+            auto& pool = pools_[static_cast<int>(placement.type)];
+            auto it = std::find_if(pool.rbegin(), pool.rend(), [&](const auto& pooled) { return sameBuild(pooled->buildSettings(), settings); });
+            if (it != pool.rend()) {
+                ++poolStats_.hits;
+                vehicle = std::move(*it);
+                pool.erase(std::next(it).base());
+                vehicle->settings() = settings;
+            } else {
+                ++poolStats_.misses;
+                vehicle = std::make_unique<PhysicsVehicle>(world_, VehicleFactory::create(placement.type), placement.type,
+                                                           placement.position, nullptr, false);
+            }
+        } else {
+            vehicle = std::make_unique<PhysicsVehicle>(world_, std::move(models[i]), placement.type, placement.position,
+                                                       nullptr, false);
+        }
+        batch.push_back(vehicle.get());
+        positions.push_back(placement.position);
+        rotations.push_back(placement.rotation);
+        handles.push_back(insert(std::move(vehicle)));
+    }
+
+    PhysicsVehicle::addToWorldBatch(batch, positions, rotations);
+}
+
+VehicleHandle VehicleRegistry::insert(std::unique_ptr<PhysicsVehicle> vehicle) {
+    uint32_t index = freeList_;
+    if (index != VehicleHandle::InvalidIndex) {
+        freeList_ = slots_[index].data;
+    } else {
+        index = static_cast<uint32_t>(slots_.size());
+        slots_.emplace_back();
+    }
+
+    Slot& slot = slots_[index];
+    slot.alive = true;
+    slot.data = static_cast<uint32_t>(vehicles_.size());
+
+    const VehicleHandle handle{index, slot.generation};
+    vehicles_.push_back(std::move(vehicle));
+    handles_.push_back(handle);
+    batchesDirty_ = true;
+    return handle;
+}
+
+bool VehicleRegistry::despawn(VehicleHandle handle) {
+    if (!contains(handle)) return false;
+
+    Slot& slot = slots_[handle.index];
+    const uint32_t dense = slot.data;
+    const uint32_t last = static_cast<uint32_t>(vehicles_.size() - 1);
+
+    std::unique_ptr<PhysicsVehicle> vehicle = std::move(vehicles_[dense]);
+    vehicle->removeFromWorld();
+    auto& pool = pools_[static_cast<int>(vehicle->type())];
+    if (pool.size() < poolCapacity_) {
+        pool.push_back(std::move(vehicle));
+    } else {
+        ++poolStats_.evicted;
+    }
+    vehicle.reset();
+
+    if (dense != last) {
+        vehicles_[dense] = std::move(vehicles_[last]);
+        handles_[dense] = handles_[last];
+        slots_[handles_[dense].index].data = dense;
+    }
+    vehicles_.pop_back();
+    handles_.pop_back();
+
+    batchesDirty_ = true;
+    slot.alive = false;
+    ++slot.generation;
+    slot.data = freeList_;
+    freeList_ = handle.index;
+    return true;
+}
+
+void VehicleRegistry::clear() {
+    while (!handles_.empty()) {
+        despawn(handles_.back());
+    }
+}
+
+void VehicleRegistry::applyInputs(std::span<const VehicleInput> inputs) {
+    if (batchesDirty_) {
+        rebuildTypeBatches();
+    }
+    for (int type = 0; type < TypeCount; ++type) {
+        const auto& indices = typeIndices_[type];
+        if (indices.empty()) continue;
+
+        batchInputs_.resize(indices.size());
+        for (size_t i = 0; i < indices.size(); ++i) {
+            batchInputs_[i] = inputs[indices[i]];
+        }
+        PhysicsVehicle::applyInputBatch(static_cast<VehicleType>(type), typeVehicles_[type], batchInputs_);
+    }
+}
+
+void VehicleRegistry::rebuildTypeBatches() {
+    for (int type = 0; type < TypeCount; ++type) {
+        typeVehicles_[type].clear();
+        typeIndices_[type].clear();
+    }
+    for (uint32_t i = 0; i < vehicles_.size(); ++i) {
+        const int type = static_cast<int>(vehicles_[i]->type());
+        typeVehicles_[type].push_back(vehicles_[i].get());
+        typeIndices_[type].push_back(i);
+    }
+    batchesDirty_ = false;
+}
+
+void VehicleRegistry::setPoolCapacity(size_t perType) {
+    poolCapacity_ = perType;
+    for (auto& pool : pools_) {
+        if (pool.size() > poolCapacity_) {
+            poolStats_.evicted += pool.size() - poolCapacity_;
+            pool.resize(poolCapacity_);
+        }
+    }
+}
+
+size_t VehicleRegistry::pooled() const {
+    size_t count = 0;
+    for (const auto& pool : pools_) {
+        count += pool.size();
+    }
+    return count;
+}
+
+void VehicleRegistry::clearPool() {
+    for (auto& pool : pools_) {
+        pool.clear();
+    }
+}
+
+bool VehicleRegistry::contains(VehicleHandle handle) const {
+    return handle.index < slots_.size() && slots_[handle.index].alive && slots_[handle.index].generation == handle.generation;
+}
+
+PhysicsVehicle* VehicleRegistry::get(VehicleHandle handle) const {
+    return contains(handle) ? vehicles_[slots_[handle.index].data].get() : nullptr;
+}
+
+int VehicleRegistry::indexOf(VehicleHandle handle) const {
+    return contains(handle) ? static_cast<int>(slots_[handle.index].data) : -1;
+}
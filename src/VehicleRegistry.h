@@ -0,0 +1,118 @@
+#pragma once
+
+#include "PhysicsVehicle.h"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+// Stable reference to a registry vehicle. The generation changes every time a
+// slot is reused, so a handle to a despawned vehicle never resolves to its successor.
+struct VehicleHandle {
+    static constexpr uint32_t InvalidIndex = UINT32_MAX;
+
+    uint32_t index = InvalidIndex;
+    uint32_t generation = 0;
+
+    bool valid() const { return index != InvalidIndex; }
+    bool operator==(const VehicleHandle&) const = default;
+};
+
+struct VehiclePlacement {
+    VehicleType type = VehicleType::Kart;
+    JPH::RVec3 position = JPH::RVec3::sZero();
+    JPH::Quat rotation = JPH::Quat::sIdentity();
+};
+
+// Slot map of live vehicles. Vehicles are packed densely for iteration; spawn and
+// despawn are O(1), with despawn moving the last vehicle into the freed position.
+// Slot indices stay fixed for a handle's lifetime and can key per-vehicle side tables.
+//
+// Despawned vehicles are parked in a per-type pool with their body, constraint and
+// wheels still allocated but out of the simulation; spawning that type reuses one.
+class VehicleRegistry {
+public:
+    static constexpr int TypeCount = 5;
+
+    struct PoolStats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        // Despawns that did not fit in the pool and were destroyed.
+        uint64_t evicted = 0;
+
+        double hitRate() const { return hits + misses > 0 ? static_cast<double>(hits) / static_cast<double>(hits + misses) : 0.0; }
+    };
+
+    explicit VehicleRegistry(PhysicsWorld& world);
+    ~VehicleRegistry();
+
+    VehicleRegistry(const VehicleRegistry&) = delete;
+    VehicleRegistry& operator=(const VehicleRegistry&) = delete;
+
+    // Reuses a pooled vehicle of the same type and build settings when available.
+    VehicleHandle spawn(VehicleType type, const JPH::RVec3& position, const VehicleSettings* overrides = nullptr);
+    // Always builds a new vehicle around the given model.
+    VehicleHandle spawn(VehicleModel model, VehicleType type, const JPH::RVec3& position, const VehicleSettings* overrides = nullptr);
+    // Spawns every placement with default settings and adds all bodies in one
+    // broadphase batch. `models` is either empty, which reuses pooled vehicles like
+    // spawn() does, or holds one prebuilt model per placement, which always builds.
+    void spawnBatch(std::span<const VehiclePlacement> placements, std::span<VehicleModel> models,
+                    std::vector<VehicleHandle>& handles);
+    // Returns false if the handle is stale.
+    bool despawn(VehicleHandle handle);
+    void clear();
+
+    // Applies inputs[i] to the vehicle at dense index i. Vehicles are grouped by
+    // type (regrouped only after spawn/despawn) and each group is dispatched once.
+    void applyInputs(std::span<const VehicleInput> inputs);
+
+    void setPoolCapacity(size_t perType);
+    size_t poolCapacity() const { return poolCapacity_; }
+    size_t pooled(VehicleType type) const { return pools_[static_cast<int>(type)].size(); }
+    size_t pooled() const;
+    // Destroys every parked vehicle.
+    void clearPool();
+    const PoolStats& poolStats() const { return poolStats_; }
+
+    bool contains(VehicleHandle handle) const;
+    PhysicsVehicle* get(VehicleHandle handle) const;
+    // Dense position of a live vehicle, or -1.
+    int indexOf(VehicleHandle handle) const;
+    VehicleHandle handleAt(size_t index) const { return handles_[index]; }
+
+    PhysicsVehicle& operator[](size_t index) const { return *vehicles_[index]; }
+    size_t size() const { return vehicles_.size(); }
+    bool empty() const { return vehicles_.empty(); }
+    // Upper bound for slot indices, for sizing side tables.
+    size_t slotCount() const { return slots_.size(); }
+
+    auto begin() const { return vehicles_.begin(); }
+    auto end() const { return vehicles_.end(); }
+
+private:
+    struct Slot {
+        uint32_t generation = 0;
+        // Dense index while alive, next free slot otherwise.
+        uint32_t data = VehicleHandle::InvalidIndex;
+        bool alive = false;
+    };
+
+    VehicleHandle insert(std::unique_ptr<PhysicsVehicle> vehicle);
+    void rebuildTypeBatches();
+
+    PhysicsWorld& world_;
+    std::vector<Slot> slots_;
+    uint32_t freeList_ = VehicleHandle::InvalidIndex;
+    std::vector<std::unique_ptr<PhysicsVehicle>> vehicles_;
+    std::vector<VehicleHandle> handles_;
+    std::vector<std::unique_ptr<PhysicsVehicle>> pools_[TypeCount];
+    size_t poolCapacity_ = 64;
+    PoolStats poolStats_;
+
+    bool batchesDirty_ = true;
+    std::array<std::vector<PhysicsVehicle*>, TypeCount> typeVehicles_;
+    std::array<std::vector<uint32_t>, TypeCount> typeIndices_;
+    std::vector<VehicleInput> batchInputs_;
+};
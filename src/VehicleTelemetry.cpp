@@ -0,0 +1,153 @@
+#include "VehicleTelemetry.h"
+#include "PhysicsVehicle.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace {
+
+constexpr char cLogMagic[4] = {'V', 'T', 'E', 'L'};
+constexpr uint32_t cLogVersion = 2;
+
+template <typename T>
+void put(std::vector<uint8_t>& bytes, const T& value) {
+    const auto* p = reinterpret_cast<const uint8_t*>(&value);
+    bytes.insert(bytes.end(), p, p + sizeof(T));
+}
+
+size_t roundUpToPowerOfTwo(size_t value) {
+    size_t result = 1;
+    while (result < value) result <<= 1;
+    return result;
+}
+
+} // namespace
+
+VehicleTelemetry::VehicleTelemetry(size_t capacity)
+    : slots_(roundUpToPowerOfTwo(capacity)), mask_(slots_.size() - 1) {}
+
+VehicleTelemetry::~VehicleTelemetry() {
+    stopLogging();
+}
+
+void VehicleTelemetry::record(uint32_t tick, float time, uint16_t vehicle, uint16_t generation, const PhysicsVehicle& source) {
+    const uint64_t head = head_.load(std::memory_order_relaxed);
+    Slot& slot = slots_[head & mask_];
+    slot.sequence.store(2 * head + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    VehicleTelemetrySample& sample = slot.sample;
+    sample.tick = tick;
+    sample.time = time;
+    sample.vehicle = vehicle;
+    sample.generation = generation;
+    source.sampleTelemetry(sample);
+    slot.sequence.store(2 * head + 2, std::memory_order_release);
+    head_.store(head + 1, std::memory_order_release);
+}
+
+bool VehicleTelemetry::startLogging(const std::string& path) {
+    if (file_) return true;
+
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) return false;
+
+    std::fwrite(cLogMagic, 1, sizeof(cLogMagic), file_);
+    std::fwrite(&cLogVersion, sizeof(cLogVersion), 1, file_);
+
+    // Only log what is recorded from now on.
+    tail_ = head_.load(std::memory_order_acquire);
+    stopWriter_ = false;
+    writer_ = std::thread(&VehicleTelemetry::writerLoop, this);
+    return true;
+}
+
+void VehicleTelemetry::stopLogging() {
+    if (!file_) return;
+
+    stopWriter_ = true;
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+    std::fclose(file_);
+    file_ = nullptr;
+}
+
+void VehicleTelemetry::writerLoop() {
+    std::vector<uint8_t> bytes;
+    bytes.reserve(1 << 20);
+    while (true) {
+        const bool stopping = stopWriter_.load();
+        flush(bytes);
+        if (stopping) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+}
+
+void VehicleTelemetry::flush(std::vector<uint8_t>& bytes) {
+    const uint64_t capacity = slots_.size();
+    uint64_t head = head_.load(std::memory_order_acquire);
+    if (head - tail_ > capacity) {
+        dropped_ += head - tail_ - capacity;
+        tail_ = head - capacity;
+    }
+
+    bytes.clear();
+    uint64_t copied = 0;
+    for (uint64_t i = tail_; i < head; ++i) {
+        // Seqlock read: the copy only counts if the slot still holds sample i,
+        // complete, both before and after it was taken.
+        const Slot& slot = slots_[i & mask_];
+        const uint64_t expected = 2 * i + 2;
+        if (slot.sequence.load(std::memory_order_acquire) != expected) {
+            ++dropped_;
+            continue;
+        }
+        const VehicleTelemetrySample s = slot.sample;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != expected) {
+            ++dropped_;
+            continue;
+        }
+
+        put(bytes, s.tick);
+        put(bytes, s.vehicle);
+        put(bytes, s.generation);
+        put(bytes, s.type);
+        put(bytes, s.wheelCount);
+        put(bytes, s.time);
+        put(bytes, s.speed);
+        put(bytes, s.engineRpm);
+        put(bytes, s.gear);
+        for (int w = 0; w < s.wheelCount && w < VehicleTelemetrySample::MaxWheels; ++w) {
+            const WheelTelemetry& wheel = s.wheels[w];
+            put(bytes, wheel.suspensionLength);
+            put(bytes, wheel.longitudinalSlip);
+            put(bytes, wheel.lateralSlip);
+            put(bytes, wheel.angularVelocity);
+            put(bytes, static_cast<uint8_t>(wheel.contact));
+        }
+        ++copied;
+    }
+
+    if (!bytes.empty()) {
+        std::fwrite(bytes.data(), 1, bytes.size(), file_);
+        written_ += copied;
+    }
+    tail_ = head;
+}
+
+void VehicleTelemetry::history(uint16_t vehicle, uint16_t generation, size_t maxCount,
+                               std::vector<const VehicleTelemetrySample*>& out) const {
+    out.clear();
+    const uint64_t head = head_.load(std::memory_order_relaxed);
+    const uint64_t capacity = slots_.size();
+    const uint64_t oldest = head > capacity ? head - capacity : 0;
+    for (uint64_t i = head; i > oldest && out.size() < maxCount; --i) {
+        const VehicleTelemetrySample& sample = slots_[(i - 1) & mask_].sample;
+        if (sample.vehicle == vehicle && sample.generation == generation) {
+            out.push_back(&sample);
+        }
+    }
+    std::reverse(out.begin(), out.end());
+}
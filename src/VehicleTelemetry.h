@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+class PhysicsVehicle;
+
+struct WheelTelemetry {
+    float suspensionLength = 0.f;
+    float longitudinalSlip = 0.f;
+    float lateralSlip = 0.f;
+    float angularVelocity = 0.f;
+    bool contact = false;
+};
+
+struct VehicleTelemetrySample {
+    // Enough for the tank's two tracks of nine road wheels.
+    static constexpr int MaxWheels = 18;
+
+    uint32_t tick = 0;
+    // Registry slot and the low bits of its handle generation; together they
+    // tell a respawned vehicle apart from the one that held the slot before.
+    uint16_t vehicle = 0;
+    uint16_t generation = 0;
+    uint8_t type = 0;
+    uint8_t wheelCount = 0;
+    float time = 0.f;
+    float speed = 0.f;
+    float engineRpm = 0.f;
+    int8_t gear = 0;
+    WheelTelemetry wheels[MaxWheels];
+};
+
+// Preallocated single-producer ring of per-vehicle samples. The simulation thread
+// records every step without locks or allocation; an optional writer thread
+// drains it to a compact binary log, and the UI reads recent history in place.
+// Each slot carries a sequence number so the writer can tell a sample the
+// producer overwrote while it was being copied and drop it.
+class VehicleTelemetry {
+public:
+    explicit VehicleTelemetry(size_t capacity = 1 << 14);
+    ~VehicleTelemetry();
+
+    VehicleTelemetry(const VehicleTelemetry&) = delete;
+    VehicleTelemetry& operator=(const VehicleTelemetry&) = delete;
+
+    // Producer side; must always be called from the same thread.
+    void record(uint32_t tick, float time, uint16_t vehicle, uint16_t generation, const PhysicsVehicle& source);
+
+    bool startLogging(const std::string& path);
+    void stopLogging();
+    bool logging() const { return file_ != nullptr; }
+
+    // Collects up to `maxCount` of the most recent samples for one vehicle, oldest
+    // first. Only safe on the producer thread.
+    void history(uint16_t vehicle, uint16_t generation, size_t maxCount,
+                 std::vector<const VehicleTelemetrySample*>& out) const;
+
+    uint64_t recorded() const { return head_.load(std::memory_order_relaxed); }
+    uint64_t written() const { return written_.load(std::memory_order_relaxed); }
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    void writerLoop();
+    void flush(std::vector<uint8_t>& bytes);
+
+    struct Slot {
+        // 2 * index + 1 while sample `index` is being written, 2 * index + 2 once
+        // it is complete.
+        std::atomic<uint64_t> sequence{0};
+        VehicleTelemetrySample sample;
+    };
+
+    std::vector<Slot> slots_;
+    size_t mask_;
+    std::atomic<uint64_t> head_{0};
+    uint64_t tail_ = 0;
+
+    std::FILE* file_ = nullptr;
+    std::thread writer_;
+    std::atomic<bool> stopWriter_{false};
+    std::atomic<uint64_t> written_{0};
+    std::atomic<uint64_t> dropped_{0};
+};
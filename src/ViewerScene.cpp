@@ -0,0 +1,149 @@
+#include "ViewerScene.h"
+#include "StartupCache.h"
+#include "TestScene.h"
+
+#include <imgui.h>
+#include <algorithm>
+
+using namespace threepp;
+
+namespace {
+
+void applyTransform(Object3D& object, const TransformRing::Transform& transform) {
+    object.position.set(transform.position[0], transform.position[1], transform.position[2]);
+    object.quaternion.set(transform.rotation[0], transform.rotation[1], transform.rotation[2], transform.rotation[3]);
+}
+
+} // namespace
+
+ViewerScene createViewerScene(Canvas& canvas, std::unique_ptr<TransformRing> ring) {
+    // Models and ground decode from the simulation's cache if it wrote one. The
+    // viewer never bakes, since that needs the Jolt runtime.
+    StartupCache::setActive(StartupCache::open(StartupCache::DefaultPath));
+
+    ViewerScene viewer;
+    viewer.ring = std::move(ring);
+    viewer.scene = Scene::create();
+    viewer.camera = PerspectiveCamera::create(60, canvas.aspect(), 0.1f, 200);
+    viewer.camera->position.set(10, 8, 12);
+
+    viewer.controls = std::make_unique<OrbitControls>(*viewer.camera, canvas);
+    viewer.controls->target.set(0, 1, 0);
+    viewer.controls->update();
+
+    auto hemi = HemisphereLight::create(Color::white, Color::gray, 0.9f);
+    viewer.scene->add(hemi);
+    viewer.shadows = std::make_unique<ShadowRig>(*viewer.scene, Vector3(20, 25, 20));
+
+    viewer.ground = createGround();
+    viewer.scene->add(viewer.ground);
+    return viewer;
+}
+
+void ViewerScene::update() {
+    uint64_t sequence = 0;
+    const TransformRing::Frame* frame = ring->latest(sequence);
+    if (!frame) return;
+    const uint64_t published = frame->index + 1;
+    if (published == lastPublished) return;
+
+    // Copy the frame out of shared memory and only apply it once validate() shows
+    // the writer did not lap the ring meanwhile; a torn copy is dropped and the
+    // next update reads a newer frame.
+    const uint32_t count = std::min(frame->vehicleCount, ring->maxVehicles());
+    records.assign(frame->vehicles(), frame->vehicles() + count);
+    const uint64_t tick = frame->tick;
+    const double simTime = frame->simTime;
+    const double frameOriginX = frame->originX;
+    const double frameOriginZ = frame->originZ;
+    const uint32_t activeSlot = frame->activeSlot;
+    if (!ring->validate(*frame, sequence)) {
+        ++tornReads;
+        return;
+    }
+
+    if (lastPublished > 0 && published > lastPublished + 1) {
+        framesSkipped += published - lastPublished - 1;
+    }
+    lastPublished = published;
+    shownTick = tick;
+    shownSimTime = simTime;
+    shownVehicles = count;
+    ++framesShown;
+
+    for (const TransformRing::Vehicle& record : records) {
+        if (record.slot >= ring->maxVehicles() || record.type >= VehicleRegistry::TypeCount) continue;
+        if (entries.size() <= record.slot) entries.resize(record.slot + 1);
+
+        Entry& entry = entries[record.slot];
+        const auto type = static_cast<VehicleType>(record.type);
+        if (!entry.present || entry.generation != record.generation || entry.model.type != type) {
+            if (entry.present) scene->remove(*entry.model.group);
+            entry.model = VehicleFactory::create(type);
+            entry.generation = record.generation;
+            entry.present = true;
+            scene->add(entry.model.group);
+            shadows->markDirty();
+        }
+        applyTransform(*entry.model.group, record.body);
+        const size_t wheels = std::min<size_t>(record.wheelCount, entry.model.wheels.size());
+        for (size_t w = 0; w < wheels; ++w) {
+            applyTransform(*entry.model.wheels[w], record.wheels[w]);
+        }
+        entry.seenFrame = published;
+    }
+
+    for (Entry& entry : entries) {
+        if (entry.present && entry.seenFrame != published) {
+            scene->remove(*entry.model.group);
+            entry.model = {};
+            entry.present = false;
+            shadows->markDirty();
+        }
+    }
+
+    // Follow the simulation's floating origin like its own scene does.
+    if (frameOriginX != originX || frameOriginZ != originZ) {
+        const Vector3 offset(static_cast<float>(frameOriginX - originX), 0.f, static_cast<float>(frameOriginZ - originZ));
+        ground->position.sub(offset);
+        camera->position.sub(offset);
+        controls->target.sub(offset);
+        controls->update();
+        originX = frameOriginX;
+        originZ = frameOriginZ;
+    }
+
+    if (followActive && activeSlot < entries.size() && entries[activeSlot].present) {
+        const Vector3 target = entries[activeSlot].model.group->position;
+        camera->position.add(target - controls->target);
+        controls->target.copy(target);
+        controls->update();
+    }
+
+    // A new frame moves every vehicle, but only those in the shadow frustum matter.
+    bool castersMoved = false;
+    for (Entry& entry : entries) {
+        if (!entry.present) continue;
+        const float distance = entry.model.group->position.distanceTo(camera->position);
+        VehicleFactory::setLod(entry.model, VehicleFactory::selectLod(entry.model, distance), vehicleLods);
+        castersMoved = castersMoved || shadows->covers(entry.model.group->position, ShadowRig::VehicleCasterRadius);
+    }
+    if (castersMoved) shadows->casterMoved();
+    shadows->update(controls->target);
+}
+
+void ViewerScene::drawUi() {
+    ImGui::Begin("Viewer");
+    ImGui::Text("Ring %s, up to %u vehicles", ring->name().c_str(), ring->maxVehicles());
+    ImGui::Text("Tick %llu, %.1f s, %u vehicles", static_cast<unsigned long long>(shownTick), shownSimTime, shownVehicles);
+    ImGui::Text("Frames shown %llu, skipped %llu, torn reads %llu", static_cast<unsigned long long>(framesShown),
+                static_cast<unsigned long long>(framesSkipped), static_cast<unsigned long long>(tornReads));
+    ImGui::Checkbox("Follow driven vehicle", &followActive);
+    ImGui::End();
+}
+
+void ViewerScene::onResize(WindowSize size, GLRenderer& renderer) {
+    camera->aspect = size.aspect();
+    camera->updateProjectionMatrix();
+    renderer.setSize(size);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "threepp/threepp.hpp"
+#include "ShadowRig.h"
+#include "TransformRing.h"
+#include "VehicleFactory.h"
+#include <memory>
+#include <vector>
+
+// Read-only view of a simulation publishing into a TransformRing. Runs no
+// physics: every frame it copies the newest published frame out of shared memory
+// and applies it to its own models once the copy is known to be consistent.
+struct ViewerScene {
+    std::shared_ptr<threepp::Scene> scene;
+    std::shared_ptr<threepp::PerspectiveCamera> camera;
+    std::unique_ptr<threepp::OrbitControls> controls;
+    std::shared_ptr<threepp::Group> ground;
+    std::unique_ptr<ShadowRig> shadows;
+    std::unique_ptr<TransformRing> ring;
+
+    // Indexed by registry slot of the publishing simulation.
+    struct Entry {
+        VehicleModel model;
+        uint32_t generation = 0;
+        // Published count of the last frame that contained the vehicle.
+        uint64_t seenFrame = 0;
+        bool present = false;
+    };
+    std::vector<Entry> entries;
+    // Records of the frame being applied, copied out of the ring.
+    std::vector<TransformRing::Vehicle> records;
+    // Per-type merged and proxy LOD meshes shared by every model.
+    VehicleLodAssets vehicleLods;
+    bool followActive = true;
+    double originX = 0.0;
+    double originZ = 0.0;
+
+    uint64_t shownTick = 0;
+    double shownSimTime = 0.0;
+    uint32_t shownVehicles = 0;
+    uint64_t framesShown = 0;
+    // Frames published between two shown ones, e.g. while the viewer renders slower.
+    uint64_t framesSkipped = 0;
+    // Copies the writer overtook; they are dropped and a newer frame is read next update.
+    uint64_t tornReads = 0;
+    uint64_t lastPublished = 0;
+
+    void update();
+    void drawUi();
+    void onResize(threepp::WindowSize size, threepp::GLRenderer& renderer);
+};
+
+ViewerScene createViewerScene(threepp::Canvas& canvas, std::unique_ptr<TransformRing> ring);
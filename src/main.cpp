@@ -1,16 +1,76 @@
 #include "threepp/threepp.hpp"
 #include "ImguiContextCompat.hpp"
 #include "TestScene.h"
+#include "ViewerScene.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
 using namespace threepp;
 
-int main() {
+namespace {
+
+// Renders a simulation running in another process from its transform ring.
+int runViewer(const char* ringName) {
+    auto ring = TransformRing::attach(ringName);
+    if (!ring) {
+        std::fprintf(stderr, "error: no transform ring '%s'; start VehicleDemo --publish %s first\n", ringName, ringName);
+        return 1;
+    }
+
+    Canvas canvas("Vehicle Demo Viewer");
+    GLRenderer renderer{canvas.size()};
+    renderer.shadowMap().enabled = true;
+    renderer.shadowMap().type = ShadowMap::PFCSoft;
+    renderer.shadowMap().autoUpdate = false;
+    auto viewer = createViewerScene(canvas, std::move(ring));
+    ImguiFunctionalContextCompat ui{canvas, [&]() {
+        viewer.drawUi();
+    }};
+    canvas.onWindowResize([&](WindowSize size) {
+        viewer.onResize(size, renderer);
+    });
+
+    canvas.animate([&]() {
+        viewer.update();
+
+        renderer.shadowMap().needsUpdate = viewer.shadows->consumeDirty();
+        renderer.render(*viewer.scene, *viewer.camera);
+        ui.render();
+    });
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+
+    // --vehicles N adds N traffic vehicles to the startup scene.
+    // --publish NAME writes every step's transforms to the shared-memory ring NAME.
+    // --view NAME runs no simulation and renders the one publishing to NAME.
+    int trafficVehicles = 0;
+    const char* publishRing = nullptr;
+    const char* viewRing = nullptr;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::strcmp(argv[i], "--vehicles") == 0) trafficVehicles = std::max(0, std::atoi(argv[i + 1]));
+        if (std::strcmp(argv[i], "--publish") == 0) publishRing = argv[i + 1];
+        if (std::strcmp(argv[i], "--view") == 0) viewRing = argv[i + 1];
+    }
+    if (viewRing) return runViewer(viewRing);
 
     Canvas canvas("Vehicle Demo");
     GLRenderer renderer{canvas.size()};
     renderer.shadowMap().enabled = true;
     renderer.shadowMap().type = ShadowMap::PFCSoft;
-    auto testScene = createTestScene(canvas);
+    // The scene decides when the shadow map is stale; see ShadowRig.
+    renderer.shadowMap().autoUpdate = false;
+    auto testScene = createTestScene(canvas, trafficVehicles);
+    if (publishRing) {
+        testScene.transformRing = TransformRing::create(publishRing);
+        if (!testScene.transformRing) std::fprintf(stderr, "warning: not publishing transforms\n");
+    }
     ImguiFunctionalContextCompat ui{canvas, [&]() {
         testScene.drawUi();
     }};
@@ -25,6 +85,7 @@ int main() {
         float dt = clock.getDelta();
         testScene.update(dt);
 
+        renderer.shadowMap().needsUpdate = testScene.shadows->consumeDirty();
         renderer.render(*testScene.scene, *testScene.camera);
         ui.render();
     });